@@ -0,0 +1,285 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+        2016 — Bill Robinson <airbaggins@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "CasterBvh.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <utility>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/SceneGraph/MatrixTransformation3D.h>
+#include <Magnum/SceneGraph/Scene.h>
+
+#include "Types.h"
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+/* Enough for any tree that can be indexed with 32-bit integers, as the stack
+   never holds more than one node per level */
+constexpr std::size_t MaxDepth = 64;
+
+}
+
+void CasterBvh::build(const Containers::ArrayView<const Vector3> centers, const Containers::ArrayView<const Float> radii, const Containers::ArrayView<const UnsignedInt> ids) {
+    CORRADE_INTERNAL_ASSERT(centers.size() == radii.size() && centers.size() == ids.size());
+
+    _spheres.clear();
+    _nodes.clear();
+    _spheres.reserve(centers.size());
+    for(std::size_t i = 0; i != centers.size(); ++i)
+        _spheres.push_back({centers[i], radii[i], ids[i]});
+    if(_spheres.empty()) return;
+
+    /* Leaves are at least half full, so there's at most this many nodes */
+    _nodes.reserve(4*_spheres.size()/LeafSize + 1);
+    buildNode(0, _spheres.size());
+}
+
+void CasterBvh::buildNode(const UnsignedInt first, const UnsignedInt count) {
+    /* Bounds of the whole spheres for culling, bounds of just the centers for
+       deciding where to split */
+    Range3D bounds{_spheres[first].center, _spheres[first].center};
+    Range3D centerBounds = bounds;
+    for(UnsignedInt i = first; i != first + count; ++i) {
+        const Sphere& sphere = _spheres[i];
+        bounds.min() = Math::min(bounds.min(), sphere.center - Vector3{sphere.radius});
+        bounds.max() = Math::max(bounds.max(), sphere.center + Vector3{sphere.radius});
+        centerBounds.min() = Math::min(centerBounds.min(), sphere.center);
+        centerBounds.max() = Math::max(centerBounds.max(), sphere.center);
+    }
+
+    const UnsignedInt index = _nodes.size();
+    _nodes.push_back({bounds, first, count, 0});
+    if(count <= LeafSize) return;
+
+    const Vector3 size = centerBounds.size();
+    const std::size_t axis = size.x() >= size.y() && size.x() >= size.z() ? 0 :
+        size.y() >= size.z() ? 1 : 2;
+    const UnsignedInt half = count/2;
+    std::nth_element(_spheres.begin() + first, _spheres.begin() + first + half, _spheres.begin() + first + count, [axis](const Sphere& a, const Sphere& b) {
+        return a.center[axis] < b.center[axis];
+    });
+
+    /* The first child goes right after this node, the second after the whole
+       subtree of the first. Don't hold a reference to the node across the
+       recursion, the array gets reallocated. */
+    buildNode(first, half);
+    _nodes[index].secondChild = _nodes.size();
+    buildNode(first + half, count - half);
+}
+
+void CasterBvh::query(const Containers::ArrayView<const Vector4> planes, std::vector<UnsignedInt>& out) const {
+    CORRADE_INTERNAL_ASSERT(planes.size() <= 32);
+    if(_nodes.empty()) return;
+
+    /* Absolute normals project half-size of a box onto the plane normal */
+    Vector3 absoluteNormals[32];
+    for(std::size_t i = 0; i != planes.size(); ++i)
+        absoluteNormals[i] = Math::abs(planes[i].xyz());
+
+    /* Nodes to visit together with a mask of planes they still have to be
+       tested against */
+    std::pair<UnsignedInt, UnsignedInt> stack[MaxDepth];
+    std::size_t stackSize = 0;
+    stack[stackSize++] = {0, planes.size() == 32 ? ~UnsignedInt{} : (1u << planes.size()) - 1};
+    while(stackSize) {
+        --stackSize;
+        const UnsignedInt nodeIndex = stack[stackSize].first;
+        UnsignedInt mask = stack[stackSize].second;
+        const Node& node = _nodes[nodeIndex];
+
+        const Vector3 center = node.bounds.center();
+        const Vector3 halfSize = node.bounds.size()*0.5f;
+        bool outside = false;
+        for(std::size_t i = 0; i != planes.size(); ++i) {
+            if(!(mask & (1u << i))) continue;
+
+            const Float distance = Math::dot(planes[i].xyz(), center) + planes[i].w();
+            const Float extent = Math::dot(absoluteNormals[i], halfSize);
+            if(distance + extent < 0.0f) {
+                outside = true;
+                break;
+            }
+            if(distance - extent >= 0.0f) mask &= ~(1u << i);
+        }
+        if(outside) continue;
+
+        /* Fully inside all planes, take the whole subtree */
+        if(!mask) {
+            for(UnsignedInt i = node.first; i != node.first + node.count; ++i)
+                out.push_back(_spheres[i].id);
+            continue;
+        }
+
+        if(!node.secondChild) {
+            for(UnsignedInt i = node.first; i != node.first + node.count; ++i) {
+                const Sphere& sphere = _spheres[i];
+                const Vector4 sphereCenter{sphere.center, 1.0f};
+                bool visible = true;
+                for(std::size_t j = 0; j != planes.size(); ++j) {
+                    if((mask & (1u << j)) && Math::dot(planes[j], sphereCenter) < -sphere.radius) {
+                        visible = false;
+                        break;
+                    }
+                }
+                if(visible) out.push_back(sphere.id);
+            }
+            continue;
+        }
+
+        CORRADE_INTERNAL_ASSERT(stackSize + 2 <= MaxDepth);
+        stack[stackSize++] = {node.secondChild, mask};
+        stack[stackSize++] = {nodeIndex + 1, mask};
+    }
+}
+
+void benchmarkCasterBvh() {
+    std::mt19937 random;
+    std::uniform_real_distribution<Float> unit{0.0f, 1.0f};
+
+    /* Three cascades of growing size in front of a camera at the origin,
+       with the light shining diagonally from above */
+    constexpr std::size_t CascadeCount = 3;
+    const Float cascadeSizes[CascadeCount]{10.0f, 30.0f, 100.0f};
+    const Vector3 lightDirection = Vector3{-3.0f, -2.0f, -3.0f}.normalized();
+    Matrix4 cameraMatrices[CascadeCount];
+    Vector4 planes[CascadeCount][5];
+    Vector4 worldPlanes[CascadeCount][5];
+    for(std::size_t i = 0; i != CascadeCount; ++i) {
+        const Vector3 center = Vector3::zAxis(-cascadeSizes[i]*0.5f);
+        cameraMatrices[i] = Matrix4::lookAt(center - lightDirection*100.0f, center, Vector3::yAxis()).invertedRigid();
+
+        /* What ShadowLight::calculateClipPlanes() gives for an orthographic
+           projection 200 units deep, without the near plane */
+        const Float halfSize = cascadeSizes[i]*0.5f;
+        planes[i][0] = {0.0f, 0.0f, 1.0f, 200.0f};
+        planes[i][1] = {1.0f, 0.0f, 0.0f, halfSize};
+        planes[i][2] = {-1.0f, 0.0f, 0.0f, halfSize};
+        planes[i][3] = {0.0f, 1.0f, 0.0f, halfSize};
+        planes[i][4] = {0.0f, -1.0f, 0.0f, halfSize};
+        for(std::size_t j = 0; j != 5; ++j)
+            worldPlanes[i][j] = cameraMatrices[i].transposed()*planes[i][j];
+    }
+
+    /* Average time of given operation in milliseconds */
+    constexpr UnsignedInt Iterations = 10;
+    auto measure = [](const std::function<void()>& operation) {
+        const auto start = std::chrono::steady_clock::now();
+        for(UnsignedInt i = 0; i != Iterations; ++i) operation();
+        return std::chrono::duration<Double, std::milli>(std::chrono::steady_clock::now() - start).count()/Iterations;
+    };
+
+    for(const UnsignedInt count: {200u, 2000u, 20000u, 200000u, 1000000u}) {
+        /* Same density as the 200 casters over 100x100 units in the
+           example, so the cascades see roughly the same amount of them */
+        const Float side = 100.0f*std::sqrt(count/200.0f);
+        Scene3D scene;
+        std::vector<std::reference_wrapper<Object3D>> objects;
+        std::vector<Float> radii;
+        objects.reserve(count);
+        radii.reserve(count);
+        for(UnsignedInt i = 0; i != count; ++i) {
+            auto* object = new Object3D{&scene};
+            object->setTransformation(Matrix4::translation({
+                (unit(random) - 0.5f)*side,
+                unit(random)*5.0f,
+                (unit(random) - 0.5f)*side}));
+            objects.push_back(*object);
+            radii.push_back(0.5f + unit(random)*1.5f);
+        }
+
+        /* The linear scan as ShadowLight::render() did it, with camera-relative
+           transformations of everything for every cascade */
+        std::size_t linearHitCount = 0;
+        const Double linearTime = measure([&]{
+            linearHitCount = 0;
+            for(std::size_t cascade = 0; cascade != CascadeCount; ++cascade) {
+                const std::vector<Matrix4> transformations = scene.transformationMatrices(objects, cameraMatrices[cascade]);
+                for(std::size_t i = 0; i != count; ++i) {
+                    const Vector4 center{transformations[i].translation(), 1.0f};
+                    bool visible = true;
+                    for(const Vector4& plane: planes[cascade]) {
+                        if(Math::dot(plane, center) < -radii[i]) {
+                            visible = false;
+                            break;
+                        }
+                    }
+                    if(visible) ++linearHitCount;
+                }
+            }
+        });
+
+        /* Building needs absolute transformations of everything, but that's
+           needed only when static casters move */
+        CasterBvh bvh;
+        const Double buildTime = measure([&]{
+            const std::vector<Matrix4> transformations = scene.transformationMatrices(objects);
+            std::vector<Vector3> centers(count);
+            std::vector<UnsignedInt> ids(count);
+            for(UnsignedInt i = 0; i != count; ++i) {
+                centers[i] = transformations[i].translation();
+                ids[i] = i;
+            }
+            bvh.build(Containers::arrayView(centers.data(), centers.size()),
+                Containers::arrayView(radii.data(), radii.size()),
+                Containers::arrayView(ids.data(), ids.size()));
+        });
+
+        /* Query, then transformations only for the hits */
+        std::size_t bvhHitCount = 0;
+        std::vector<UnsignedInt> hits;
+        std::vector<std::reference_wrapper<Object3D>> hitObjects;
+        const Double queryTime = measure([&]{
+            bvhHitCount = 0;
+            for(std::size_t cascade = 0; cascade != CascadeCount; ++cascade) {
+                hits.clear();
+                bvh.query(worldPlanes[cascade], hits);
+                hitObjects.clear();
+                for(const UnsignedInt id: hits) hitObjects.push_back(objects[id]);
+                bvhHitCount += scene.transformationMatrices(hitObjects, cameraMatrices[cascade]).size();
+            }
+        });
+
+        Debug{} << "Culling" << count << "casters in" << CascadeCount << "cascades:";
+        Debug{} << "  linear scan:" << linearTime << "ms," << linearHitCount << "visible";
+        Debug{} << "  hierarchy:" << queryTime << "ms," << bvhHitCount << "visible";
+        Debug{} << "  building" << bvh.nodeCount() << "nodes:" << buildTime << "ms";
+    }
+}
+
+}}
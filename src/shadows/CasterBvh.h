@@ -0,0 +1,118 @@
+#ifndef Magnum_Examples_CasterBvh_h
+#define Magnum_Examples_CasterBvh_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+        2016 — Bill Robinson <airbaggins@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/Math/Vector4.h>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Bounding volume hierarchy over shadow caster bounding spheres
+
+Built top-down by sorting the spheres along the longest axis of their centers
+and splitting them at the median, until there's at most @ref LeafSize spheres
+in a node. Nodes are stored depth-first in a flat array so the first child of
+a node directly follows it, and spheres are reordered so each node covers a
+contiguous range of them.
+*/
+class CasterBvh {
+    public:
+        enum: UnsignedInt {
+            LeafSize = 4    /**< Max sphere count in a leaf node */
+        };
+
+        /**
+         * @brief Rebuild the hierarchy
+         * @param centers   World-space sphere centers
+         * @param radii     Sphere radii
+         * @param ids       IDs returned from @ref query() for each sphere
+         *
+         * All views are expected to have the same size.
+         */
+        void build(Containers::ArrayView<const Vector3> centers, Containers::ArrayView<const Float> radii, Containers::ArrayView<const UnsignedInt> ids);
+
+        /**
+         * @brief Query spheres not fully outside of given planes
+         *
+         * The planes are in world space with normalized normals pointing
+         * inside. A sphere is rejected if its center is further than its
+         * radius on the negative side of any plane, which is the same test
+         * @ref ShadowLight does. Node bounds fully on the positive side of a
+         * plane aren't tested against it anymore and once there's no plane
+         * left, the whole subtree is accepted without looking at the spheres.
+         * Appends IDs of the spheres that passed to @p out, in no particular
+         * order. Expects at most 32 planes.
+         */
+        void query(Containers::ArrayView<const Vector4> planes, std::vector<UnsignedInt>& out) const;
+
+        /** @brief Sphere count */
+        std::size_t size() const { return _spheres.size(); }
+
+        /** @brief Node count */
+        std::size_t nodeCount() const { return _nodes.size(); }
+
+    private:
+        struct Sphere {
+            Vector3 center;
+            Float radius;
+            UnsignedInt id;
+        };
+
+        /* A leaf if secondChild is zero, as the root can't be a child */
+        struct Node {
+            Range3D bounds;
+            UnsignedInt first, count;
+            UnsignedInt secondChild;
+        };
+
+        void buildNode(UnsignedInt first, UnsignedInt count);
+
+        std::vector<Sphere> _spheres;
+        std::vector<Node> _nodes;
+};
+
+/**
+@brief Benchmark shadow caster culling
+
+Scatters from 200 up to a million casters over a plane at a constant density,
+and prints how long it takes to find the ones visible in three cascades of
+fixed size, once with a linear scan over absolute transformations of all
+objects and once by querying a @ref CasterBvh and fetching transformations
+only for the hits, together with the time needed to build the hierarchy.
+*/
+void benchmarkCasterBvh();
+
+}}
+
+#endif
@@ -0,0 +1,330 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+        2016 — Bill Robinson <airbaggins@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "FrustumCulling.h"
+
+#include <chrono>
+#include <functional>
+#include <random>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/Math/Constants.h>
+#include <Magnum/Math/Angle.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MAGNUM_EXAMPLES_FRUSTUMCULLING_X86
+#endif
+
+namespace Magnum { namespace Examples {
+
+using namespace Math::Literals;
+
+void CullingSpheres::clear() {
+    _x.clear();
+    _y.clear();
+    _z.clear();
+    _radius.clear();
+    _size = 0;
+}
+
+void CullingSpheres::add(const Vector3& center, const Float radius) {
+    if(_size == _x.size()) {
+        _x.resize(_size + BatchSize, 0.0f);
+        _y.resize(_size + BatchSize, 0.0f);
+        _z.resize(_size + BatchSize, 0.0f);
+        _radius.resize(_size + BatchSize, -Constants::inf());
+    }
+
+    _x[_size] = center.x();
+    _y[_size] = center.y();
+    _z[_size] = center.z();
+    _radius[_size] = radius;
+    ++_size;
+}
+
+namespace {
+
+/* All kernels calculate the distance with the same operations in the same
+   order and without FMA, so they give exactly the same result */
+
+std::size_t cullScalar(const CullingSpheres& spheres, const Vector4* const planes, const std::size_t planeCount, UnsignedInt* const out) {
+    std::size_t count = 0;
+    for(std::size_t i = 0; i != spheres.size(); ++i) {
+        bool visible = true;
+        for(std::size_t j = 0; j != planeCount; ++j) {
+            const Vector4& plane = planes[j];
+            const Float distance = plane.x()*spheres.x()[i] + plane.y()*spheres.y()[i] + plane.z()*spheres.z()[i] + plane.w();
+            if(distance < -spheres.radius()[i]) {
+                visible = false;
+                break;
+            }
+        }
+        if(visible) out[count++] = UnsignedInt(i);
+    }
+    return count;
+}
+
+#ifdef MAGNUM_EXAMPLES_FRUSTUMCULLING_X86
+__attribute__((target("sse2"))) std::size_t cullSse2(const CullingSpheres& spheres, const Vector4* const planes, const std::size_t planeCount, UnsignedInt* const out) {
+    __m128 planeX[MaxCullingPlaneCount], planeY[MaxCullingPlaneCount], planeZ[MaxCullingPlaneCount], planeW[MaxCullingPlaneCount];
+    for(std::size_t j = 0; j != planeCount; ++j) {
+        planeX[j] = _mm_set1_ps(planes[j].x());
+        planeY[j] = _mm_set1_ps(planes[j].y());
+        planeZ[j] = _mm_set1_ps(planes[j].z());
+        planeW[j] = _mm_set1_ps(planes[j].w());
+    }
+
+    std::size_t count = 0;
+    for(std::size_t i = 0; i != spheres.paddedSize(); i += 4) {
+        const __m128 x = _mm_loadu_ps(spheres.x() + i);
+        const __m128 y = _mm_loadu_ps(spheres.y() + i);
+        const __m128 z = _mm_loadu_ps(spheres.z() + i);
+        const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres.radius() + i));
+
+        __m128 outside = _mm_setzero_ps();
+        for(std::size_t j = 0; j != planeCount; ++j) {
+            const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(planeX[j], x),
+                _mm_mul_ps(planeY[j], y)),
+                _mm_mul_ps(planeZ[j], z)),
+                planeW[j]);
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+        }
+
+        /* Append indices of the lanes that are inside */
+        UnsignedInt mask = ~_mm_movemask_ps(outside) & 0xf;
+        while(mask) {
+            out[count++] = UnsignedInt(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    return count;
+}
+
+__attribute__((target("avx2"))) std::size_t cullAvx2(const CullingSpheres& spheres, const Vector4* const planes, const std::size_t planeCount, UnsignedInt* const out) {
+    __m256 planeX[MaxCullingPlaneCount], planeY[MaxCullingPlaneCount], planeZ[MaxCullingPlaneCount], planeW[MaxCullingPlaneCount];
+    for(std::size_t j = 0; j != planeCount; ++j) {
+        planeX[j] = _mm256_set1_ps(planes[j].x());
+        planeY[j] = _mm256_set1_ps(planes[j].y());
+        planeZ[j] = _mm256_set1_ps(planes[j].z());
+        planeW[j] = _mm256_set1_ps(planes[j].w());
+    }
+
+    std::size_t count = 0;
+    for(std::size_t i = 0; i != spheres.paddedSize(); i += 8) {
+        const __m256 x = _mm256_loadu_ps(spheres.x() + i);
+        const __m256 y = _mm256_loadu_ps(spheres.y() + i);
+        const __m256 z = _mm256_loadu_ps(spheres.z() + i);
+        const __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(spheres.radius() + i));
+
+        __m256 outside = _mm256_setzero_ps();
+        for(std::size_t j = 0; j != planeCount; ++j) {
+            const __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+                _mm256_mul_ps(planeX[j], x),
+                _mm256_mul_ps(planeY[j], y)),
+                _mm256_mul_ps(planeZ[j], z)),
+                planeW[j]);
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, negativeRadius, _CMP_LT_OQ));
+        }
+
+        UnsignedInt mask = ~_mm256_movemask_ps(outside) & 0xff;
+        while(mask) {
+            out[count++] = UnsignedInt(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    return count;
+}
+
+__attribute__((target("avx512f"))) std::size_t cullAvx512(const CullingSpheres& spheres, const Vector4* const planes, const std::size_t planeCount, UnsignedInt* const out) {
+    __m512 planeX[MaxCullingPlaneCount], planeY[MaxCullingPlaneCount], planeZ[MaxCullingPlaneCount], planeW[MaxCullingPlaneCount];
+    for(std::size_t j = 0; j != planeCount; ++j) {
+        planeX[j] = _mm512_set1_ps(planes[j].x());
+        planeY[j] = _mm512_set1_ps(planes[j].y());
+        planeZ[j] = _mm512_set1_ps(planes[j].z());
+        planeW[j] = _mm512_set1_ps(planes[j].w());
+    }
+
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    std::size_t count = 0;
+    for(std::size_t i = 0; i != spheres.paddedSize(); i += 16) {
+        const __m512 x = _mm512_loadu_ps(spheres.x() + i);
+        const __m512 y = _mm512_loadu_ps(spheres.y() + i);
+        const __m512 z = _mm512_loadu_ps(spheres.z() + i);
+        const __m512 negativeRadius = _mm512_sub_ps(_mm512_setzero_ps(), _mm512_loadu_ps(spheres.radius() + i));
+
+        __mmask16 outside = 0;
+        for(std::size_t j = 0; j != planeCount; ++j) {
+            const __m512 distance = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(
+                _mm512_mul_ps(planeX[j], x),
+                _mm512_mul_ps(planeY[j], y)),
+                _mm512_mul_ps(planeZ[j], z)),
+                planeW[j]);
+            outside |= _mm512_cmp_ps_mask(distance, negativeRadius, _CMP_LT_OQ);
+        }
+
+        /* Compress the indices of lanes that are inside directly to the
+           output */
+        const __mmask16 inside = __mmask16(~outside);
+        _mm512_mask_compressstoreu_epi32(out + count, inside, _mm512_add_epi32(_mm512_set1_epi32(Int(i)), lanes));
+        count += __builtin_popcount(inside);
+    }
+    return count;
+}
+#endif
+
+}
+
+const char* cullingKernelName(const CullingKernel kernel) {
+    switch(kernel) {
+        case CullingKernel::Scalar: return "scalar";
+        case CullingKernel::Sse2: return "SSE2";
+        case CullingKernel::Avx2: return "AVX2";
+        case CullingKernel::Avx512: return "AVX-512";
+    }
+
+    CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+}
+
+bool isCullingKernelSupported(const CullingKernel kernel) {
+    switch(kernel) {
+        case CullingKernel::Scalar: return true;
+        #ifdef MAGNUM_EXAMPLES_FRUSTUMCULLING_X86
+        case CullingKernel::Sse2: return __builtin_cpu_supports("sse2");
+        case CullingKernel::Avx2: return __builtin_cpu_supports("avx2");
+        case CullingKernel::Avx512: return __builtin_cpu_supports("avx512f");
+        #else
+        case CullingKernel::Sse2:
+        case CullingKernel::Avx2:
+        case CullingKernel::Avx512: return false;
+        #endif
+    }
+
+    CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+}
+
+CullingKernel bestCullingKernel() {
+    static const CullingKernel best = []{
+        for(const CullingKernel kernel: {CullingKernel::Avx512, CullingKernel::Avx2, CullingKernel::Sse2})
+            if(isCullingKernelSupported(kernel)) return kernel;
+        return CullingKernel::Scalar;
+    }();
+    return best;
+}
+
+void cullSpheres(const CullingSpheres& spheres, const Containers::ArrayView<const Vector4> planes, std::vector<UnsignedInt>& out, const CullingKernel kernel) {
+    CORRADE_INTERNAL_ASSERT(planes.size() <= MaxCullingPlaneCount);
+    CORRADE_INTERNAL_ASSERT(isCullingKernelSupported(kernel));
+
+    /* The SIMD kernels write whole batches */
+    out.resize(spheres.paddedSize());
+    std::size_t count{};
+    switch(kernel) {
+        case CullingKernel::Scalar:
+            count = cullScalar(spheres, planes.data(), planes.size(), out.data());
+            break;
+        #ifdef MAGNUM_EXAMPLES_FRUSTUMCULLING_X86
+        case CullingKernel::Sse2:
+            count = cullSse2(spheres, planes.data(), planes.size(), out.data());
+            break;
+        case CullingKernel::Avx2:
+            count = cullAvx2(spheres, planes.data(), planes.size(), out.data());
+            break;
+        case CullingKernel::Avx512:
+            count = cullAvx512(spheres, planes.data(), planes.size(), out.data());
+            break;
+        #else
+        default: CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+        #endif
+    }
+
+    /* The padding is outside of any plane, but with no planes at all it
+       passes as well */
+    while(count && out[count - 1] >= spheres.size()) --count;
+    out.resize(count);
+}
+
+std::vector<Vector4> frustumPlanes(const Matrix4& projectionMatrix) {
+    const Matrix4& pm = projectionMatrix;
+    std::vector<Vector4> planes{
+        {pm[3][0] + pm[2][0], pm[3][1] + pm[2][1], pm[3][2] + pm[2][2], pm[3][3] + pm[2][3]},   /* near */
+        {pm[3][0] - pm[2][0], pm[3][1] - pm[2][1], pm[3][2] - pm[2][2], pm[3][3] - pm[2][3]},   /* far */
+        {pm[3][0] + pm[0][0], pm[3][1] + pm[0][1], pm[3][2] + pm[0][2], pm[3][3] + pm[0][3]},   /* left */
+        {pm[3][0] - pm[0][0], pm[3][1] - pm[0][1], pm[3][2] - pm[0][2], pm[3][3] - pm[0][3]},   /* right */
+        {pm[3][0] + pm[1][0], pm[3][1] + pm[1][1], pm[3][2] + pm[1][2], pm[3][3] + pm[1][3]},   /* bottom */
+        {pm[3][0] - pm[1][0], pm[3][1] - pm[1][1], pm[3][2] - pm[1][2], pm[3][3] - pm[1][3]}};  /* top */
+    for(Vector4& plane: planes)
+        plane *= plane.xyz().lengthInverted();
+    return planes;
+}
+
+void benchmarkCullingKernels() {
+    /* A camera in the middle of a cube of random spheres, seeing roughly a
+       sixth of them */
+    std::mt19937 random;
+    std::uniform_real_distribution<Float> position{-100.0f, 100.0f}, radius{0.5f, 2.0f};
+    const std::vector<Vector4> planes = frustumPlanes(Matrix4::perspectiveProjection(90.0_degf, 1.0f, 0.1f, 100.0f));
+
+    /* Average time of given operation in milliseconds */
+    constexpr UnsignedInt Iterations = 10;
+    auto measure = [](const std::function<void()>& operation) {
+        const auto start = std::chrono::steady_clock::now();
+        for(UnsignedInt i = 0; i != Iterations; ++i) operation();
+        return std::chrono::duration<Double, std::milli>(std::chrono::steady_clock::now() - start).count()/Iterations;
+    };
+
+    for(const UnsignedInt count: {1000u, 10000u, 100000u, 1000000u}) {
+        CullingSpheres spheres;
+        for(UnsignedInt i = 0; i != count; ++i)
+            spheres.add({position(random), position(random), position(random)}, radius(random));
+
+        std::vector<UnsignedInt> expected;
+        cullSpheres(spheres, Containers::arrayView(planes.data(), planes.size()), expected, CullingKernel::Scalar);
+        Debug{} << "Culling" << count << "spheres," << expected.size() << "visible:";
+
+        std::vector<UnsignedInt> visible;
+        for(const CullingKernel kernel: {CullingKernel::Scalar, CullingKernel::Sse2, CullingKernel::Avx2, CullingKernel::Avx512}) {
+            if(!isCullingKernelSupported(kernel)) {
+                Debug{} << " " << cullingKernelName(kernel) << Debug::nospace << ": not supported";
+                continue;
+            }
+
+            const Double time = measure([&]{
+                cullSpheres(spheres, Containers::arrayView(planes.data(), planes.size()), visible, kernel);
+            });
+            Debug{} << " " << cullingKernelName(kernel) << Debug::nospace << ":"
+                << time*1.0e6/count << "ns per sphere"
+                << (visible == expected ? "" : "(different result!)");
+        }
+    }
+}
+
+}}
@@ -0,0 +1,132 @@
+#ifndef Magnum_Examples_FrustumCulling_h
+#define Magnum_Examples_FrustumCulling_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+        2016 — Bill Robinson <airbaggins@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Math/Matrix4.h>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Bounding spheres in a structure-of-arrays layout for batch culling
+
+Center coordinates and radii are stored in separate arrays, padded to a
+multiple of @ref BatchSize with spheres of a negative infinite radius. Those
+are outside of any plane, so the culling kernels can always process whole
+batches and never need to handle a remainder.
+*/
+class CullingSpheres {
+    public:
+        enum: std::size_t {
+            BatchSize = 16  /**< Spheres processed by the widest kernel at once */
+        };
+
+        /** @brief Sphere count */
+        std::size_t size() const { return _size; }
+
+        /** @brief Sphere count including the padding */
+        std::size_t paddedSize() const { return _x.size(); }
+
+        /** @brief Remove all spheres, keeping the allocated memory */
+        void clear();
+
+        /** @brief Add a sphere */
+        void add(const Vector3& center, Float radius);
+
+        const Float* x() const { return _x.data(); }
+        const Float* y() const { return _y.data(); }
+        const Float* z() const { return _z.data(); }
+        const Float* radius() const { return _radius.data(); }
+
+    private:
+        std::vector<Float> _x, _y, _z, _radius;
+        std::size_t _size{};
+};
+
+/** @brief Implementation of @ref cullSpheres() */
+enum class CullingKernel: UnsignedByte {
+    Scalar,     /**< One sphere at a time */
+    Sse2,       /**< Four spheres at a time using SSE2 */
+    Avx2,       /**< Eight spheres at a time using AVX2 */
+    Avx512      /**< Sixteen spheres at a time using AVX-512 */
+};
+
+/** @brief Max plane count accepted by @ref cullSpheres() */
+constexpr std::size_t MaxCullingPlaneCount = 8;
+
+/** @brief Kernel name for printing */
+const char* cullingKernelName(CullingKernel kernel);
+
+/**
+@brief Whether a culling kernel can be used on this machine
+
+The SIMD kernels are compiled only with GCC and Clang on x86, using per-function
+target attributes, so the rest of the code doesn't need any special compiler
+flags. The instruction sets are then detected at runtime.
+*/
+bool isCullingKernelSupported(CullingKernel kernel);
+
+/** @brief Widest culling kernel supported on this machine */
+CullingKernel bestCullingKernel();
+
+/**
+@brief Cull spheres with planes
+
+The planes are expected to have normalized normals pointing inside and to be
+in the same space as the sphere centers. A sphere is culled if its center is
+further than its radius on the negative side of any plane, same as
+@ref ShadowLight and @ref CasterBvh do it. Fills @p out with indices of the
+spheres that were not culled, in increasing order. All kernels give the same
+result. Expects at most @ref MaxCullingPlaneCount planes and a supported
+@p kernel.
+*/
+void cullSpheres(const CullingSpheres& spheres, Containers::ArrayView<const Vector4> planes, std::vector<UnsignedInt>& out, CullingKernel kernel = bestCullingKernel());
+
+/**
+@brief Frustum planes of a projection matrix
+
+Near, far, left, right, bottom and top planes in camera space, with
+normalized normals pointing inside.
+*/
+std::vector<Vector4> frustumPlanes(const Matrix4& projectionMatrix);
+
+/**
+@brief Benchmark the culling kernels
+
+Culls from a thousand up to a million random spheres with a perspective frustum
+using each supported kernel and prints the time per sphere.
+*/
+void benchmarkCullingKernels();
+
+}}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+        2016 — Bill Robinson <airbaggins@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "JobPool.h"
+
+namespace Magnum { namespace Examples {
+
+JobPool::JobPool(const std::size_t threadCount) {
+    _threads.reserve(threadCount);
+    for(std::size_t i = 0; i != threadCount; ++i)
+        _threads.emplace_back(&JobPool::work, this);
+}
+
+JobPool::~JobPool() {
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _quit = true;
+    }
+    _started.notify_all();
+    for(std::thread& thread: _threads) thread.join();
+}
+
+void JobPool::run(const std::size_t count, const std::function<void(std::size_t)>& job) {
+    /* Not worth waking anybody up for a single job */
+    if(_threads.empty() || count < 2) {
+        for(std::size_t i = 0; i != count; ++i) job(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _job = &job;
+        _count = count;
+        _nextJob = 0;
+        _busyThreads = _threads.size();
+        ++_batch;
+    }
+    _started.notify_all();
+
+    runJobs();
+
+    /* Wait also for the workers that got no job, so none of them touches
+       the job after it goes out of scope */
+    std::unique_lock<std::mutex> lock{_mutex};
+    _finished.wait(lock, [this]{ return !_busyThreads; });
+    _job = nullptr;
+}
+
+void JobPool::work() {
+    std::size_t batch = 0;
+    for(;;) {
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _started.wait(lock, [&]{ return _quit || _batch != batch; });
+            if(_quit) return;
+            batch = _batch;
+        }
+
+        runJobs();
+
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            --_busyThreads;
+        }
+        _finished.notify_one();
+    }
+}
+
+void JobPool::runJobs() {
+    for(;;) {
+        const std::size_t id = _nextJob++;
+        if(id >= _count) break;
+        (*_job)(id);
+    }
+}
+
+}}
@@ -0,0 +1,92 @@
+#ifndef Magnum_Examples_JobPool_h
+#define Magnum_Examples_JobPool_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+        2016 — Bill Robinson <airbaggins@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Pool of worker threads running batches of independent jobs
+
+The threads are created once and sleep between batches. Each @ref run() wakes
+them up and hands out job indices through an atomic counter, with the calling
+thread picking up jobs as well, and returns once all jobs are done. With zero
+threads the jobs are simply run one after another on the calling thread.
+*/
+class JobPool {
+    public:
+        /** @brief Constructor */
+        explicit JobPool(std::size_t threadCount);
+
+        /** @brief Joins all worker threads */
+        ~JobPool();
+
+        /** @brief Copying is not allowed */
+        JobPool(const JobPool&) = delete;
+
+        /** @brief Copying is not allowed */
+        JobPool& operator=(const JobPool&) = delete;
+
+        /** @brief Worker thread count, not including the calling thread */
+        std::size_t threadCount() const { return _threads.size(); }
+
+        /**
+         * @brief Run a batch of jobs
+         *
+         * Calls @p job with every index from @cpp 0 @ce to @p count, in no
+         * particular order and possibly in parallel. Blocks until all of
+         * them finish.
+         */
+        void run(std::size_t count, const std::function<void(std::size_t)>& job);
+
+    private:
+        void work();
+        void runJobs();
+
+        std::vector<std::thread> _threads;
+
+        std::mutex _mutex;
+        std::condition_variable _started, _finished;
+        const std::function<void(std::size_t)>* _job{};
+        std::size_t _count{}, _batch{}, _busyThreads{};
+        std::atomic<std::size_t> _nextJob{0};
+        bool _quit{};
+};
+
+}}
+
+#endif
@@ -30,8 +30,34 @@
 
 uniform highp mat4 transformationMatrix;
 
+#ifdef LAYERED
+uniform highp mat4 layerMatrices[MAX_LAYER_COUNT];
+uniform highp uint layerMask;
+
+#ifndef VERTEX_LAYER
+flat out highp int vertexLayer;
+#endif
+#endif
+
 in highp vec4 position;
 
 void main() {
+    #ifdef LAYERED
+    /* Instance N goes to the N-th layer set in the mask */
+    int layer = -1;
+    int remaining = gl_InstanceID;
+    do {
+        ++layer;
+        if((layerMask & (1u << uint(layer))) != 0u) --remaining;
+    } while(remaining >= 0);
+
+    gl_Position = layerMatrices[layer] * transformationMatrix * position;
+    #ifdef VERTEX_LAYER
+    gl_Layer = layer;
+    #else
+    vertexLayer = layer;
+    #endif
+    #else
     gl_Position = transformationMatrix * position;
+    #endif
 }
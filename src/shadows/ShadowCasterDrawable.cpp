@@ -30,6 +30,7 @@
 
 #include "ShadowCasterDrawable.h"
 
+#include <Magnum/GL/MeshView.h>
 #include <Magnum/SceneGraph/Camera.h>
 
 #include "ShadowCasterShader.h"
@@ -39,8 +40,21 @@ namespace Magnum { namespace Examples {
 ShadowCasterDrawable::ShadowCasterDrawable(SceneGraph::AbstractObject3D& parent, SceneGraph::DrawableGroup3D* drawables): Magnum::SceneGraph::Drawable3D{parent, drawables} {}
 
 void ShadowCasterDrawable::draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D& shadowCamera) {
-    _shader->setTransformationMatrix(shadowCamera.projectionMatrix()*transformationMatrix);
+    _shader->setTransformationMatrix(shadowCamera.projectionMatrix()*transformationMatrix*_meshTransformation);
     _mesh->draw(*_shader);
 }
 
+void ShadowCasterDrawable::drawLayered(ShadowCasterShader& shader, const Matrix4& transformationMatrix, const UnsignedInt layerMask) {
+    UnsignedInt layerCount = 0;
+    for(UnsignedInt mask = layerMask; mask; mask &= mask - 1) ++layerCount;
+
+    shader.setTransformationMatrix(transformationMatrix*_meshTransformation)
+        .setLayerMask(layerMask);
+    GL::MeshView{*_mesh}
+        .setCount(_mesh->count())
+        .setIndexRange(0)
+        .setInstanceCount(layerCount)
+        .draw(shader);
+}
+
 }}
@@ -31,6 +31,7 @@
 */
 
 #include <Magnum/GL/Mesh.h>
+#include <Magnum/Math/Matrix4.h>
 #include <Magnum/SceneGraph/Drawable.h>
 #include <Magnum/SceneGraph/Object.h>
 
@@ -48,18 +49,53 @@ class ShadowCasterDrawable: public SceneGraph::Drawable3D {
             _radius = radius;
         }
 
+        /**
+         * @brief Transformation applied to the mesh before the object one
+         *
+         * Used for dequantizing vertex positions. Identity by default.
+         */
+        void setMeshTransformation(const Matrix4& transformation) {
+            _meshTransformation = transformation;
+        }
+
         void setShader(ShadowCasterShader& shader) {
             _shader = &shader;
         }
 
         Float radius() const { return _radius; }
 
+        /**
+         * @brief Mark the caster as static
+         *
+         * Static casters are indexed in a hierarchy for culling and cached
+         * by @ref ShadowLight::setStaticCaching(), so they're redrawn only
+         * if something changes. Changing the flag after the caster was
+         * rendered needs @ref ShadowLight::invalidateStaticCasters(). Not
+         * static by default.
+         */
+        void setStatic(bool isStatic) { _static = isStatic; }
+
+        bool isStatic() const { return _static; }
+
         void draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D& shadowCamera) override;
 
+        /**
+         * @brief Draw into multiple layers at once
+         * @param shader                A @ref ShadowCasterShader::Flag::Layered
+         *      shader with layer matrices already set
+         * @param transformationMatrix  Absolute transformation of the object
+         * @param layerMask             Layers to draw into
+         *
+         * Draws the mesh instanced, once for each bit set in @p layerMask.
+         */
+        void drawLayered(ShadowCasterShader& shader, const Matrix4& transformationMatrix, UnsignedInt layerMask);
+
     private:
         GL::Mesh* _mesh{};
+        Matrix4 _meshTransformation;
         ShadowCasterShader* _shader{};
         Float _radius;
+        bool _static{};
 };
 
 }}
@@ -30,7 +30,9 @@
 
 #include "ShadowCasterShader.h"
 
+#include <algorithm>
 #include <Corrade/Containers/Reference.h>
+#include <Corrade/Utility/Assert.h>
 #include <Corrade/Utility/Resource.h>
 #include <Magnum/GL/Context.h>
 #include <Magnum/GL/Shader.h>
@@ -39,7 +41,7 @@
 
 namespace Magnum { namespace Examples {
 
-ShadowCasterShader::ShadowCasterShader() {
+ShadowCasterShader::ShadowCasterShader(const Flag flags): _flags{flags} {
     MAGNUM_ASSERT_GL_VERSION_SUPPORTED(GL::Version::GL330);
 
     const Utility::Resource rs{"shadow-data"};
@@ -47,16 +49,37 @@ ShadowCasterShader::ShadowCasterShader() {
     GL::Shader vert{GL::Version::GL330, GL::Shader::Type::Vertex};
     GL::Shader frag{GL::Version::GL330, GL::Shader::Type::Fragment};
 
+    /* Setting gl_Layer from the vertex shader avoids the geometry shader
+       overhead, but needs an extension */
+    bool vertexLayer = false;
+    if(flags == Flag::Layered) {
+        const std::vector<std::string> extensions = GL::Context::current().extensionStrings();
+        vertexLayer = std::find(extensions.begin(), extensions.end(), "GL_ARB_shader_viewport_layer_array") != extensions.end();
+
+        std::string preamble = "#define LAYERED\n#define MAX_LAYER_COUNT " + std::to_string(MaxLayerCount) + "\n";
+        if(vertexLayer) preamble = "#extension GL_ARB_shader_viewport_layer_array: require\n#define VERTEX_LAYER\n" + preamble;
+        vert.addSource(preamble);
+    }
     vert.addSource(rs.get("ShadowCaster.vert"));
     frag.addSource(rs.get("ShadowCaster.frag"));
 
-    CORRADE_INTERNAL_ASSERT_OUTPUT(GL::Shader::compile({vert, frag}));
-
-    attachShaders({vert, frag});
+    if(flags == Flag::Layered && !vertexLayer) {
+        GL::Shader geom{GL::Version::GL330, GL::Shader::Type::Geometry};
+        geom.addSource(rs.get("ShadowCasterLayered.geom"));
+        CORRADE_INTERNAL_ASSERT_OUTPUT(GL::Shader::compile({vert, geom, frag}));
+        attachShaders({vert, geom, frag});
+    } else {
+        CORRADE_INTERNAL_ASSERT_OUTPUT(GL::Shader::compile({vert, frag}));
+        attachShaders({vert, frag});
+    }
 
     CORRADE_INTERNAL_ASSERT_OUTPUT(link());
 
     _transformationMatrixUniform = uniformLocation("transformationMatrix");
+    if(flags == Flag::Layered) {
+        _layerMatricesUniform = uniformLocation("layerMatrices");
+        _layerMaskUniform = uniformLocation("layerMask");
+    }
 }
 
 ShadowCasterShader& ShadowCasterShader::setTransformationMatrix(const Matrix4& matrix) {
@@ -64,4 +87,15 @@ ShadowCasterShader& ShadowCasterShader::setTransformationMatrix(const Matrix4& m
     return *this;
 }
 
+ShadowCasterShader& ShadowCasterShader::setLayerMatrices(const Containers::ArrayView<const Matrix4> matrices) {
+    CORRADE_INTERNAL_ASSERT(matrices.size() <= MaxLayerCount);
+    setUniform(_layerMatricesUniform, matrices);
+    return *this;
+}
+
+ShadowCasterShader& ShadowCasterShader::setLayerMask(const UnsignedInt mask) {
+    setUniform(_layerMaskUniform, mask);
+    return *this;
+}
+
 }}
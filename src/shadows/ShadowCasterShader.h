@@ -30,25 +30,66 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <Corrade/Containers/ArrayView.h>
 #include <Magnum/GL/AbstractShaderProgram.h>
 
 namespace Magnum { namespace Examples {
 
 class ShadowCasterShader: public GL::AbstractShaderProgram {
     public:
-        explicit ShadowCasterShader();
+        enum: UnsignedInt {
+            /** Max layer count in the @ref Flag::Layered variant */
+            MaxLayerCount = 32
+        };
+
+        enum class Flag: UnsignedByte {
+            /**
+             * Render into all layers of a layered framebuffer at once. Each
+             * mesh is drawn instanced, once for every layer set in
+             * @ref setLayerMask(). The layer is set directly in the vertex
+             * shader if @gl_extension{ARB,shader_viewport_layer_array} is
+             * supported, otherwise by a pass-through geometry shader.
+             */
+            Layered = 1 << 0
+        };
+
+        explicit ShadowCasterShader(NoCreateT): GL::AbstractShaderProgram{NoCreate} {}
+
+        explicit ShadowCasterShader(Flag flags = {});
+
+        Flag flags() const { return _flags; }
 
         /**
          * @brief Set transformation matrix
          *
          * Matrix that transforms from local model space -> world space ->
          * camera space -> clip coordinates (aka model-view-projection
-         * matrix).
+         * matrix). In the @ref Flag::Layered variant it transforms only to
+         * world space, the rest is done by @ref setLayerMatrices().
          */
         ShadowCasterShader& setTransformationMatrix(const Matrix4& matrix);
 
+        /**
+         * @brief Set world space -> clip coordinates matrices of all layers
+         *
+         * Used only in the @ref Flag::Layered variant, expects at most
+         * @ref MaxLayerCount matrices.
+         */
+        ShadowCasterShader& setLayerMatrices(Containers::ArrayView<const Matrix4> matrices);
+
+        /**
+         * @brief Set layers to draw to
+         *
+         * Used only in the @ref Flag::Layered variant. The mesh is expected
+         * to be drawn with as many instances as there are bits set.
+         */
+        ShadowCasterShader& setLayerMask(UnsignedInt mask);
+
     private:
-        Int _transformationMatrixUniform;
+        Flag _flags;
+        Int _transformationMatrixUniform,
+            _layerMatricesUniform{-1},
+            _layerMaskUniform{-1};
 };
 
 }}
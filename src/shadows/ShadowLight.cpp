@@ -31,25 +31,42 @@
 #include "ShadowLight.h"
 
 #include <algorithm>
+#include <cmath>
 #include <Magnum/ImageView.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/PixelFormat.h>
 #include <Magnum/GL/Renderer.h>
 #include <Magnum/GL/TextureFormat.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Range.h>
 #include <Magnum/SceneGraph/FeatureGroup.h>
 #include <Magnum/SceneGraph/MatrixTransformation3D.h>
 #include <Magnum/SceneGraph/Scene.h>
 
+#include "FrustumCulling.h"
 #include "ShadowCasterDrawable.h"
 
 namespace Magnum { namespace Examples {
 
-ShadowLight::ShadowLight(SceneGraph::Object<SceneGraph::MatrixTransformation3D>& parent): SceneGraph::Camera3D{parent}, _object(parent), _shadowTexture{NoCreate} {
+namespace {
+
+/* Projecting world points normalized device coordinates means they range
+   -1 -> 1. Use this bias matrix so we go straight from world -> texture
+   space */
+constexpr const Matrix4 Bias{{0.5f, 0.0f, 0.0f, 0.0f},
+                             {0.0f, 0.5f, 0.0f, 0.0f},
+                             {0.0f, 0.0f, 0.5f, 0.0f},
+                             {0.5f, 0.5f, 0.5f, 1.0f}};
+
+}
+
+ShadowLight::ShadowLight(SceneGraph::Object<SceneGraph::MatrixTransformation3D>& parent): SceneGraph::Camera3D{parent}, _object(parent), _shadowTexture{NoCreate}, _jobPool{new JobPool{0}} {
     setAspectRatioPolicy(SceneGraph::AspectRatioPolicy::NotPreserved);
 }
 
 void ShadowLight::setupShadowmaps(Int numShadowLevels, const Vector2i& size) {
     _layers.clear();
+    _size = size;
 
     (_shadowTexture = GL::Texture2DArray{})
         .setImage(0, GL::TextureFormat::DepthComponent, ImageView3D{GL::PixelFormat::DepthComponent, GL::PixelType::Float, {size, numShadowLevels}, nullptr})
@@ -67,6 +84,51 @@ void ShadowLight::setupShadowmaps(Int numShadowLevels, const Vector2i& size) {
             .bind();
         CORRADE_INTERNAL_ASSERT(shadowFramebuffer.checkStatus(GL::FramebufferTarget::Draw) == GL::Framebuffer::Status::Complete);
     }
+
+    /* All layers at once for the single-pass rendering */
+    _layeredFramebuffer = GL::Framebuffer{{{}, size}};
+    _layeredFramebuffer.attachLayeredTexture(GL::Framebuffer::BufferAttachment::Depth, _shadowTexture, 0)
+        .mapForDraw(GL::Framebuffer::DrawAttachment::None)
+        .bind();
+    CORRADE_INTERNAL_ASSERT(_layeredFramebuffer.checkStatus(GL::FramebufferTarget::Draw) == GL::Framebuffer::Status::Complete);
+
+    /* The cache gets created again once enabled */
+    if(_staticCaching) setupStaticCache();
+    else _staticTexture = GL::Texture2DArray{NoCreate};
+}
+
+void ShadowLight::setupStaticCache() {
+    /* Same format as the shadow maps so depth can be blitted between the
+       two, but never sampled */
+    (_staticTexture = GL::Texture2DArray{})
+        .setImage(0, GL::TextureFormat::DepthComponent, ImageView3D{GL::PixelFormat::DepthComponent, GL::PixelType::Float, {_size, Int(_layers.size())}, nullptr})
+        .setMaxLevel(0)
+        .setMinificationFilter(GL::SamplerFilter::Nearest, GL::SamplerMipmap::Base)
+        .setMagnificationFilter(GL::SamplerFilter::Nearest);
+
+    for(std::size_t i = 0; i != _layers.size(); ++i) {
+        GL::Framebuffer& staticFramebuffer = _layers[i].staticFramebuffer;
+        staticFramebuffer = GL::Framebuffer{{{}, _size}};
+        staticFramebuffer.attachTextureLayer(GL::Framebuffer::BufferAttachment::Depth, _staticTexture, 0, i)
+            .mapForDraw(GL::Framebuffer::DrawAttachment::None)
+            .bind();
+        CORRADE_INTERNAL_ASSERT(staticFramebuffer.checkStatus(GL::FramebufferTarget::Draw) == GL::Framebuffer::Status::Complete);
+        _layers[i].staticValid = false;
+    }
+}
+
+void ShadowLight::setStaticCaching(const bool caching) {
+    if(caching && !_staticTexture.id()) setupStaticCache();
+
+    /* Static casters might have moved while the cache wasn't used */
+    if(caching && !_staticCaching) _staticCastersDirty = true;
+    _staticCaching = caching;
+}
+
+void ShadowLight::setLayered(const bool layered) {
+    if(layered && !_layeredShader.id())
+        _layeredShader = ShadowCasterShader{ShadowCasterShader::Flag::Layered};
+    _layered = layered;
 }
 
 ShadowLight::ShadowLayerData::ShadowLayerData(const Vector2i& size): shadowFramebuffer{{{}, size}} {}
@@ -77,6 +139,11 @@ void ShadowLight::setTarget(const Vector3& lightDirection, const Vector3& screen
     const Matrix3x3 inverseCameraRotationMatrix = cameraRotationMatrix.inverted();
 
     for(std::size_t layerIndex = 0; layerIndex != _layers.size(); ++layerIndex) {
+        if(_staticCaching) {
+            setCachedTarget(layerIndex, cameraMatrix, mainCamera);
+            continue;
+        }
+
         std::vector<Vector3> mainCameraFrustumCorners = layerFrustumCorners(mainCamera, Int(layerIndex));
         ShadowLayerData& layer = _layers[layerIndex];
 
@@ -103,6 +170,38 @@ void ShadowLight::setTarget(const Vector3& lightDirection, const Vector3& screen
     }
 }
 
+void ShadowLight::setCachedTarget(const std::size_t layerIndex, Matrix4 cameraMatrix, SceneGraph::Camera3D& mainCamera) {
+    ShadowLayerData& layer = _layers[layerIndex];
+    const Matrix3x3 cameraRotationMatrix = cameraMatrix.rotation();
+    const Matrix3x3 inverseCameraRotationMatrix = cameraRotationMatrix.inverted();
+
+    /* Bounding sphere of the split calculated in view space, so its size
+       depends only on the projection and not on where the camera is or
+       where it looks */
+    const Float z0 = layerIndex == 0 ? 0 : _layers[layerIndex - 1].cutPlane;
+    const std::vector<Vector3> viewCorners = frustumCorners(mainCamera.projectionMatrix().inverted(), z0, layer.cutPlane);
+    Vector3 viewCentre;
+    for(const Vector3& corner: viewCorners) viewCentre += corner;
+    viewCentre /= Float(viewCorners.size());
+    Float radius = 0.0f;
+    for(const Vector3& corner: viewCorners)
+        radius = Math::max(radius, (corner - viewCentre).length());
+    const Vector3 centre = inverseCameraRotationMatrix*mainCamera.cameraMatrix().invertedRigid().transformPoint(viewCentre);
+
+    /* Snap the center to whole texels, so the same world point always ends
+       up in the same texel, just shifted. Depth range is snapped to much
+       coarser steps to not change too often. */
+    const Float size = 2.0f*radius;
+    const Vector2 texelSize = Vector2{size}/Vector2{_size};
+    layer.centreTexel = Vector2i{Math::round(centre.xy()/texelSize)};
+    layer.depthStep = 0.25f*size;
+    layer.orthographicSize = Vector2{size};
+    layer.orthographicNear = -std::ceil((centre.z() + radius)/layer.depthStep)*layer.depthStep;
+    layer.orthographicFar = -std::floor((centre.z() - radius)/layer.depthStep)*layer.depthStep;
+    cameraMatrix.translation() = cameraRotationMatrix*Vector3{Vector2{layer.centreTexel}*texelSize, 0.0f};
+    layer.shadowCameraMatrix = cameraMatrix;
+}
+
 Float ShadowLight::cutZ(const Int layer) const {
     return _layers[layer].cutPlane;
 }
@@ -145,99 +244,348 @@ std::vector<Vector3> ShadowLight::frustumCorners(const Matrix4& imvp, const Floa
 }
 
 std::vector<Vector4> ShadowLight::calculateClipPlanes() {
-    const Matrix4 pm = projectionMatrix();
-    std::vector<Vector4> clipPlanes{
-        {pm[3][0] + pm[2][0], pm[3][1] + pm[2][1], pm[3][2] + pm[2][2], pm[3][3] + pm[2][3]},   /* near */
-        {pm[3][0] - pm[2][0], pm[3][1] - pm[2][1], pm[3][2] - pm[2][2], pm[3][3] - pm[2][3]},   /* far */
-        {pm[3][0] + pm[0][0], pm[3][1] + pm[0][1], pm[3][2] + pm[0][2], pm[3][3] + pm[0][3]},   /* left */
-        {pm[3][0] - pm[0][0], pm[3][1] - pm[0][1], pm[3][2] - pm[0][2], pm[3][3] - pm[0][3]},   /* right */
-        {pm[3][0] + pm[1][0], pm[3][1] + pm[1][1], pm[3][2] + pm[1][2], pm[3][3] + pm[1][3]},   /* bottom */
-        {pm[3][0] - pm[1][0], pm[3][1] - pm[1][1], pm[3][2] - pm[1][2], pm[3][3] - pm[1][3]}};  /* top */
-    for(Vector4& plane: clipPlanes)
-        plane *= plane.xyz().lengthInverted();
-    return clipPlanes;
+    return frustumPlanes(projectionMatrix());
 }
 
-void ShadowLight::render(SceneGraph::DrawableGroup3D& drawables) {
-    /* Compute transformations of all objects in the group relative to the camera */
+void ShadowLight::updateStaticCasters(SceneGraph::DrawableGroup3D& drawables) {
+    /* A different group or added and removed drawables need the hierarchy
+       rebuilt */
+    if(&drawables != _indexedDrawables || drawables.size() != _indexedDrawableCount)
+        _staticCasterBvhDirty = true;
+
+    /* So does a static caster that moved since the last time, and it
+       invalidates the static cache as well. Clean it so it gets detected
+       again only if it moves again. */
+    for(std::size_t i = 0; i != drawables.size(); ++i) {
+        auto& drawable = static_cast<ShadowCasterDrawable&>(drawables[i]);
+        if(drawable.isStatic() && drawable.object().isDirty()) {
+            _staticCastersDirty = _staticCasterBvhDirty = true;
+            drawable.object().setClean();
+        }
+    }
+
+    if(!_staticCasterBvhDirty) return;
+    _staticCasterBvhDirty = false;
+    _indexedDrawables = &drawables;
+    _indexedDrawableCount = drawables.size();
+
+    /* Static casters go to the hierarchy, dynamic ones are tested
+       separately every frame */
     std::vector<std::reference_wrapper<Object3D>> objects;
-    objects.reserve(drawables.size());
-    for(std::size_t i = 0; i != drawables.size(); ++i)
-        objects.push_back(static_cast<Object3D&>(drawables[i].object()));
-    std::vector<ShadowCasterDrawable*> filteredDrawables;
-
-    /* Projecting world points normalized device coordinates means they range
-       -1 -> 1. Use this bias matrix so we go straight from world -> texture
-       space */
-    constexpr const Matrix4 bias{{0.5f, 0.0f, 0.0f, 0.0f},
-                                 {0.0f, 0.5f, 0.0f, 0.0f},
-                                 {0.0f, 0.0f, 0.5f, 0.0f},
-                                 {0.5f, 0.5f, 0.5f, 1.0f}};
+    std::vector<Float> radii;
+    std::vector<UnsignedInt> ids;
+    _dynamicCasters.clear();
+    for(std::size_t i = 0; i != drawables.size(); ++i) {
+        auto& drawable = static_cast<ShadowCasterDrawable&>(drawables[i]);
+        if(!drawable.isStatic()) {
+            _dynamicCasters.push_back(UnsignedInt(i));
+            continue;
+        }
 
-    GL::Renderer::setDepthMask(true);
+        objects.push_back(static_cast<Object3D&>(drawable.object()));
+        radii.push_back(drawable.radius());
+        ids.push_back(UnsignedInt(i));
+    }
 
-    for(std::size_t layer = 0; layer != _layers.size(); ++layer) {
-        ShadowLayerData& d = _layers[layer];
-        Float orthographicNear = d.orthographicNear;
-        const Float orthographicFar = d.orthographicFar;
+    const std::vector<Matrix4> transformations = _object.scene()->transformationMatrices(objects, Matrix4{});
+    std::vector<Vector3> centres(transformations.size());
+    for(std::size_t i = 0; i != transformations.size(); ++i)
+        centres[i] = transformations[i].translation();
+    _staticCasterBvh.build(Containers::arrayView(centres.data(), centres.size()),
+        Containers::arrayView(radii.data(), radii.size()),
+        Containers::arrayView(ids.data(), ids.size()));
+}
 
-        /* Move this whole object to the right place to render each layer */
-        _object.setTransformation(d.shadowCameraMatrix)
-            .setClean();
-        setProjectionMatrix(Matrix4::orthographicProjection(d.orthographicSize, orthographicNear, orthographicFar));
-
-        const std::vector<Vector4> clipPlanes = calculateClipPlanes();
-        std::vector<Matrix4> transformations = _object.scene()->transformationMatrices(objects, cameraMatrix());
-
-        /* Rebuild the list of objects we will draw by clipping them with the
-           shadow camera's planes */
-        std::size_t transformationsOutIndex = 0;
-        filteredDrawables.clear();
-        for(std::size_t drawableIndex = 0; drawableIndex != drawables.size(); ++drawableIndex) {
-            auto& drawable = static_cast<ShadowCasterDrawable&>(drawables[drawableIndex]);
-            const Matrix4 transform = transformations[drawableIndex];
-
-            /* If your centre is offset, inject it here */
-            const Vector4 localCentre{0.0f, 0.0f, 0.0f, 1.0f};
-            const Vector4 drawableCentre = transform*localCentre;
-
-            /* Start at 1, not 0 to skip out the near plane because we need to
-               include shadow casters traveling the direction the camera is
-               facing. */
-            for(std::size_t clipPlaneIndex = 1; clipPlaneIndex != clipPlanes.size(); ++clipPlaneIndex) {
-                const Float distance = Math::dot(clipPlanes[clipPlaneIndex], drawableCentre);
-
-                /* If the object is on the useless side of any one plane, we can skip it */
-                if(distance < -drawable.radius())
-                    goto next;
-            }
+void ShadowLight::updateDynamicCasters(SceneGraph::DrawableGroup3D& drawables) {
+    /* Dynamic casters aren't in the hierarchy, so they're culled for each
+       layer in a batch instead, which needs their transformations upfront */
+    std::vector<std::reference_wrapper<Object3D>> objects;
+    objects.reserve(_dynamicCasters.size());
+    for(const UnsignedInt drawableIndex: _dynamicCasters)
+        objects.push_back(static_cast<Object3D&>(drawables[drawableIndex].object()));
+    _dynamicCasterTransformations = _object.scene()->transformationMatrices(objects, Matrix4{});
+    _dynamicCasterSpheres.clear();
+    for(std::size_t i = 0; i != _dynamicCasters.size(); ++i)
+        _dynamicCasterSpheres.add(_dynamicCasterTransformations[i].translation(),
+            static_cast<ShadowCasterDrawable&>(drawables[_dynamicCasters[i]]).radius());
+}
+
+void ShadowLight::cullLayer(const std::size_t layer) {
+    ShadowLayerData& d = _layers[layer];
+
+    /* Skip the near plane same as the render functions do, and move the rest
+       from the shadow camera to world space. The near plane is the only one
+       that depends on orthographicNear, so it doesn't matter that it gets
+       extended later. Not using calculateClipPlanes(), as that would need
+       the projection set on this camera, which is shared by all layers. */
+    const std::vector<Vector4> clipPlanes = frustumPlanes(Matrix4::orthographicProjection(d.orthographicSize, d.orthographicNear, d.orthographicFar));
+    const Matrix4 transposedCameraMatrix = d.shadowCameraMatrix.invertedRigid().transposed();
+    Vector4 worldPlanes[5];
+    for(std::size_t i = 1; i != clipPlanes.size(); ++i)
+        worldPlanes[i - 1] = transposedCameraMatrix*clipPlanes[i];
+
+    d.staticHits.clear();
+    _staticCasterBvh.query(worldPlanes, d.staticHits);
+    cullSpheres(_dynamicCasterSpheres, worldPlanes, d.dynamicHits);
+}
 
-            {
-                /* If this object extends in front of the near plane, extend
-                   the near plane. We negate the z because the negative z is
-                   forward away from the camera, but the near/far planes are
-                   measured forwards. */
-                const Float nearestPoint = -drawableCentre.z() - drawable.radius();
-                orthographicNear = Math::min(orthographicNear, nearestPoint);
-                filteredDrawables.push_back(&drawable);
-                transformations[transformationsOutIndex++] = transform;
+void ShadowLight::collectCandidates(SceneGraph::DrawableGroup3D& drawables) {
+    if(_candidateIndices.size() < drawables.size())
+        _candidateIndices.resize(drawables.size(), ~UnsignedInt{});
+    _candidates.clear();
+    _candidateTransformations.clear();
+    _layerCandidates.resize(_layers.size());
+
+    /* Static casters get their transformations fetched at the end, only for
+       those the hierarchy returned */
+    std::vector<std::reference_wrapper<Object3D>> objects;
+    std::vector<UnsignedInt> staticCandidates;
+    for(std::size_t layer = 0; layer != _layers.size(); ++layer) {
+        const ShadowLayerData& d = _layers[layer];
+
+        /* Casters visible in more layers become a candidate just once */
+        std::vector<UnsignedInt>& layerCandidates = _layerCandidates[layer];
+        layerCandidates.clear();
+        for(const UnsignedInt drawableIndex: d.staticHits) {
+            UnsignedInt& candidate = _candidateIndices[drawableIndex];
+            if(candidate == ~UnsignedInt{}) {
+                candidate = UnsignedInt(_candidates.size());
+                _candidates.push_back(drawableIndex);
+                _candidateTransformations.emplace_back();
+                staticCandidates.push_back(candidate);
+                objects.push_back(static_cast<Object3D&>(drawables[drawableIndex].object()));
             }
+            layerCandidates.push_back(candidate);
+        }
+        for(const UnsignedInt dynamicCaster: d.dynamicHits) {
+            const UnsignedInt drawableIndex = _dynamicCasters[dynamicCaster];
+            UnsignedInt& candidate = _candidateIndices[drawableIndex];
+            if(candidate == ~UnsignedInt{}) {
+                candidate = UnsignedInt(_candidates.size());
+                _candidates.push_back(drawableIndex);
+                _candidateTransformations.push_back(_dynamicCasterTransformations[dynamicCaster]);
+            }
+            layerCandidates.push_back(candidate);
+        }
+    }
+
+    const std::vector<Matrix4> staticTransformations = _object.scene()->transformationMatrices(objects, Matrix4{});
+    for(std::size_t i = 0; i != staticCandidates.size(); ++i)
+        _candidateTransformations[staticCandidates[i]] = staticTransformations[i];
 
-            next:;
+    /* Reset the lookup table for the next time */
+    for(const UnsignedInt drawableIndex: _candidates)
+        _candidateIndices[drawableIndex] = ~UnsignedInt{};
+}
+
+void ShadowLight::prepareLayer(const std::size_t layer, SceneGraph::DrawableGroup3D& drawables) {
+    ShadowLayerData& d = _layers[layer];
+    Float orthographicNear = d.orthographicNear;
+    const Float orthographicFar = d.orthographicFar;
+    const Matrix4 layerCameraMatrix = d.shadowCameraMatrix.invertedRigid();
+
+    /* The single-pass rendering draws with absolute transformations and
+       needs just the near plane */
+    const bool drawLists = _staticCaching || !_layered;
+    d.drawables.clear();
+    d.transformations.clear();
+    d.dynamicDrawables.clear();
+    d.dynamicTransformations.clear();
+
+    /* The candidates are already clipped with the shadow camera's planes,
+       except for the near one because we need to include shadow casters
+       traveling the direction the camera is facing */
+    for(const UnsignedInt candidate: _layerCandidates[layer]) {
+        auto& drawable = static_cast<ShadowCasterDrawable&>(drawables[_candidates[candidate]]);
+
+        /* If your centre is offset, inject it here */
+        const Vector3 drawableCentre = layerCameraMatrix.transformPoint(_candidateTransformations[candidate].translation());
+
+        /* If this object extends in front of the near plane, extend the near
+           plane. We negate the z because the negative z is forward away from
+           the camera, but the near/far planes are measured forwards. With
+           static caching, extend it only for static casters and in whole
+           depth steps, so it stays the same while the static casters don't
+           change, and put the dynamic ones to a separate list. */
+        const Float nearestPoint = -drawableCentre.z() - drawable.radius();
+        if(_staticCaching && !drawable.isStatic()) {
+            d.dynamicDrawables.push_back(&drawable);
+            d.dynamicTransformations.push_back(layerCameraMatrix*_candidateTransformations[candidate]);
+            continue;
+        }
+        if(_staticCaching) {
+            if(nearestPoint < orthographicNear)
+                orthographicNear = std::floor(nearestPoint/d.depthStep)*d.depthStep;
+        } else orthographicNear = Math::min(orthographicNear, nearestPoint);
+
+        if(drawLists) {
+            d.drawables.push_back(&drawable);
+            d.transformations.push_back(layerCameraMatrix*_candidateTransformations[candidate]);
         }
+    }
+
+    /* Recalculate the projection matrix with new near plane. */
+    d.preparedNear = orthographicNear;
+    d.projectionMatrix = Matrix4::orthographicProjection(d.orthographicSize, orthographicNear, orthographicFar);
+    d.shadowMatrix = Bias*d.projectionMatrix*layerCameraMatrix;
+}
 
-        /* Recalculate the projection matrix with new near plane. */
-        const Matrix4 shadowCameraProjectionMatrix =
-            Matrix4::orthographicProjection(d.orthographicSize, orthographicNear, orthographicFar);
-        d.shadowMatrix = bias*shadowCameraProjectionMatrix*cameraMatrix();
-        setProjectionMatrix(shadowCameraProjectionMatrix);
+void ShadowLight::render(SceneGraph::DrawableGroup3D& drawables) {
+    /* Preparation, touching only CPU-side state. The scene graph isn't
+       thread-safe, so transformations are calculated serially and only the
+       per-layer culling and draw list building runs in parallel. */
+    updateStaticCasters(drawables);
+    updateDynamicCasters(drawables);
+    _jobPool->run(_layers.size(), [this](const std::size_t layer) {
+        cullLayer(layer);
+    });
+    collectCandidates(drawables);
+    _jobPool->run(_layers.size(), [this, &drawables](const std::size_t layer) {
+        prepareLayer(layer, drawables);
+    });
+
+    /* Move this whole object to the place of the last layer, so it's in
+       the light direction */
+    _object.setTransformation(_layers.back().shadowCameraMatrix)
+        .setClean();
+
+    /* Submission of the prepared draw lists */
+    if(_staticCaching) {
+        renderCached();
+        return;
+    }
+    if(_layered) {
+        renderLayered(drawables);
+        return;
+    }
+
+    GL::Renderer::setDepthMask(true);
+    _drawCallCount = 0;
+
+    for(std::size_t layer = 0; layer != _layers.size(); ++layer) {
+        ShadowLayerData& d = _layers[layer];
+        setProjectionMatrix(d.projectionMatrix);
 
         d.shadowFramebuffer.clear(GL::FramebufferClear::Depth)
             .bind();
-        for(std::size_t i = 0; i != transformationsOutIndex; ++i)
-            filteredDrawables[i]->draw(transformations[i], *this);
+        for(std::size_t i = 0; i != d.drawables.size(); ++i)
+            d.drawables[i]->draw(d.transformations[i], *this);
+        _drawCallCount += d.drawables.size();
+    }
+
+    GL::defaultFramebuffer.bind();
+}
+
+void ShadowLight::renderLayered(SceneGraph::DrawableGroup3D& drawables) {
+    CORRADE_INTERNAL_ASSERT(_layers.size() <= ShadowCasterShader::MaxLayerCount);
+
+    /* Remember which layers each candidate is visible in */
+    std::vector<UnsignedInt> layerMasks(_candidates.size());
+    Matrix4 layerMatrices[ShadowCasterShader::MaxLayerCount];
+    for(std::size_t layer = 0; layer != _layers.size(); ++layer) {
+        const ShadowLayerData& d = _layers[layer];
+        for(const UnsignedInt candidate: _layerCandidates[layer])
+            layerMasks[candidate] |= 1u << layer;
+        layerMatrices[layer] = d.projectionMatrix*d.shadowCameraMatrix.invertedRigid();
+    }
+
+    /* Clear all layers at once and draw each visible caster just once */
+    GL::Renderer::setDepthMask(true);
+    _drawCallCount = 0;
+    _layeredShader.setLayerMatrices({layerMatrices, _layers.size()});
+    _layeredFramebuffer.clear(GL::FramebufferClear::Depth)
+        .bind();
+    for(std::size_t i = 0; i != _candidates.size(); ++i) {
+        if(!layerMasks[i]) continue;
+        static_cast<ShadowCasterDrawable&>(drawables[_candidates[i]]).drawLayered(_layeredShader, _candidateTransformations[i], layerMasks[i]);
+        ++_drawCallCount;
+    }
+
+    GL::defaultFramebuffer.bind();
+}
+
+void ShadowLight::renderCached() {
+    GL::Renderer::setDepthMask(true);
+    _drawCallCount = _staticRedrawCount = _staticScrollCount = 0;
+
+    for(std::size_t layer = 0; layer != _layers.size(); ++layer) {
+        ShadowLayerData& d = _layers[layer];
+        const Float orthographicNear = d.preparedNear;
+        const Float orthographicFar = d.orthographicFar;
+        setProjectionMatrix(d.projectionMatrix);
+
+        /* The cache can be reused if it was drawn with the same projection,
+           possibly shifted by whole texels */
+        const Vector2i shift = d.centreTexel - d.staticCentreTexel;
+        const bool reusable = d.staticValid && !_staticCastersDirty &&
+            d.staticRotation == d.shadowCameraMatrix.rotationScaling() &&
+            d.staticSize == d.orthographicSize.x() &&
+            d.staticNear == orthographicNear && d.staticFar == orthographicFar &&
+            (Math::abs(shift) < _size).all();
+        const Range2Di whole{{}, _size};
+        if(!reusable) {
+            ++_staticRedrawCount;
+            d.staticFramebuffer.clear(GL::FramebufferClear::Depth)
+                .bind();
+            for(std::size_t i = 0; i != d.drawables.size(); ++i)
+                d.drawables[i]->draw(d.transformations[i], *this);
+            _drawCallCount += d.drawables.size();
+            GL::AbstractFramebuffer::blit(d.staticFramebuffer, d.shadowFramebuffer,
+                whole, GL::FramebufferBlit::Depth);
+
+        } else if(!shift.isZero()) {
+            ++_staticScrollCount;
+
+            /* Texels stay at the same place in the world, so in the texture
+               they move in the opposite direction */
+            const Range2Di source{Math::max(shift, Vector2i{}), _size + Math::min(shift, Vector2i{})};
+            GL::AbstractFramebuffer::blit(d.staticFramebuffer, d.shadowFramebuffer,
+                source, source.translated(-shift),
+                GL::FramebufferBlit::Depth, GL::FramebufferBlitFilter::Nearest);
+
+            /* Draw static casters only into the strips that got uncovered */
+            const Range2Di strips[]{
+                shift.x() > 0 ? Range2Di{{_size.x() - shift.x(), 0}, _size} :
+                                Range2Di{{}, {-shift.x(), _size.y()}},
+                shift.y() > 0 ? Range2Di{{0, _size.y() - shift.y()}, _size} :
+                                Range2Di{{}, {_size.x(), -shift.y()}}};
+            d.shadowFramebuffer.bind();
+            GL::Renderer::enable(GL::Renderer::Feature::ScissorTest);
+            for(const Range2Di& strip: strips) {
+                if(!strip.size().product()) continue;
+                GL::Renderer::setScissor(strip);
+                d.shadowFramebuffer.clear(GL::FramebufferClear::Depth);
+                for(std::size_t i = 0; i != d.drawables.size(); ++i)
+                    d.drawables[i]->draw(d.transformations[i], *this);
+                _drawCallCount += d.drawables.size();
+            }
+            GL::Renderer::disable(GL::Renderer::Feature::ScissorTest);
+
+            /* Update the cache for the new position */
+            GL::AbstractFramebuffer::blit(d.shadowFramebuffer, d.staticFramebuffer,
+                whole, GL::FramebufferBlit::Depth);
+
+        } else GL::AbstractFramebuffer::blit(d.staticFramebuffer, d.shadowFramebuffer,
+            whole, GL::FramebufferBlit::Depth);
+
+        d.staticValid = true;
+        d.staticRotation = d.shadowCameraMatrix.rotationScaling();
+        d.staticCentreTexel = d.centreTexel;
+        d.staticSize = d.orthographicSize.x();
+        d.staticNear = orthographicNear;
+        d.staticFar = orthographicFar;
+
+        /* Dynamic casters on top. The near plane isn't extended for them,
+           so clamp the depth of those in front of it instead of clipping. */
+        d.shadowFramebuffer.bind();
+        GL::Renderer::enable(GL::Renderer::Feature::DepthClamp);
+        for(std::size_t i = 0; i != d.dynamicDrawables.size(); ++i)
+            d.dynamicDrawables[i]->draw(d.dynamicTransformations[i], *this);
+        GL::Renderer::disable(GL::Renderer::Feature::DepthClamp);
+        _drawCallCount += d.dynamicDrawables.size();
     }
 
+    _staticCastersDirty = false;
     GL::defaultFramebuffer.bind();
 }
 
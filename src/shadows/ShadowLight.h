@@ -30,6 +30,7 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <Corrade/Containers/Pointer.h>
 #include <Magnum/Resource.h>
 #include <Magnum/GL/Framebuffer.h>
 #include <Magnum/GL/TextureArray.h>
@@ -37,10 +38,16 @@
 #include <Magnum/SceneGraph/Drawable.h>
 #include <Magnum/SceneGraph/AbstractFeature.h>
 
+#include "CasterBvh.h"
+#include "FrustumCulling.h"
+#include "JobPool.h"
+#include "ShadowCasterShader.h"
 #include "Types.h"
 
 namespace Magnum { namespace Examples {
 
+class ShadowCasterDrawable;
+
 /**
 @brief A special camera used to render shadow maps
 
@@ -86,9 +93,106 @@ class ShadowLight: public SceneGraph::Camera3D {
 
         /**
          * @brief Render a group of shadow-casting drawables to the shadow maps
+         *
+         * Casters marked with @ref ShadowCasterDrawable::setStatic() are
+         * kept in a @ref CasterBvh, which is queried for each layer instead
+         * of testing all of them, while the dynamic ones are culled in a
+         * batch with @ref cullSpheres(). Absolute transformations of static
+         * casters are calculated only for those that passed. The hierarchy
+         * is rebuilt if any static caster moves, on
+         * @ref invalidateStaticCasters() or if a different group or a group
+         * of a different size is passed.
+         *
+         * Culling the layers, extending their near planes, calculating the
+         * shadow matrices and building the draw lists is done for all layers
+         * first, in parallel if @ref setPreparationThreadCount() is set.
+         * Only then the lists are submitted to GL, on the calling thread.
          */
         void render(SceneGraph::DrawableGroup3D& drawables);
 
+        /**
+         * @brief Prepare layers on worker threads
+         *
+         * The calling thread prepares layers as well, so there's no point in
+         * more threads than layer count minus one. Transformations of the
+         * objects are still calculated on the calling thread, as the scene
+         * graph isn't thread-safe. Zero by default, which prepares all
+         * layers on the calling thread.
+         */
+        void setPreparationThreadCount(std::size_t count) {
+            _jobPool = Containers::Pointer<JobPool>{new JobPool{count}};
+        }
+
+        std::size_t preparationThreadCount() const {
+            return _jobPool->threadCount();
+        }
+
+        /**
+         * @brief Render all layers in a single pass
+         *
+         * Instead of binding a framebuffer for each layer and drawing all
+         * casters visible in it, the whole texture array is attached as a
+         * layered framebuffer and each caster is drawn just once, instanced
+         * for every layer it's visible in. Expects at most
+         * @ref ShadowCasterShader::MaxLayerCount layers. Disabled by default.
+         */
+        void setLayered(bool layered);
+
+        bool isLayered() const { return _layered; }
+
+        /**
+         * @brief Cache static shadow casters
+         *
+         * Keeps depth of casters marked with
+         * @ref ShadowCasterDrawable::setStatic() in a separate texture array
+         * and only copies it to the shadow maps every frame, drawing just the
+         * dynamic casters on top. To make the cache reusable, layers are
+         * sized to fit a bounding sphere of the frustum split, snapped to
+         * whole texels and their depth range is snapped to a quarter of the
+         * size. A layer is redrawn if its depth range, size or the light
+         * orientation changes, if the main camera moves so far that the
+         * whole layer gets replaced or if any static caster moves. On
+         * smaller camera movement the cached texels are only shifted and
+         * just the uncovered strips are redrawn. Takes precedence over
+         * @ref setLayered(). Disabled by default.
+         *
+         * Static casters are detected as moved by their object being dirty,
+         * so the shadow maps have to be rendered before the objects get
+         * cleaned by drawing the main camera. Use
+         * @ref invalidateStaticCasters() to force a redraw otherwise.
+         */
+        void setStaticCaching(bool caching);
+
+        bool isStaticCaching() const { return _staticCaching; }
+
+        /**
+         * @brief Redraw the static caster cache in the next @ref render()
+         *
+         * Rebuilds the static caster hierarchy as well. Needed if static
+         * casters changed in a way that isn't detected automatically, such
+         * as a different radius or the static flag changing.
+         */
+        void invalidateStaticCasters() {
+            _staticCastersDirty = _staticCasterBvhDirty = true;
+        }
+
+        /**
+         * @brief Layers with static casters fully redrawn in the last @ref render()
+         *
+         * Used only if @ref setStaticCaching() is enabled.
+         */
+        UnsignedInt staticRedrawCount() const { return _staticRedrawCount; }
+
+        /**
+         * @brief Layers with static casters shifted in the last @ref render()
+         *
+         * Used only if @ref setStaticCaching() is enabled.
+         */
+        UnsignedInt staticScrollCount() const { return _staticScrollCount; }
+
+        /** @brief Draw calls submitted in the last @ref render() */
+        UnsignedInt drawCallCount() const { return _drawCallCount; }
+
         std::vector<Vector3> layerFrustumCorners(SceneGraph::Camera3D& mainCamera, Int layer);
 
         Float cutZ(Int layer) const;
@@ -106,8 +210,43 @@ class ShadowLight: public SceneGraph::Camera3D {
         GL::Texture2DArray& shadowTexture() { return _shadowTexture; }
 
     private:
+        void updateStaticCasters(SceneGraph::DrawableGroup3D& drawables);
+        void updateDynamicCasters(SceneGraph::DrawableGroup3D& drawables);
+        void cullLayer(std::size_t layer);
+        void collectCandidates(SceneGraph::DrawableGroup3D& drawables);
+        void prepareLayer(std::size_t layer, SceneGraph::DrawableGroup3D& drawables);
+        void renderLayered(SceneGraph::DrawableGroup3D& drawables);
+        void renderCached();
+        void setCachedTarget(std::size_t layerIndex, Matrix4 cameraMatrix, SceneGraph::Camera3D& mainCamera);
+        void setupStaticCache();
+
         Object3D& _object;
         GL::Texture2DArray _shadowTexture;
+        GL::Framebuffer _layeredFramebuffer{NoCreate};
+        ShadowCasterShader _layeredShader{NoCreate};
+        GL::Texture2DArray _staticTexture{NoCreate};
+        Vector2i _size;
+        bool _layered{}, _staticCaching{}, _staticCastersDirty{};
+        UnsignedInt _drawCallCount{}, _staticRedrawCount{}, _staticScrollCount{};
+        Containers::Pointer<JobPool> _jobPool;
+
+        /* Static casters indexed for culling, the group they're from and
+           indices of dynamic casters in it, which are tested every frame */
+        CasterBvh _staticCasterBvh;
+        SceneGraph::DrawableGroup3D* _indexedDrawables{};
+        std::size_t _indexedDrawableCount{};
+        std::vector<UnsignedInt> _dynamicCasters;
+        std::vector<Matrix4> _dynamicCasterTransformations;
+        CullingSpheres _dynamicCasterSpheres;
+        bool _staticCasterBvhDirty{true};
+
+        /* Drawables visible in at least one layer and their absolute
+           transformations, indices into these for each layer and a lookup
+           from drawable indices used to build them */
+        std::vector<UnsignedInt> _candidates;
+        std::vector<Matrix4> _candidateTransformations;
+        std::vector<std::vector<UnsignedInt>> _layerCandidates;
+        std::vector<UnsignedInt> _candidateIndices;
 
         struct ShadowLayerData {
             GL::Framebuffer shadowFramebuffer;
@@ -117,6 +256,31 @@ class ShadowLight: public SceneGraph::Camera3D {
             Float orthographicNear, orthographicFar;
             Float cutPlane;
 
+            /* Snapped layer center in texels and the depth range snapping
+               step, used only with static caching */
+            Vector2i centreTexel;
+            Float depthStep;
+
+            /* Static caster cache and the state it was drawn with */
+            GL::Framebuffer staticFramebuffer{NoCreate};
+            Matrix3x3 staticRotation;
+            Vector2i staticCentreTexel;
+            Float staticSize, staticNear, staticFar;
+            bool staticValid{};
+
+            /* Static casters from the hierarchy and indices into dynamic
+               casters visible in the layer, filled by cullLayer() */
+            std::vector<UnsignedInt> staticHits, dynamicHits;
+
+            /* Draw lists with camera-relative transformations and the
+               projection with the extended near plane, filled by
+               prepareLayer(). Dynamic casters are separate only with static
+               caching. */
+            std::vector<ShadowCasterDrawable*> drawables, dynamicDrawables;
+            std::vector<Matrix4> transformations, dynamicTransformations;
+            Matrix4 projectionMatrix;
+            Float preparedNear;
+
             explicit ShadowLayerData(const Vector2i& size);
         };
 
@@ -33,14 +33,35 @@ uniform highp mat4 transformationProjectionMatrix;
 uniform highp mat4 shadowmapMatrix[NUM_SHADOW_MAP_LEVELS];
 
 in highp vec4 position;
+#ifdef OCTAHEDRAL_NORMALS
+in mediump vec2 normal;
+#else
 in mediump vec3 normal;
+#endif
 
 out mediump vec3 transformedNormal;
 
 out highp vec3 shadowCoords[NUM_SHADOW_MAP_LEVELS];
 
+#ifdef OCTAHEDRAL_NORMALS
+/* Unfolds the octahedron the normal was projected onto. The result isn't
+   normalized, which is done in the fragment shader. */
+mediump vec3 decodeNormal(mediump vec2 encoded) {
+    mediump vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if(normal.z < 0.0)
+        normal.xy = (1.0 - abs(normal.yx))*vec2(
+            normal.x >= 0.0 ? 1.0 : -1.0,
+            normal.y >= 0.0 ? 1.0 : -1.0);
+    return normal;
+}
+#endif
+
 void main() {
+    #ifdef OCTAHEDRAL_NORMALS
+    transformedNormal = mat3(modelMatrix)*decodeNormal(normal);
+    #else
     transformedNormal = mat3(modelMatrix)*normal;
+    #endif
 
     vec4 worldPos4 = modelMatrix * position;
     for(int i = 0; i < shadowmapMatrix.length(); i++) {
@@ -40,8 +40,8 @@ namespace Magnum { namespace Examples {
 ShadowReceiverDrawable::ShadowReceiverDrawable(SceneGraph::AbstractObject3D &object, SceneGraph::DrawableGroup3D* drawables): Drawable{object, drawables} {}
 
 void ShadowReceiverDrawable::draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D& camera) {
-    _shader->setTransformationProjectionMatrix(camera.projectionMatrix()*transformationMatrix);
-    _shader->setModelMatrix(object().transformationMatrix());
+    _shader->setTransformationProjectionMatrix(camera.projectionMatrix()*transformationMatrix*_meshTransformation);
+    _shader->setModelMatrix(object().transformationMatrix()*_meshTransformation);
 
     _mesh->draw(*_shader);
 }
@@ -31,6 +31,7 @@
 */
 
 #include <Magnum/GL/Mesh.h>
+#include <Magnum/Math/Matrix4.h>
 #include <Magnum/SceneGraph/Drawable.h>
 
 namespace Magnum { namespace Examples {
@@ -45,13 +46,30 @@ class ShadowReceiverDrawable: public SceneGraph::Drawable3D {
 
         void draw(const Matrix4 &transformationMatrix, SceneGraph::Camera3D& camera) override;
 
-        void setMesh(GL::Mesh& mesh) { _mesh = &mesh; }
+        /** @brief Mesh to use for this drawable and its bounding sphere radius */
+        void setMesh(GL::Mesh& mesh, Float radius) {
+            _mesh = &mesh;
+            _radius = radius;
+        }
+
+        Float radius() const { return _radius; }
+
+        /**
+         * @brief Transformation applied to the mesh before the object one
+         *
+         * Used for dequantizing vertex positions. Identity by default.
+         */
+        void setMeshTransformation(const Matrix4& transformation) {
+            _meshTransformation = transformation;
+        }
 
         void setShader(ShadowReceiverShader& shader) { _shader = &shader; }
 
     private:
         GL::Mesh* _mesh{};
+        Matrix4 _meshTransformation;
         ShadowReceiverShader* _shader{};
+        Float _radius;
 };
 
 }}
@@ -40,7 +40,7 @@
 
 namespace Magnum { namespace Examples {
 
-ShadowReceiverShader::ShadowReceiverShader(std::size_t numShadowLevels) {
+ShadowReceiverShader::ShadowReceiverShader(std::size_t numShadowLevels, const Flag flags): _flags{flags} {
     MAGNUM_ASSERT_GL_VERSION_SUPPORTED(GL::Version::GL330);
 
     const Utility::Resource rs{"shadow-data"};
@@ -49,6 +49,8 @@ ShadowReceiverShader::ShadowReceiverShader(std::size_t numShadowLevels) {
     GL::Shader frag{GL::Version::GL330, GL::Shader::Type::Fragment};
 
     std::string preamble = "#define NUM_SHADOW_MAP_LEVELS " + std::to_string(numShadowLevels) + "\n";
+    if(flags == Flag::OctahedralNormals)
+        preamble += "#define OCTAHEDRAL_NORMALS\n";
     vert.addSource(preamble);
     vert.addSource(rs.get("ShadowReceiver.vert"));
     frag.addSource(preamble);
@@ -41,9 +41,22 @@ class ShadowReceiverShader: public GL::AbstractShaderProgram {
         typedef Shaders::Generic3D::Position Position;
         typedef Shaders::Generic3D::Normal Normal;
 
+        /**
+         * @brief Octahedral-encoded normal
+         *
+         * Used instead of @ref Normal if @ref Flag::OctahedralNormals is set.
+         */
+        typedef GL::Attribute<Shaders::Generic3D::Normal::Location, Vector2> OctahedralNormal;
+
+        enum class Flag: UnsignedByte {
+            OctahedralNormals = 1 << 0
+        };
+
         explicit ShadowReceiverShader(NoCreateT): GL::AbstractShaderProgram{NoCreate} {}
 
-        explicit ShadowReceiverShader(std::size_t numShadowLevels);
+        explicit ShadowReceiverShader(std::size_t numShadowLevels, Flag flags = {});
+
+        Flag flags() const { return _flags; }
 
         /**
          * @brief Set transformation and projection matrix
@@ -84,6 +97,7 @@ class ShadowReceiverShader: public GL::AbstractShaderProgram {
     private:
         enum: Int { ShadowmapTextureLayer = 0 };
 
+        Flag _flags;
         Int _modelMatrixUniform,
             _transformationProjectionMatrixUniform,
             _shadowmapMatrixUniform,
@@ -28,10 +28,18 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <chrono>
+#include <cstdlib>
+#include <utility>
+#include <Corrade/Utility/Arguments.h>
 #include <Magnum/GL/Buffer.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Renderer.h>
 #include <Magnum/GL/Texture.h>
+#include <Magnum/GL/TimeQuery.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Packing.h>
+#include <Magnum/Math/Range.h>
 #include <Magnum/MeshTools/Interleave.h>
 #include <Magnum/MeshTools/CompressIndices.h>
 #include <Magnum/Platform/Sdl2Application.h>
@@ -46,7 +54,9 @@
 #include <Magnum/SceneGraph/MatrixTransformation3D.h>
 #include <Magnum/Trade/MeshData3D.h>
 
+#include "CasterBvh.h"
 #include "DebugLines.h"
+#include "FrustumCulling.h"
 #include "ShadowCasterShader.h"
 #include "ShadowReceiverShader.h"
 #include "ShadowLight.h"
@@ -61,6 +71,28 @@ constexpr const float MainCameraFar = 100.0f;
 
 using namespace Math::Literals;
 
+namespace {
+
+/* Compact vertex layout, half the size of float positions and normals */
+struct QuantizedVertex {
+    /* Relative to the mesh bounding box, normalized to the full range */
+    Math::Vector3<UnsignedShort> position;
+    UnsignedShort:16;
+    /* Signed normalized, octahedral-encoded */
+    Math::Vector2<Short> normal;
+};
+
+/* Projects the normal onto an octahedron and unfolds it into a square. Inverse
+   of decodeNormal() in ShadowReceiver.vert. */
+Vector2 encodeNormal(const Vector3& normal) {
+    const Vector3 n = normal/(Math::abs(normal.x()) + Math::abs(normal.y()) + Math::abs(normal.z()));
+    if(n.z() >= 0.0f) return n.xy();
+    return (Vector2{1.0f} - Math::abs(Vector2{n.y(), n.x()}))*
+        Vector2{n.x() >= 0.0f ? 1.0f : -1.0f, n.y() >= 0.0f ? 1.0f : -1.0f};
+}
+
+}
+
 class ShadowsExample: public Platform::Application {
     public:
         explicit ShadowsExample(const Arguments& arguments);
@@ -69,7 +101,10 @@ class ShadowsExample: public Platform::Application {
         struct Model {
             GL::Buffer indexBuffer, vertexBuffer;
             GL::Mesh mesh;
+            /* Dequantizes the positions if the mesh is quantized */
+            Matrix4 meshTransformation;
             Float radius;
+            UnsignedInt vertexCount;
         };
 
         void drawEvent() override;
@@ -80,8 +115,10 @@ class ShadowsExample: public Platform::Application {
         void keyReleaseEvent(KeyEvent &event) override;
 
         void addModel(const Trade::MeshData3D& meshData3D);
+        void drawReceivers();
         void renderDebugLines();
-        Object3D* createSceneObject(Model& model, bool makeCaster, bool makeReceiver);
+        void benchmark(UnsignedInt frameCount);
+        Object3D* createSceneObject(Model& model, bool makeCaster, bool makeReceiver, bool makeStatic = true);
         void recompileReceiverShader(std::size_t numLayers);
         void setShadowMapSize(const Vector2i& shadowMapSize);
         void setShadowSplitExponent(Float power);
@@ -92,6 +129,11 @@ class ShadowsExample: public Platform::Application {
         ShadowCasterShader _shadowCasterShader;
         ShadowReceiverShader _shadowReceiverShader{NoCreate};
 
+        /* Receiver bounding spheres and the ones visible by the camera,
+           reused every frame */
+        CullingSpheres _receiverSpheres;
+        std::vector<UnsignedInt> _visibleReceivers;
+
         DebugLines _debugLines;
 
         Object3D _shadowLightObject;
@@ -106,6 +148,10 @@ class ShadowsExample: public Platform::Application {
 
         std::vector<Model> _models;
 
+        /* Casters moving around, with their initial positions */
+        std::vector<std::pair<Object3D*, Vector3>> _dynamicObjects;
+        Deg _dynamicObjectAngle;
+
         Vector3 _mainCameraVelocity;
 
         Float _shadowBias;
@@ -113,6 +159,7 @@ class ShadowsExample: public Platform::Application {
         Vector2i _shadowMapSize;
         Int _shadowMapFaceCullMode;
         bool _shadowStaticAlignment;
+        bool _quantizeMeshes;
 };
 
 ShadowsExample::ShadowsExample(const Arguments& arguments):
@@ -129,8 +176,37 @@ ShadowsExample::ShadowsExample(const Arguments& arguments):
     _shadowMapFaceCullMode{1},
     _shadowStaticAlignment{false}
 {
+    Utility::Arguments args;
+    args.addBooleanOption("quantize").setHelp("quantize", "upload vertex data with 16-bit positions and octahedral-encoded normals")
+        .addBooleanOption("layered").setHelp("layered", "render all shadow map layers in a single pass")
+        .addBooleanOption("static-cache").setHelp("static-cache", "cache shadow maps of static casters and draw only the moving ones every frame")
+        .addOption("dynamic-casters", "0").setHelp("dynamic-casters", "add N casters circling around the scene center", "N")
+        .addOption("prepare-threads", "2").setHelp("prepare-threads", "number of worker threads preparing shadow map layers in parallel, 0 prepares them on the main thread", "N")
+        .addOption("benchmark", "0").setHelp("benchmark", "render N frames of shadow maps per layer count both per layer and in a single pass, print the statistics and exit", "N")
+        .addBooleanOption("benchmark-culling").setHelp("benchmark-culling", "compare culling of up to a million casters with and without a bounding volume hierarchy and exit")
+        .addBooleanOption("benchmark-culling-kernels").setHelp("benchmark-culling-kernels", "compare scalar and SIMD sphere culling kernels and exit")
+        .addSkippedPrefix("magnum", "engine-specific options")
+        .parse(arguments.argc, arguments.argv);
+
+    /* Doesn't need any GL state */
+    if(args.isSet("benchmark-culling")) {
+        benchmarkCasterBvh();
+        std::exit(0);
+    }
+    if(args.isSet("benchmark-culling-kernels")) {
+        benchmarkCullingKernels();
+        std::exit(0);
+    }
+    Debug{} << "Culling with the" << cullingKernelName(bestCullingKernel()) << "kernel";
+
+    _quantizeMeshes = args.isSet("quantize");
+
     _shadowLight.setupShadowmaps(3, _shadowMapSize);
-    _shadowReceiverShader = ShadowReceiverShader{_shadowLight.layerCount()};
+    _shadowLight.setLayered(args.isSet("layered"));
+    _shadowLight.setStaticCaching(args.isSet("static-cache"));
+    _shadowLight.setPreparationThreadCount(args.value<std::size_t>("prepare-threads"));
+    _shadowReceiverShader = ShadowReceiverShader{_shadowLight.layerCount(),
+        _quantizeMeshes ? ShadowReceiverShader::Flag::OctahedralNormals : ShadowReceiverShader::Flag{}};
     _shadowReceiverShader.setShadowBias(_shadowBias);
 
     GL::Renderer::enable(GL::Renderer::Feature::DepthTest);
@@ -140,6 +216,14 @@ ShadowsExample::ShadowsExample(const Arguments& arguments):
     addModel(Primitives::capsule3DSolid(1, 1, 4, 1.0f));
     addModel(Primitives::capsule3DSolid(6, 1, 9, 1.0f));
 
+    /* Compare vertex memory of the two formats */
+    std::size_t vertexCount = 0;
+    for(const Model& model: _models) vertexCount += model.vertexCount;
+    Debug() << "Vertex data take" << vertexCount*2*sizeof(Vector3)
+        << "bytes as floats and" << vertexCount*sizeof(QuantizedVertex)
+        << "bytes quantized, using"
+        << (_quantizeMeshes ? "quantized" : "floats");
+
     Object3D* ground = createSceneObject(_models[0], false, true);
     ground->setTransformation(Matrix4::scaling({100,1,100}));
 
@@ -152,6 +236,17 @@ ShadowsExample::ShadowsExample(const Arguments& arguments):
             std::rand()*100.0f/RAND_MAX - 50.0f}));
     }
 
+    for(UnsignedInt i = 0, count = args.value<UnsignedInt>("dynamic-casters"); i != count; ++i) {
+        Model& model = _models[std::rand()%_models.size()];
+        Object3D* object = createSceneObject(model, true, true, false);
+        const Vector3 position{
+            std::rand()*40.0f/RAND_MAX - 20.0f,
+            std::rand()*5.0f/RAND_MAX,
+            std::rand()*40.0f/RAND_MAX - 20.0f};
+        object->setTransformation(Matrix4::translation(position));
+        _dynamicObjects.emplace_back(object, position);
+    }
+
     _shadowLight.setupSplitDistances(MainCameraNear, MainCameraFar, _layerSplitExponent);
 
     _mainCamera.setProjectionMatrix(Matrix4::perspectiveProjection(35.0_degf,
@@ -170,21 +265,67 @@ ShadowsExample::ShadowsExample(const Arguments& arguments):
 
     _shadowLightObject.setTransformation(Matrix4::lookAt(
         {3.0f, 1.0f, 2.0f}, {}, Vector3::yAxis()));
+
+    if(const UnsignedInt frameCount = args.value<UnsignedInt>("benchmark")) {
+        benchmark(frameCount);
+        std::exit(0);
+    }
 }
 
-Object3D* ShadowsExample::createSceneObject(Model& model, bool makeCaster, bool makeReceiver) {
+void ShadowsExample::benchmark(const UnsignedInt frameCount) {
+    GL::TimeQuery timeQuery{GL::TimeQuery::Target::TimeElapsed};
+    Debug{} << "Preparing layers on" << _shadowLight.preparationThreadCount() << "worker threads";
+    const Vector3 screenDirection = _mainCameraObject.transformation()[2].xyz();
+
+    for(const UnsignedInt layerCount: {1, 2, 4, 8, 16, 32}) {
+        _shadowLight.setupShadowmaps(layerCount, _shadowMapSize);
+        _shadowLight.setupSplitDistances(MainCameraNear, MainCameraFar, _layerSplitExponent);
+        _shadowLight.setTarget({3, 2, 3}, screenDirection, _mainCamera);
+
+        for(const bool layered: {false, true}) {
+            _shadowLight.setLayered(layered);
+
+            /* Warm up first so shader compilation and driver-side setup
+               isn't measured */
+            _shadowLight.render(_shadowCasterDrawables);
+            GL::Renderer::finish();
+
+            /* CPU time is the time spent submitting, GPU time is measured
+               over all frames */
+            timeQuery.begin();
+            std::chrono::nanoseconds cpuTime{};
+            for(UnsignedInt i = 0; i != frameCount; ++i) {
+                const auto start = std::chrono::steady_clock::now();
+                _shadowLight.render(_shadowCasterDrawables);
+                cpuTime += std::chrono::steady_clock::now() - start;
+            }
+            timeQuery.end();
+            const UnsignedLong gpuTime = timeQuery.result<UnsignedLong>();
+
+            Debug{} << layerCount << "layers," << (layered ? "single pass:" : "per layer:  ")
+                << _shadowLight.drawCallCount() << "draw calls,"
+                << cpuTime.count()/1.0e6/frameCount << "ms CPU,"
+                << gpuTime/1.0e6/frameCount << "ms GPU per frame";
+        }
+    }
+}
+
+Object3D* ShadowsExample::createSceneObject(Model& model, bool makeCaster, bool makeReceiver, bool makeStatic) {
     auto* object = new Object3D(&_scene);
 
     if(makeCaster) {
         auto caster = new ShadowCasterDrawable(*object, &_shadowCasterDrawables);
         caster->setShader(_shadowCasterShader);
         caster->setMesh(model.mesh, model.radius);
+        caster->setMeshTransformation(model.meshTransformation);
+        caster->setStatic(makeStatic);
     }
 
     if(makeReceiver) {
         auto receiver = new ShadowReceiverDrawable(*object, &_shadowReceiverDrawables);
         receiver->setShader(_shadowReceiverShader);
-        receiver->setMesh(model.mesh);
+        receiver->setMesh(model.mesh, model.radius);
+        receiver->setMeshTransformation(model.meshTransformation);
     }
 
     return object;
@@ -194,8 +335,46 @@ void ShadowsExample::addModel(const Trade::MeshData3D& meshData3D) {
     _models.emplace_back();
     Model& model = _models.back();
 
-    model.vertexBuffer.setData(MeshTools::interleave(meshData3D.positions(0), meshData3D.normals(0)),
-        GL::BufferUsage::StaticDraw);
+    const std::vector<Vector3>& positions = meshData3D.positions(0);
+    const std::vector<Vector3>& normals = meshData3D.normals(0);
+    model.vertexCount = positions.size();
+
+    if(_quantizeMeshes) {
+        Range3D bounds{positions[0], positions[0]};
+        for(const Vector3& position: positions) {
+            bounds.min() = Math::min(bounds.min(), position);
+            bounds.max() = Math::max(bounds.max(), position);
+        }
+
+        /* Flat meshes have zero size along some axis, scale by one there */
+        Vector3 scale = bounds.size();
+        for(std::size_t i = 0; i != 3; ++i)
+            if(!(scale[i] > 0.0f)) scale[i] = 1.0f;
+        model.meshTransformation = Matrix4::translation(bounds.min())*Matrix4::scaling(scale);
+
+        /* The mesh transformation scales the normals as well, so divide them
+           by the scale before encoding */
+        Containers::Array<QuantizedVertex> vertices{Containers::ValueInit, positions.size()};
+        for(std::size_t i = 0; i != positions.size(); ++i) {
+            vertices[i].position = Math::pack<Math::Vector3<UnsignedShort>>(
+                Math::clamp((positions[i] - bounds.min())/scale, 0.0f, 1.0f));
+            vertices[i].normal = Math::pack<Math::Vector2<Short>>(
+                encodeNormal((normals[i]/scale).normalized()));
+        }
+
+        model.vertexBuffer.setData(vertices, GL::BufferUsage::StaticDraw);
+        model.mesh.addVertexBuffer(model.vertexBuffer, 0,
+            Shaders::Phong::Position{
+                Shaders::Phong::Position::DataType::UnsignedShort,
+                Shaders::Phong::Position::DataOption::Normalized}, 2,
+            ShadowReceiverShader::OctahedralNormal{
+                ShadowReceiverShader::OctahedralNormal::DataType::Short,
+                ShadowReceiverShader::OctahedralNormal::DataOption::Normalized});
+    } else {
+        model.vertexBuffer.setData(MeshTools::interleave(positions, normals),
+            GL::BufferUsage::StaticDraw);
+        model.mesh.addVertexBuffer(model.vertexBuffer, 0, Shaders::Phong::Position{}, Shaders::Phong::Normal{});
+    }
 
     Float maxMagnitudeSquared = 0.0f;
     for(Vector3 position: meshData3D.positions(0)) {
@@ -215,7 +394,6 @@ void ShadowsExample::addModel(const Trade::MeshData3D& meshData3D) {
 
     model.mesh.setPrimitive(meshData3D.primitive())
         .setCount(meshData3D.indices().size())
-        .addVertexBuffer(model.vertexBuffer, 0, Shaders::Phong::Position{}, Shaders::Phong::Normal{})
         .setIndexBuffer(model.indexBuffer, 0, indexType, indexStart, indexEnd);
 }
 
@@ -227,6 +405,14 @@ void ShadowsExample::drawEvent() {
         redraw();
     }
 
+    /* Dynamic casters keep moving, so keep redrawing */
+    if(!_dynamicObjects.empty()) {
+        _dynamicObjectAngle += 0.5_degf;
+        for(const std::pair<Object3D*, Vector3>& object: _dynamicObjects)
+            object.first->setTransformation(Matrix4::rotationY(_dynamicObjectAngle)*Matrix4::translation(object.second));
+        redraw();
+    }
+
     const Vector3 screenDirection = _shadowStaticAlignment ? Vector3::zAxis() : _mainCameraObject.transformation()[2].xyz();
     /* You only really need to do this when your camera moves */
     _shadowLight.setTarget({3, 2, 3}, screenDirection, _mainCamera);
@@ -265,13 +451,39 @@ void ShadowsExample::drawEvent() {
         .setShadowmapTexture(_shadowLight.shadowTexture())
         .setLightDirection(_shadowLightObject.transformation().backward());
 
-    _activeCamera->draw(_shadowReceiverDrawables);
+    drawReceivers();
 
     renderDebugLines();
 
     swapBuffers();
 }
 
+void ShadowsExample::drawReceivers() {
+    /* Same as SceneGraph::Camera3D::draw(), except that receivers outside of
+       the camera frustum are culled first */
+    std::vector<std::reference_wrapper<Object3D>> objects;
+    objects.reserve(_shadowReceiverDrawables.size());
+    for(std::size_t i = 0; i != _shadowReceiverDrawables.size(); ++i)
+        objects.push_back(static_cast<Object3D&>(_shadowReceiverDrawables[i].object()));
+    const std::vector<Matrix4> transformations = _scene.transformationMatrices(objects, _activeCamera->cameraMatrix());
+
+    /* Objects can be scaled, such as the ground, so scale the radius by the
+       largest axis */
+    _receiverSpheres.clear();
+    for(std::size_t i = 0; i != transformations.size(); ++i) {
+        const Matrix3x3 rotationScaling = transformations[i].rotationScaling();
+        const Float scaling = std::sqrt(Math::max(Math::max(
+            rotationScaling[0].dot(), rotationScaling[1].dot()), rotationScaling[2].dot()));
+        _receiverSpheres.add(transformations[i].translation(),
+            static_cast<ShadowReceiverDrawable&>(_shadowReceiverDrawables[i]).radius()*scaling);
+    }
+
+    const std::vector<Vector4> planes = frustumPlanes(_activeCamera->projectionMatrix());
+    cullSpheres(_receiverSpheres, Containers::arrayView(planes.data(), planes.size()), _visibleReceivers);
+    for(const UnsignedInt i: _visibleReceivers)
+        _shadowReceiverDrawables[i].draw(transformations[i], *_activeCamera);
+}
+
 void ShadowsExample::renderDebugLines() {
     if(_activeCamera != &_debugCamera)
         return;
@@ -395,6 +607,16 @@ void ShadowsExample::keyPressEvent(KeyEvent& event) {
             Debug() << "Shadow map size" << _shadowMapSize << "x" << _shadowLight.layerCount() << "layers";
         } else return;
 
+    } else if(event.key() == KeyEvent::Key::C) {
+        _shadowLight.setStaticCaching(!_shadowLight.isStaticCaching());
+        Debug() << "Static shadow caster caching:"
+            << (_shadowLight.isStaticCaching() ? "on" : "off");
+
+    } else if(event.key() == KeyEvent::Key::L) {
+        _shadowLight.setLayered(!_shadowLight.isLayered());
+        Debug() << "Shadow map rendering:"
+            << (_shadowLight.isLayered() ? "single pass" : "per layer");
+
     } else if(event.key() == KeyEvent::Key::F11) {
         setShadowMapSize(_shadowMapSize/2);
 
@@ -427,7 +649,7 @@ void ShadowsExample::setShadowMapSize(const Vector2i& shadowMapSize) {
 }
 
 void ShadowsExample::recompileReceiverShader(const std::size_t numLayers) {
-    _shadowReceiverShader = ShadowReceiverShader{numLayers};
+    _shadowReceiverShader = ShadowReceiverShader{numLayers, _shadowReceiverShader.flags()};
     _shadowReceiverShader.setShadowBias(_shadowBias);
     for(std::size_t i = 0; i != _shadowReceiverDrawables.size(); ++i) {
         auto& drawable = static_cast<ShadowReceiverDrawable&>(_shadowReceiverDrawables[i]);
@@ -0,0 +1,99 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "Deduplicator.h"
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/Mesh.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/Sampler.h>
+#include <Magnum/Trade/MeshData3D.h>
+#include <Magnum/Trade/TextureData.h>
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+template<class T> void hash(Utility::Sha1& sha1, const T& value) {
+    sha1 << Containers::ArrayView<const char>{reinterpret_cast<const char*>(&value), sizeof(T)};
+}
+
+/* Prefixed with the size so the boundaries between arrays are unambiguous */
+template<class T> void hash(Utility::Sha1& sha1, const std::vector<T>& values) {
+    hash(sha1, UnsignedLong(values.size()));
+    sha1 << Containers::ArrayView<const char>{reinterpret_cast<const char*>(values.data()), values.size()*sizeof(T)};
+}
+
+}
+
+Deduplicator::Deduplicator(const UnsignedInt count): _remap(count) {
+    for(UnsignedInt i = 0; i != count; ++i) _remap[i] = i;
+}
+
+UnsignedInt Deduplicator::add(const UnsignedInt id, const Utility::Sha1::Digest& digest) {
+    const auto inserted = _unique.emplace(digest.hexString(), id);
+    if(!inserted.second) ++_duplicateCount;
+    return _remap[id] = inserted.first->second;
+}
+
+Utility::Sha1::Digest meshDigest(const Trade::MeshData3D& data) {
+    Utility::Sha1 sha1;
+    hash(sha1, data.primitive());
+    hash(sha1, UnsignedInt(data.positionArrayCount()));
+    for(UnsignedInt i = 0; i != data.positionArrayCount(); ++i)
+        hash(sha1, data.positions(i));
+    hash(sha1, UnsignedInt(data.normalArrayCount()));
+    for(UnsignedInt i = 0; i != data.normalArrayCount(); ++i)
+        hash(sha1, data.normals(i));
+    hash(sha1, UnsignedInt(data.textureCoords2DArrayCount()));
+    for(UnsignedInt i = 0; i != data.textureCoords2DArrayCount(); ++i)
+        hash(sha1, data.textureCoords2D(i));
+    hash(sha1, UnsignedInt(data.colorArrayCount()));
+    for(UnsignedInt i = 0; i != data.colorArrayCount(); ++i)
+        hash(sha1, data.colors(i));
+    hash(sha1, data.isIndexed());
+    if(data.isIndexed()) hash(sha1, data.indices());
+    return sha1.digest();
+}
+
+Utility::Sha1::Digest textureDigest(const Trade::TextureData& texture, const ImageView2D& image) {
+    Utility::Sha1 sha1;
+    hash(sha1, texture.magnificationFilter());
+    hash(sha1, texture.minificationFilter());
+    hash(sha1, texture.mipmapFilter());
+    hash(sha1, texture.wrapping());
+    hash(sha1, image.format());
+    hash(sha1, image.size());
+    hash(sha1, image.storage().alignment());
+    sha1 << image.data();
+    return sha1.digest();
+}
+
+}}
@@ -0,0 +1,95 @@
+#ifndef Magnum_Examples_Deduplicator_h
+#define Magnum_Examples_Deduplicator_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <Corrade/Utility/Sha1.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Trade/Trade.h>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Finds resources with identical contents
+
+Resources are identified by a SHA-1 digest of their contents. Each resource is
+mapped either to itself or, if a resource with the same digest was added
+before, to that one, so references to duplicates can be pointed to a single
+copy.
+*/
+class Deduplicator {
+    public:
+        /**
+         * @brief Constructor
+         *
+         * Until added, every resource is mapped to itself.
+         */
+        explicit Deduplicator(UnsignedInt count);
+
+        /**
+         * @brief Add a resource
+         *
+         * Returns ID of the first added resource with the same @p digest,
+         * which is @p id itself if the contents are unique.
+         */
+        UnsignedInt add(UnsignedInt id, const Utility::Sha1::Digest& digest);
+
+        /** @brief Resource to use in place of @p id */
+        UnsignedInt operator[](UnsignedInt id) const { return _remap[id]; }
+
+        /** @brief Count of resources found to be duplicates */
+        UnsignedInt duplicateCount() const { return _duplicateCount; }
+
+    private:
+        std::unordered_map<std::string, UnsignedInt> _unique;
+        std::vector<UnsignedInt> _remap;
+        UnsignedInt _duplicateCount{};
+};
+
+/**
+@brief Digest of mesh contents
+
+Includes the primitive, all attributes and indices.
+*/
+Utility::Sha1::Digest meshDigest(const Trade::MeshData3D& data);
+
+/**
+@brief Digest of texture contents
+
+Includes the sampler state and the pixel data along with their format and
+size.
+*/
+Utility::Sha1::Digest textureDigest(const Trade::TextureData& texture, const ImageView2D& image);
+
+}}
+
+#endif
@@ -0,0 +1,129 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "FrameAccumulator.h"
+
+#include <Magnum/GL/DefaultFramebuffer.h>
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/GL/TextureFormat.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Range.h>
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+/* Radical inverse of i in given base, giving a well-distributed sequence in
+   [0, 1) */
+Float halton(UnsignedInt i, const UnsignedInt base) {
+    Float result = 0.0f, factor = 1.0f;
+    for(; i; i /= base) {
+        factor /= base;
+        result += factor*(i % base);
+    }
+    return result;
+}
+
+}
+
+FrameAccumulator::FrameAccumulator(const Vector2i& size) {
+    struct Vertex {
+        Vector2 position;
+        Vector2 textureCoordinates;
+    };
+    const Vertex vertices[]{
+        {{ 1.0f, -1.0f}, {1.0f, 0.0f}},
+        {{ 1.0f,  1.0f}, {1.0f, 1.0f}},
+        {{-1.0f, -1.0f}, {0.0f, 0.0f}},
+        {{-1.0f,  1.0f}, {0.0f, 1.0f}}
+    };
+    _quadBuffer.setData(vertices, GL::BufferUsage::StaticDraw);
+    _quad.setPrimitive(GL::MeshPrimitive::TriangleStrip)
+        .setCount(4)
+        .addVertexBuffer(_quadBuffer, 0,
+            Shaders::Flat2D::Position{},
+            Shaders::Flat2D::TextureCoordinates{});
+
+    setSize(size);
+}
+
+void FrameAccumulator::setSize(const Vector2i& size) {
+    /* The frame is resolved from the multisampled default framebuffer, the
+       average needs more precision than eight bits to not band */
+    _frameTexture = GL::Texture2D{};
+    _frameTexture.setMinificationFilter(GL::SamplerFilter::Nearest)
+        .setMagnificationFilter(GL::SamplerFilter::Nearest)
+        .setWrapping(GL::SamplerWrapping::ClampToEdge)
+        .setStorage(1, GL::TextureFormat::RGBA8, size);
+    _accumulationTexture = GL::Texture2D{};
+    _accumulationTexture.setMinificationFilter(GL::SamplerFilter::Nearest)
+        .setMagnificationFilter(GL::SamplerFilter::Nearest)
+        .setWrapping(GL::SamplerWrapping::ClampToEdge)
+        .setStorage(1, GL::TextureFormat::RGBA16F, size);
+
+    _frameFramebuffer = GL::Framebuffer{{{}, size}};
+    _frameFramebuffer.attachTexture(GL::Framebuffer::ColorAttachment{0}, _frameTexture, 0);
+    _accumulationFramebuffer = GL::Framebuffer{{{}, size}};
+    _accumulationFramebuffer.attachTexture(GL::Framebuffer::ColorAttachment{0}, _accumulationTexture, 0);
+
+    reset();
+}
+
+Vector2 FrameAccumulator::jitter() const {
+    if(!_frameCount) return {};
+    return Vector2{halton(_frameCount, 2), halton(_frameCount, 3)} - Vector2{0.5f};
+}
+
+void FrameAccumulator::accumulate() {
+    const Range2Di rectangle = _frameFramebuffer.viewport();
+
+    /* Resolve the multisampled frame */
+    GL::AbstractFramebuffer::blit(GL::defaultFramebuffer, _frameFramebuffer,
+        rectangle, GL::FramebufferBlit::Color);
+
+    /* Blend it into the running average with a weight of 1/(n + 1) */
+    GL::Renderer::disable(GL::Renderer::Feature::DepthTest);
+    GL::Renderer::enable(GL::Renderer::Feature::Blending);
+    GL::Renderer::setBlendFunction(
+        GL::Renderer::BlendFunction::ConstantAlpha,
+        GL::Renderer::BlendFunction::OneMinusConstantAlpha);
+    GL::Renderer::setBlendColor({0.0f, 0.0f, 0.0f, 1.0f/(_frameCount + 1)});
+    _accumulationFramebuffer.bind();
+    _quad.draw(_shader.bindTexture(_frameTexture));
+    GL::Renderer::disable(GL::Renderer::Feature::Blending);
+
+    /* Show the average */
+    GL::defaultFramebuffer.bind();
+    _quad.draw(_shader.bindTexture(_accumulationTexture));
+    GL::Renderer::enable(GL::Renderer::Feature::DepthTest);
+
+    ++_frameCount;
+}
+
+}}
@@ -0,0 +1,90 @@
+#ifndef Magnum_Examples_FrameAccumulator_h
+#define Magnum_Examples_FrameAccumulator_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Framebuffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/Texture.h>
+#include <Magnum/Math/Vector2.h>
+#include <Magnum/Shaders/Flat.h>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Progressive supersampling of a still frame
+
+Averages consecutive frames rendered with sub-pixel offsets into a
+floating-point texture. Render each frame to the default framebuffer as usual,
+with the projection shifted by @ref jitter(), and call @ref accumulate()
+afterwards. It resolves the frame into a texture, adds it to the running
+average and draws the average back to the default framebuffer. Call
+@ref reset() whenever the scene changes to start over.
+*/
+class FrameAccumulator {
+    public:
+        explicit FrameAccumulator(const Vector2i& size);
+
+        /** @brief Resize the textures, implies @ref reset() */
+        void setSize(const Vector2i& size);
+
+        void reset() { _frameCount = 0; }
+
+        /** @brief Count of frames accumulated since the last @ref reset() */
+        UnsignedInt frameCount() const { return _frameCount; }
+
+        /**
+         * @brief Sub-pixel offset of the next frame
+         *
+         * In pixels, in range @f$ [-0.5, 0.5] @f$. Zero for the first frame
+         * so it matches a frame rendered without accumulation, a Halton
+         * sequence for the following ones.
+         */
+        Vector2 jitter() const;
+
+        /**
+         * @brief Accumulate contents of the default framebuffer
+         *
+         * Expects the default framebuffer to be bound, leaves it bound.
+         */
+        void accumulate();
+
+    private:
+        GL::Texture2D _frameTexture, _accumulationTexture;
+        GL::Framebuffer _frameFramebuffer{NoCreate}, _accumulationFramebuffer{NoCreate};
+        GL::Buffer _quadBuffer;
+        GL::Mesh _quad;
+        Shaders::Flat2D _shader{Shaders::Flat2D::Flag::Textured};
+        UnsignedInt _frameCount{};
+};
+
+}}
+
+#endif
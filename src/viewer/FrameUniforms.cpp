@@ -0,0 +1,58 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "FrameUniforms.h"
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/GL/Context.h>
+#include <Magnum/GL/Version.h>
+
+namespace Magnum { namespace Examples {
+
+bool FrameUniforms::isSupported() {
+    #ifndef MAGNUM_TARGET_GLES
+    return GL::Context::current().isVersionSupported(GL::Version::GL330);
+    #elif !defined(MAGNUM_TARGET_GLES2)
+    return true;
+    #else
+    return false;
+    #endif
+}
+
+FrameUniforms::FrameUniforms(): _buffer{GL::Buffer::TargetHint::Uniform} {
+    _buffer.setData({nullptr, sizeof(Data)}, GL::BufferUsage::DynamicDraw);
+}
+
+void FrameUniforms::update(const Matrix4& projectionMatrix, const Vector3& lightPosition) {
+    const Data data{projectionMatrix, Vector4{lightPosition, 1.0f}};
+    _buffer.setSubData(0, Containers::arrayView(&data, 1));
+    _buffer.bind(GL::Buffer::Target::Uniform, Binding);
+}
+
+}}
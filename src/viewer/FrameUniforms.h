@@ -0,0 +1,88 @@
+#ifndef Magnum_Examples_FrameUniforms_h
+#define Magnum_Examples_FrameUniforms_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/Math/Matrix4.h>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Per-frame shader data in a uniform buffer
+
+Projection matrix and light position are the same for all draws in a frame.
+Instead of setting them on every shader, they're uploaded once per frame into
+a uniform buffer bound to @ref Binding, which all shaders declaring the
+@glsl Frame @ce uniform block from @cb{.sh} FrameUniforms.glsl @ce read from.
+Per-draw uniform traffic is then just the transformation and normal matrix
+and the color.
+*/
+class FrameUniforms {
+    public:
+        enum: UnsignedInt {
+            Binding = 0     /**< Uniform buffer binding point */
+        };
+
+        /**
+         * @brief Whether uniform buffers are supported
+         *
+         * Requires OpenGL 3.3 on desktop, which the shaders using the block
+         * are written for, always available on OpenGL ES 3.0 and WebGL 2.
+         */
+        static bool isSupported();
+
+        explicit FrameUniforms();
+
+        /**
+         * @brief Upload the data for the current frame
+         * @param projectionMatrix  Camera projection matrix
+         * @param lightPosition     Camera-space light position
+         *
+         * Call once per frame before any draw and after all other code
+         * that may bind a different uniform buffer to @ref Binding.
+         */
+        void update(const Matrix4& projectionMatrix, const Vector3& lightPosition);
+
+        /** @brief Bytes uploaded in the last @ref update() */
+        UnsignedInt uploadSize() const { return sizeof(Data); }
+
+    private:
+        /* Matches the std140 layout of the GLSL block */
+        struct Data {
+            Matrix4 projectionMatrix;
+            Vector4 lightPosition;
+        };
+
+        GL::Buffer _buffer;
+};
+
+}}
+
+#endif
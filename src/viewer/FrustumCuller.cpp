@@ -0,0 +1,194 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <numeric>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/SceneGraph/Camera.h>
+#include <Magnum/SceneGraph/MatrixTransformation3D.h>
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+/* Max count of drawables in a leaf node */
+constexpr UnsignedInt LeafSize = 4;
+
+}
+
+FrustumCuller::FrustumCuller(Object3D& root, const TransformCache& transforms): _root(root), _transforms(transforms) {}
+
+void FrustumCuller::add(SceneGraph::Drawable3D& drawable, const UnsignedInt transform, const Range3D& bounds, const Int occluder) {
+    _items.push_back({&drawable, transform, bounds, {}, occluder});
+}
+
+Range3D FrustumCuller::transformBounds(const Matrix4& transformation, const Range3D& bounds) {
+    /* Enclose all eight transformed corners. Not using Math::join(), as
+       that ignores zero-size ranges such as single points. */
+    const Vector3 first = transformation.transformPoint(bounds.min());
+    Vector3 min = first, max = first;
+    for(std::size_t i = 1; i != 8; ++i) {
+        const Vector3 corner = transformation.transformPoint({
+            (i & 1 ? bounds.max() : bounds.min()).x(),
+            (i & 2 ? bounds.max() : bounds.min()).y(),
+            (i & 4 ? bounds.max() : bounds.min()).z()});
+        min = Math::min(min, corner);
+        max = Math::max(max, corner);
+    }
+    return {min, max};
+}
+
+void FrustumCuller::build() {
+    /* Calculate bounds of all drawables relative to the root */
+    for(Item& item: _items)
+        item.bounds = transformBounds(_transforms.absoluteTransformation(item.transform), item.localBounds);
+
+    _order.resize(_items.size());
+    std::iota(_order.begin(), _order.end(), 0);
+    _nodes.clear();
+    _nodes.reserve(2*_items.size()/LeafSize + 1);
+    if(!_items.empty()) buildNode(0, _items.size());
+}
+
+UnsignedInt FrustumCuller::buildNode(const UnsignedInt first, const UnsignedInt count) {
+    const UnsignedInt id = _nodes.size();
+    Range3D bounds = _items[_order[first]].bounds;
+    Vector3 centerMin = bounds.center(), centerMax = bounds.center();
+    for(UnsignedInt i = first + 1; i != first + count; ++i) {
+        const Range3D& itemBounds = _items[_order[i]].bounds;
+        bounds.min() = Math::min(bounds.min(), itemBounds.min());
+        bounds.max() = Math::max(bounds.max(), itemBounds.max());
+        centerMin = Math::min(centerMin, itemBounds.center());
+        centerMax = Math::max(centerMax, itemBounds.center());
+    }
+    _nodes.push_back({bounds, 0, first, count});
+    if(count <= LeafSize) return id;
+
+    /* Split at the median along the longest axis of the centers */
+    const Vector3 size = centerMax - centerMin;
+    const std::size_t axis = size.x() > size.y() ?
+        (size.x() > size.z() ? 0 : 2) : (size.y() > size.z() ? 1 : 2);
+    const UnsignedInt half = count/2;
+    std::nth_element(_order.begin() + first, _order.begin() + first + half, _order.begin() + first + count,
+        [this, axis](UnsignedInt a, UnsignedInt b) {
+            return _items[a].bounds.center()[axis] < _items[b].bounds.center()[axis];
+        });
+
+    /* The left child gets ID right after this one, we need to remember only
+       the right one */
+    buildNode(first, half);
+    const UnsignedInt right = buildNode(first + half, count - half);
+    _nodes[id].right = right;
+    return id;
+}
+
+FrustumCuller::Intersection FrustumCuller::intersect(const Vector4 (&planes)[6], const Range3D& bounds) {
+    Intersection result = Intersection::Inside;
+    for(const Vector4& plane: planes) {
+        /* Corners furthest along and against the plane normal */
+        Vector3 positive, negative;
+        for(std::size_t i = 0; i != 3; ++i) {
+            const bool along = plane[i] >= 0.0f;
+            positive[i] = along ? bounds.max()[i] : bounds.min()[i];
+            negative[i] = along ? bounds.min()[i] : bounds.max()[i];
+        }
+
+        if(Math::dot(plane.xyz(), positive) + plane.w() < 0.0f)
+            return Intersection::Outside;
+        if(Math::dot(plane.xyz(), negative) + plane.w() < 0.0f)
+            result = Intersection::Partial;
+    }
+
+    return result;
+}
+
+void FrustumCuller::draw(SceneGraph::Camera3D& camera) {
+    _visible.clear();
+    _occludedCount = 0;
+    if(_nodes.empty()) return;
+
+    /* Extract frustum planes in root space. Transforming the frustum instead
+       of the bounds is what makes rotation of the root free. */
+    const Matrix4 matrix = camera.projectionMatrix()*camera.cameraMatrix()*_root.absoluteTransformationMatrix();
+    Vector4 planes[6];
+    for(std::size_t i = 0; i != 3; ++i) {
+        planes[2*i + 0] = matrix.row(3) + matrix.row(i);
+        planes[2*i + 1] = matrix.row(3) - matrix.row(i);
+    }
+
+    /* Walk the tree. Subtrees completely inside are added without testing
+       their children. */
+    _stack.clear();
+    _stack.push_back(0);
+    while(!_stack.empty()) {
+        const UnsignedInt id = _stack.back();
+        _stack.pop_back();
+        const Node& node = _nodes[id];
+
+        const Intersection intersection = intersect(planes, node.bounds);
+        if(intersection == Intersection::Outside) continue;
+
+        if(intersection == Intersection::Inside || !node.right) {
+            _visible.insert(_visible.end(), _order.begin() + node.first, _order.begin() + node.first + node.count);
+            continue;
+        }
+
+        _stack.push_back(node.right);
+        _stack.push_back(id + 1);
+    }
+
+    /* Rasterize the largest visible occluders and drop everything hidden
+       behind them */
+    if(_occlusionCuller) {
+        _occlusionCuller->begin(camera.projectionMatrix(), camera.cameraMatrix()*_root.absoluteTransformationMatrix(), camera.viewport());
+        for(UnsignedInt id: _visible) if(_items[id].occluder != -1)
+            _occlusionCuller->addOccluder(_items[id].occluder, _transforms.absoluteTransformation(_items[id].transform), _items[id].bounds);
+        _occlusionCuller->rasterize();
+
+        const auto end = std::remove_if(_visible.begin(), _visible.end(), [this](UnsignedInt id) {
+            return !_occlusionCuller->isVisible(_items[id].bounds);
+        });
+        _occludedCount = _visible.end() - end;
+        _visible.erase(end, _visible.end());
+    }
+
+    /* Calculate transformations only for the visible drawables and draw them */
+    _visibleTransforms.clear();
+    for(UnsignedInt id: _visible) _visibleTransforms.push_back(_items[id].transform);
+    _transformations.resize(_visible.size());
+    _transforms.transformations(camera.cameraMatrix()*_root.absoluteTransformationMatrix(),
+        Containers::arrayView(_visibleTransforms.data(), _visibleTransforms.size()),
+        Containers::arrayView(_transformations.data(), _transformations.size()));
+    for(std::size_t i = 0; i != _visible.size(); ++i)
+        _items[_visible[i]].drawable->draw(_transformations[i], camera);
+}
+
+}}
@@ -0,0 +1,158 @@
+#ifndef Magnum_Examples_FrustumCuller_h
+#define Magnum_Examples_FrustumCuller_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Magnum/Math/Range.h>
+#include <Magnum/SceneGraph/Drawable.h>
+
+#include "OcclusionCuller.h"
+#include "TransformCache.h"
+#include "Types.h"
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Culls drawables against the camera frustum using a bounding volume hierarchy
+
+The hierarchy is built over axis-aligned bounding boxes of all drawables,
+expressed relative to a common root object. Transforming the root object ---
+such as rotating the whole scene --- thus doesn't invalidate the hierarchy, as
+the frustum is transformed into the root space instead. If objects move
+relative to the root, the hierarchy needs to be rebuilt with @ref build().
+
+Transformations of the drawables relative to the root are taken from a
+@ref TransformCache instead of the scene graph, which has to be up to date
+before calling @ref build() or @ref draw().
+*/
+class FrustumCuller {
+    public:
+        /**
+         * @brief Constructor
+         * @param root          Object that's a common parent of all
+         *      drawables
+         * @param transforms    Transformations relative to @p root
+         */
+        explicit FrustumCuller(Object3D& root, const TransformCache& transforms);
+
+        /**
+         * @brief Add a drawable
+         * @param drawable  Drawable. Its object has to be a descendant of the
+         *      root object.
+         * @param transform Node in the transformation cache corresponding to
+         *      the drawable object
+         * @param bounds    Bounding box in the drawable object space
+         * @param occluder  Mesh ID to use as an occluder if the drawable is
+         *      visible, or @cpp -1 @ce
+         *
+         * Call @ref build() after all drawables are added.
+         */
+        void add(SceneGraph::Drawable3D& drawable, UnsignedInt transform, const Range3D& bounds, Int occluder = -1);
+
+        /**
+         * @brief Set an occlusion culler
+         *
+         * If set, drawables inside the frustum are additionally tested
+         * against the occluders among them in @ref draw().
+         */
+        void setOcclusionCuller(OcclusionCuller* culler) {
+            _occlusionCuller = culler;
+        }
+
+        /** @brief Build the hierarchy from drawables added so far */
+        void build();
+
+        /**
+         * @brief Draw all drawables intersecting the camera frustum
+         *
+         * Equivalent to @ref SceneGraph::Camera3D::draw(), except that
+         * drawables outside of the frustum are not drawn at all and the
+         * transformations of visible ones are calculated in a batch from the
+         * transformation cache.
+         */
+        void draw(SceneGraph::Camera3D& camera);
+
+        /** @brief Count of drawables drawn in the last @ref draw() */
+        std::size_t visibleCount() const { return _visible.size(); }
+
+        /**
+         * @brief Count of drawables outside of the frustum in the last
+         *      @ref draw()
+         */
+        std::size_t culledCount() const {
+            return _items.size() - _visible.size() - _occludedCount;
+        }
+
+        /** @brief Count of occluded drawables in the last @ref draw() */
+        std::size_t occludedCount() const { return _occludedCount; }
+
+    private:
+        struct Item {
+            SceneGraph::Drawable3D* drawable;
+            UnsignedInt transform;
+            Range3D localBounds;
+            Range3D bounds;
+            Int occluder;
+        };
+
+        struct Node {
+            Range3D bounds;
+            /* The left child directly follows the node, the right child is
+               zero for leaves (the root can't be a right child) */
+            UnsignedInt right;
+            /* Range in _order covered by the whole subtree */
+            UnsignedInt first, count;
+        };
+
+        enum class Intersection { Outside, Inside, Partial };
+
+        static Range3D transformBounds(const Matrix4& transformation, const Range3D& bounds);
+        static Intersection intersect(const Vector4 (&planes)[6], const Range3D& bounds);
+
+        UnsignedInt buildNode(UnsignedInt first, UnsignedInt count);
+
+        Object3D& _root;
+        const TransformCache& _transforms;
+        OcclusionCuller* _occlusionCuller{};
+        std::size_t _occludedCount{};
+        std::vector<Item> _items;
+        std::vector<UnsignedInt> _order;
+        std::vector<Node> _nodes;
+
+        /* Reused between frames to avoid allocations */
+        std::vector<UnsignedInt> _stack;
+        std::vector<UnsignedInt> _visible;
+        std::vector<UnsignedInt> _visibleTransforms;
+        std::vector<Matrix4> _transformations;
+};
+
+}}
+
+#endif
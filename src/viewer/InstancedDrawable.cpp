@@ -0,0 +1,122 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "InstancedDrawable.h"
+
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/GL/Context.h>
+#include <Magnum/GL/Extensions.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/Texture.h>
+#include <Magnum/GL/TextureArray.h>
+
+namespace Magnum { namespace Examples {
+
+bool InstanceRenderer::isSupported() {
+    #ifndef MAGNUM_TARGET_GLES
+    return GL::Context::current().isVersionSupported(GL::Version::GL330) &&
+        GL::Context::current().isExtensionSupported<GL::Extensions::ARB::base_instance>();
+    #else
+    return false;
+    #endif
+}
+
+InstanceRenderer::InstanceRenderer(const bool textureArrays): _texturedShader{InstancedShader::Flag::Textured}, _textureArrayShader{NoCreate} {
+    if(textureArrays)
+        _textureArrayShader = InstancedShader{InstancedShader::Flag::TextureArray};
+}
+
+InstanceBatch& InstanceRenderer::batch(GL::Mesh& mesh, GL::Texture2D* texture) {
+    return batch(mesh, texture, nullptr);
+}
+
+InstanceBatch& InstanceRenderer::batch(GL::Mesh& mesh, GL::Texture2DArray& textureArray) {
+    CORRADE_INTERNAL_ASSERT(_textureArrayShader.id());
+    return batch(mesh, nullptr, &textureArray);
+}
+
+InstanceBatch& InstanceRenderer::batch(GL::Mesh& mesh, GL::Texture2D* texture, GL::Texture2DArray* textureArray) {
+    Containers::Pointer<InstanceBatch>& batch = _batches[std::make_tuple(texture, textureArray, &mesh)];
+    if(batch) return *batch;
+
+    /* Attach the instance buffer to the mesh the first time it's used. The
+       attributes don't conflict with anything the non-instanced shaders use,
+       so the mesh can still be drawn the usual way. */
+    if(_meshes.insert(&mesh).second)
+        mesh.addVertexBufferInstanced(_instanceBuffer, 1, 0,
+            InstancedShader::TransformationMatrix{},
+            InstancedShader::NormalMatrix{},
+            InstancedShader::TextureLayer{});
+
+    batch.reset(new InstanceBatch{mesh, texture, textureArray});
+    return *batch;
+}
+
+void InstanceRenderer::draw() {
+    /* Gather instances of all batches into a single buffer */
+    _drawCallCount = 0;
+    _instanceData.clear();
+    for(auto& batch: _batches) {
+        std::vector<InstanceBatch::Instance>& instances = batch.second->instances();
+        _instanceData.insert(_instanceData.end(), instances.begin(), instances.end());
+    }
+    if(_instanceData.empty()) return;
+    _instanceBuffer.setData(Containers::arrayView(_instanceData.data(), _instanceData.size()), GL::BufferUsage::StreamDraw);
+
+    std::size_t offset = 0;
+    for(auto& batch: _batches) {
+        std::vector<InstanceBatch::Instance>& instances = batch.second->instances();
+        if(instances.empty()) continue;
+
+        GL::Mesh& mesh = batch.second->mesh();
+        mesh.setInstanceCount(instances.size());
+        #ifndef MAGNUM_TARGET_GLES
+        mesh.setBaseInstance(offset);
+        #endif
+
+        if(GL::Texture2D* texture = batch.second->texture())
+            mesh.draw(_texturedShader.bindDiffuseTexture(*texture));
+        else if(GL::Texture2DArray* textureArray = batch.second->textureArray())
+            mesh.draw(_textureArrayShader.bindDiffuseTexture(*textureArray));
+        else
+            mesh.draw(_coloredShader);
+
+        /* Reset back so the mesh can be drawn without instancing as well */
+        mesh.setInstanceCount(1);
+        #ifndef MAGNUM_TARGET_GLES
+        mesh.setBaseInstance(0);
+        #endif
+
+        offset += instances.size();
+        instances.clear();
+        ++_drawCallCount;
+    }
+}
+
+}}
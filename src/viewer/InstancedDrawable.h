@@ -0,0 +1,196 @@
+#ifndef Magnum_Examples_InstancedDrawable_h
+#define Magnum_Examples_InstancedDrawable_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <map>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <Corrade/Containers/Pointer.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/SceneGraph/Drawable.h>
+
+#include "InstancedShader.h"
+#include "Types.h"
+
+namespace Magnum { namespace Examples {
+
+class InstanceRenderer;
+
+/**
+@brief Instances of one mesh drawn with the same shader and texture
+
+Filled by @ref InstancedDrawable instances during
+@ref SceneGraph::Camera3D::draw() and submitted by @ref InstanceRenderer in a
+single instanced draw call. If the batch uses a texture array, every instance
+can pick a different layer of it.
+*/
+class InstanceBatch {
+    public:
+        struct Instance {
+            Matrix4 transformationMatrix;
+            Matrix3x3 normalMatrix;
+            Float textureLayer;
+        };
+
+        explicit InstanceBatch(GL::Mesh& mesh, GL::Texture2D* texture, GL::Texture2DArray* textureArray): _mesh(mesh), _texture{texture}, _textureArray{textureArray} {}
+
+        GL::Mesh& mesh() { return _mesh; }
+
+        /**
+         * @brief Texture or @cpp nullptr @ce
+         *
+         * If both this and @ref textureArray() are @cpp nullptr @ce, the
+         * batch is flat-colored.
+         */
+        GL::Texture2D* texture() { return _texture; }
+
+        /** @brief Texture array or @cpp nullptr @ce */
+        GL::Texture2DArray* textureArray() { return _textureArray; }
+
+        std::vector<Instance>& instances() { return _instances; }
+
+        void add(const Matrix4& transformationMatrix, const Matrix3x3& normalMatrix, UnsignedInt textureLayer) {
+            _instances.push_back({transformationMatrix, normalMatrix, Float(textureLayer)});
+        }
+
+    private:
+        GL::Mesh& _mesh;
+        GL::Texture2D* _texture;
+        GL::Texture2DArray* _textureArray;
+        std::vector<Instance> _instances;
+};
+
+/**
+@brief Drawable that adds itself to an instance batch instead of drawing
+
+Put these into a separate drawable group. Drawing the group with the camera
+only collects the transformations, the actual drawing is done in
+@ref InstanceRenderer::draw() afterwards.
+*/
+class InstancedDrawable: public SceneGraph::Drawable3D {
+    public:
+        /**
+         * @brief Constructor
+         *
+         * The @p meshTransformation is applied before the object
+         * transformation, used for dequantizing mesh vertex positions. It
+         * doesn't affect the normal matrix. The @p textureLayer is used only
+         * if the batch has a texture array.
+         */
+        explicit InstancedDrawable(Object3D& object, InstanceBatch& batch, const Matrix4& meshTransformation, UnsignedInt textureLayer, SceneGraph::DrawableGroup3D& group): SceneGraph::Drawable3D{object, &group}, _batch(batch), _meshTransformation{meshTransformation}, _textureLayer{textureLayer} {}
+
+    private:
+        void draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D&) override {
+            _batch.add(transformationMatrix*_meshTransformation, transformationMatrix.rotationScaling(), _textureLayer);
+        }
+
+        InstanceBatch& _batch;
+        Matrix4 _meshTransformation;
+        UnsignedInt _textureLayer;
+};
+
+/**
+@brief Draws repeated meshes using instancing
+
+Groups drawables by mesh and texture. Instance data of all batches are
+uploaded into a single buffer each frame and every batch is then drawn with
+one instanced draw call, picking its range of the buffer via base instance.
+With textures packed into texture arrays, drawables with the same mesh and
+different textures in the same array end up in a single batch.
+*/
+class InstanceRenderer {
+    public:
+        /**
+         * @brief Whether instanced rendering is supported
+         *
+         * Requires GLSL 3.30 and @gl_extension{ARB,base_instance}. If not,
+         * the per-drawable path should be used instead.
+         */
+        static bool isSupported();
+
+        /**
+         * @brief Constructor
+         *
+         * The texture array shader is compiled only if @p textureArrays is
+         * set.
+         */
+        explicit InstanceRenderer(bool textureArrays = false);
+
+        InstancedShader& coloredShader() { return _coloredShader; }
+        InstancedShader& texturedShader() { return _texturedShader; }
+        InstancedShader& textureArrayShader() { return _textureArrayShader; }
+
+        /**
+         * @brief Batch for given mesh and texture
+         *
+         * Creates a new batch if there isn't any yet. Pass @cpp nullptr @ce
+         * for @p texture to get a flat-colored batch.
+         */
+        InstanceBatch& batch(GL::Mesh& mesh, GL::Texture2D* texture);
+
+        /**
+         * @brief Batch for given mesh and texture array
+         *
+         * Expects that the renderer was created with texture arrays enabled.
+         */
+        InstanceBatch& batch(GL::Mesh& mesh, GL::Texture2DArray& textureArray);
+
+        std::size_t batchCount() const { return _batches.size(); }
+
+        /**
+         * @brief Draw all batches
+         *
+         * Call after drawing the group with @ref InstancedDrawable instances
+         * and updating the @ref FrameUniforms for the same camera. Clears
+         * the batches for the next frame.
+         */
+        void draw();
+
+        /** @brief Draw calls submitted in the last @ref draw() */
+        UnsignedInt drawCallCount() const { return _drawCallCount; }
+
+    private:
+        InstanceBatch& batch(GL::Mesh& mesh, GL::Texture2D* texture, GL::Texture2DArray* textureArray);
+
+        InstancedShader _coloredShader, _texturedShader, _textureArrayShader;
+        GL::Buffer _instanceBuffer;
+        std::vector<InstanceBatch::Instance> _instanceData;
+
+        /* Ordered by texture first so consecutive batches share it */
+        std::map<std::tuple<GL::Texture2D*, GL::Texture2DArray*, GL::Mesh*>, Containers::Pointer<InstanceBatch>> _batches;
+        std::unordered_set<GL::Mesh*> _meshes;
+        UnsignedInt _drawCallCount{};
+};
+
+}}
+
+#endif
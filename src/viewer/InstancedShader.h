@@ -0,0 +1,129 @@
+#ifndef Magnum_Examples_InstancedShader_h
+#define Magnum_Examples_InstancedShader_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Shaders/Generic.h>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Shader drawing many instances of the same mesh in a single draw call
+
+Takes transformation and normal matrix from per-instance attributes and the
+projection matrix and light position from the @ref FrameUniforms buffer. The
+colored variant is equivalent to @ref Shaders::Flat3D, the textured variant to
+a single-light @ref Shaders::Phong with a diffuse texture. The texture array
+variant is the same as the textured one, except that the diffuse texture is a
+layer of a @ref GL::Texture2DArray picked by a per-instance attribute.
+*/
+class InstancedShader: public GL::AbstractShaderProgram {
+    public:
+        typedef Shaders::Generic3D::Position Position;
+        typedef Shaders::Generic3D::Normal Normal;
+        typedef Shaders::Generic3D::TextureCoordinates TextureCoordinates;
+
+        /**
+         * @brief Per-instance transformation matrix
+         *
+         * Occupies four consecutive locations, the locations are chosen to
+         * not conflict with any @ref Shaders::Generic attributes.
+         */
+        typedef GL::Attribute<8, Matrix4> TransformationMatrix;
+
+        /** @brief Per-instance normal matrix */
+        typedef GL::Attribute<12, Matrix3x3> NormalMatrix;
+
+        /**
+         * @brief Per-instance texture array layer
+         *
+         * Used only if @ref Flag::TextureArray is set.
+         */
+        typedef GL::Attribute<15, Float> TextureLayer;
+
+        /** @brief Shader variant */
+        enum class Flag: UnsignedByte {
+            /** Textured with a diffuse texture */
+            Textured = 1 << 0,
+
+            /** Textured with a diffuse texture array */
+            TextureArray = 1 << 1
+        };
+
+        explicit InstancedShader(NoCreateT): GL::AbstractShaderProgram{NoCreate} {}
+
+        explicit InstancedShader(Flag flags = {});
+
+        Flag flags() const { return _flags; }
+
+        /**
+         * @brief Set color
+         *
+         * Used only if neither @ref Flag::Textured nor
+         * @ref Flag::TextureArray is set.
+         */
+        InstancedShader& setColor(const Color4& color);
+
+        /**
+         * @brief Set ambient color
+         *
+         * Used only if @ref Flag::Textured or @ref Flag::TextureArray is
+         * set, same for the functions below.
+         */
+        InstancedShader& setAmbientColor(const Color4& color);
+
+        InstancedShader& setSpecularColor(const Color4& color);
+
+        InstancedShader& setShininess(Float shininess);
+
+        InstancedShader& bindDiffuseTexture(GL::Texture2D& texture);
+
+        /**
+         * @brief Bind diffuse texture array
+         *
+         * Used only if @ref Flag::TextureArray is set.
+         */
+        InstancedShader& bindDiffuseTexture(GL::Texture2DArray& texture);
+
+    private:
+        enum: Int { DiffuseTextureLayer = 0 };
+
+        Flag _flags;
+        Int _colorUniform{-1},
+            _ambientColorUniform{-1},
+            _specularColorUniform{-1},
+            _shininessUniform{-1};
+};
+
+}}
+
+#endif
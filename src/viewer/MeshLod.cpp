@@ -0,0 +1,316 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "MeshLod.h"
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+#include <Magnum/Math/Constants.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/SceneGraph/Camera.h>
+#include <Magnum/Trade/MeshData3D.h>
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+/* Projected size in pixels below which the first simplified level is used */
+constexpr Float FullDetailSize = 512.0f;
+
+/* How far past the threshold the size has to get to switch a level */
+constexpr Float Hysteresis = 0.15f;
+
+/* Weight of planes keeping the open boundaries in place */
+constexpr Double BoundaryWeight = 10.0;
+
+/* Symmetric 4x4 matrix measuring squared distance to a set of planes */
+struct Quadric {
+    Double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+    static Quadric plane(const Vector3& normal, Float distance, Double weight) {
+        const Double a = normal.x(), b = normal.y(), c = normal.z(), d = distance;
+        return {a*a*weight, a*b*weight, a*c*weight, a*d*weight,
+                b*b*weight, b*c*weight, b*d*weight,
+                c*c*weight, c*d*weight,
+                d*d*weight};
+    }
+
+    Quadric& operator+=(const Quadric& other) {
+        a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+        b2 += other.b2; bc += other.bc; bd += other.bd;
+        c2 += other.c2; cd += other.cd;
+        d2 += other.d2;
+        return *this;
+    }
+
+    Double error(const Vector3& p) const {
+        const Double x = p.x(), y = p.y(), z = p.z();
+        return a2*x*x + 2*ab*x*y + 2*ac*x*z + 2*ad*x +
+               b2*y*y + 2*bc*y*z + 2*bd*y +
+               c2*z*z + 2*cd*z +
+               d2;
+    }
+};
+
+struct Collapse {
+    UnsignedInt from, to;
+    Double error;
+};
+
+}
+
+std::vector<UnsignedInt> simplifyMesh(const std::vector<UnsignedInt>& indices, const std::vector<Vector3>& positions, const std::size_t targetIndexCount) {
+    const UnsignedInt vertexCount = positions.size();
+
+    /* Weld vertices with the same position to the first one of them by
+       sorting them lexicographically */
+    std::vector<UnsignedInt> weld(vertexCount);
+    {
+        std::vector<UnsignedInt> order(vertexCount);
+        std::iota(order.begin(), order.end(), 0);
+        auto key = [&](UnsignedInt i) {
+            return std::make_tuple(positions[i].x(), positions[i].y(), positions[i].z(), i);
+        };
+        std::sort(order.begin(), order.end(), [&](UnsignedInt a, UnsignedInt b) {
+            return key(a) < key(b);
+        });
+        for(std::size_t i = 0; i != order.size(); ++i)
+            weld[order[i]] = i && positions[order[i]] == positions[order[i - 1]] ?
+                weld[order[i - 1]] : order[i];
+    }
+
+    /* The triangles keep the original vertices to preserve attributes, the
+       welded ones are used for everything topology-related */
+    std::vector<UnsignedInt> current;
+    current.reserve(indices.size());
+    for(std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const UnsignedInt a = weld[indices[i]], b = weld[indices[i + 1]], c = weld[indices[i + 2]];
+        if(a == b || b == c || c == a) continue;
+        current.insert(current.end(), {indices[i], indices[i + 1], indices[i + 2]});
+    }
+
+    /* Sorted list of edges of the current triangles, with the triangle they
+       belong to */
+    std::vector<std::tuple<UnsignedInt, UnsignedInt, UnsignedInt>> edges;
+    auto gatherEdges = [&]() {
+        edges.clear();
+        for(std::size_t i = 0; i != current.size(); i += 3) {
+            for(std::size_t j = 0; j != 3; ++j) {
+                const UnsignedInt a = weld[current[i + j]], b = weld[current[i + (j + 1)%3]];
+                edges.emplace_back(Math::min(a, b), Math::max(a, b), i/3);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+    };
+
+    /* Accumulate area-weighted triangle planes into the vertices */
+    std::vector<Quadric> quadrics(vertexCount, Quadric{});
+    for(std::size_t i = 0; i != current.size(); i += 3) {
+        const Vector3& a = positions[weld[current[i + 0]]];
+        const Vector3& b = positions[weld[current[i + 1]]];
+        const Vector3& c = positions[weld[current[i + 2]]];
+        const Vector3 normal = Math::cross(b - a, c - a);
+        const Float length = normal.length();
+        if(length == 0.0f) continue;
+        const Quadric quadric = Quadric::plane(normal/length, -Math::dot(normal/length, a), length*0.5f);
+        for(std::size_t j = 0; j != 3; ++j)
+            quadrics[weld[current[i + j]]] += quadric;
+    }
+
+    /* Edges used by only one triangle are on a boundary. Add a plane
+       perpendicular to the triangle through them so they stay in place. */
+    gatherEdges();
+    for(std::size_t i = 0; i != edges.size(); ++i) {
+        if((i && std::get<0>(edges[i - 1]) == std::get<0>(edges[i]) && std::get<1>(edges[i - 1]) == std::get<1>(edges[i])) ||
+           (i + 1 != edges.size() && std::get<0>(edges[i + 1]) == std::get<0>(edges[i]) && std::get<1>(edges[i + 1]) == std::get<1>(edges[i])))
+            continue;
+
+        const UnsignedInt triangle = std::get<2>(edges[i])*3;
+        const Vector3& a = positions[std::get<0>(edges[i])];
+        const Vector3& b = positions[std::get<1>(edges[i])];
+        const Vector3 triangleNormal = Math::cross(
+            positions[weld[current[triangle + 1]]] - positions[weld[current[triangle]]],
+            positions[weld[current[triangle + 2]]] - positions[weld[current[triangle]]]);
+        const Vector3 normal = Math::cross(b - a, triangleNormal);
+        const Float length = normal.length();
+        if(length == 0.0f) continue;
+        const Quadric quadric = Quadric::plane(normal/length, -Math::dot(normal/length, a), (b - a).dot()*BoundaryWeight);
+        quadrics[std::get<0>(edges[i])] += quadric;
+        quadrics[std::get<1>(edges[i])] += quadric;
+    }
+
+    std::vector<UnsignedInt> remap(vertexCount);
+    std::vector<bool> locked(vertexCount);
+    std::vector<UnsignedInt> adjacencyOffsets(vertexCount + 1), adjacency;
+    std::vector<Collapse> collapses;
+
+    /* Collapse edges in passes. Each pass collapses the cheapest edges that
+       don't touch each other, which keeps the flip checks valid without
+       updating the adjacency after every collapse. */
+    while(current.size() > targetIndexCount) {
+        /* Unique edges, each collapsed in the cheaper direction */
+        gatherEdges();
+        collapses.clear();
+        for(std::size_t i = 0; i != edges.size(); ++i) {
+            const UnsignedInt a = std::get<0>(edges[i]), b = std::get<1>(edges[i]);
+            if(i && std::get<0>(edges[i - 1]) == a && std::get<1>(edges[i - 1]) == b)
+                continue;
+            Quadric quadric = quadrics[a];
+            quadric += quadrics[b];
+            const Double errorToB = quadric.error(positions[b]);
+            const Double errorToA = quadric.error(positions[a]);
+            if(errorToB <= errorToA) collapses.push_back({a, b, errorToB});
+            else collapses.push_back({b, a, errorToA});
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+            return a.error < b.error;
+        });
+
+        /* Triangles around each vertex */
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for(const UnsignedInt index: current) ++adjacencyOffsets[weld[index] + 1];
+        std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+        adjacency.resize(current.size());
+        {
+            std::vector<UnsignedInt> position(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for(std::size_t i = 0; i != current.size(); ++i)
+                adjacency[position[weld[current[i]]]++] = i/3;
+        }
+
+        /* Each collapse removes two triangles on a closed surface */
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(locked.begin(), locked.end(), false);
+        const std::size_t triangleBudget = (current.size() - targetIndexCount)/3;
+        std::size_t removed = 0;
+        for(const Collapse& collapse: collapses) {
+            if(removed >= triangleBudget) break;
+            if(locked[collapse.from] || locked[collapse.to]) continue;
+
+            /* Reject the collapse if any of the triangles that stay would
+               flip */
+            bool flips = false;
+            for(UnsignedInt i = adjacencyOffsets[collapse.from]; i != adjacencyOffsets[collapse.from + 1] && !flips; ++i) {
+                const UnsignedInt triangle = adjacency[i]*3;
+                Vector3 before[3], after[3];
+                bool containsTo = false;
+                for(std::size_t j = 0; j != 3; ++j) {
+                    const UnsignedInt vertex = weld[current[triangle + j]];
+                    if(vertex == collapse.to) containsTo = true;
+                    before[j] = positions[vertex];
+                    after[j] = positions[vertex == collapse.from ? collapse.to : vertex];
+                }
+                if(containsTo) continue;
+                flips = Math::dot(
+                    Math::cross(before[1] - before[0], before[2] - before[0]),
+                    Math::cross(after[1] - after[0], after[2] - after[0])) <= 0.0f;
+            }
+            if(flips) continue;
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            for(UnsignedInt i = adjacencyOffsets[collapse.from]; i != adjacencyOffsets[collapse.from + 1]; ++i)
+                for(std::size_t j = 0; j != 3; ++j)
+                    locked[weld[current[adjacency[i]*3 + j]]] = true;
+            removed += 2;
+        }
+
+        if(!removed) break;
+
+        /* Move collapsed corners to the target vertex and drop triangles that
+           became degenerate */
+        std::size_t out = 0;
+        for(std::size_t i = 0; i != current.size(); i += 3) {
+            UnsignedInt triangle[3];
+            for(std::size_t j = 0; j != 3; ++j) {
+                const UnsignedInt vertex = weld[current[i + j]];
+                triangle[j] = remap[vertex] != vertex ? remap[vertex] : current[i + j];
+            }
+            if(weld[triangle[0]] == weld[triangle[1]] ||
+               weld[triangle[1]] == weld[triangle[2]] ||
+               weld[triangle[2]] == weld[triangle[0]]) continue;
+            for(std::size_t j = 0; j != 3; ++j) current[out++] = triangle[j];
+        }
+        current.resize(out);
+    }
+
+    return current;
+}
+
+std::vector<MeshLevel> generateLods(Trade::MeshData3D& data, const UnsignedInt levelCount) {
+    std::vector<UnsignedInt>& indices = data.indices();
+    std::vector<MeshLevel> levels{{0, UnsignedInt(indices.size())}};
+
+    std::vector<UnsignedInt> previous = indices;
+    while(levels.size() < levelCount) {
+        const std::size_t target = previous.size()/4/3*3;
+        if(target < 3*16) break;
+
+        std::vector<UnsignedInt> simplified = simplifyMesh(previous, data.positions(0), target);
+
+        /* Not worth keeping a level that's almost the same as the previous */
+        if(simplified.size() > previous.size()*3/4) break;
+
+        levels.push_back({UnsignedInt(indices.size()), UnsignedInt(simplified.size())});
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        previous = std::move(simplified);
+    }
+
+    return levels;
+}
+
+Float MeshLod::projectedSize(const Matrix4& transformationMatrix, SceneGraph::Camera3D& camera) const {
+    const Vector3 center = transformationMatrix.transformPoint(_center);
+    const Float radius = _radius*transformationMatrix.scaling().max();
+    const Float distance = -center.z();
+    return distance > radius ?
+        2.0f*radius/distance*camera.projectionMatrix()[1][1]*camera.viewport().y()*0.5f :
+        Constants::inf();
+}
+
+MeshLevel MeshLod::select(const Matrix4& transformationMatrix, SceneGraph::Camera3D& camera) {
+    if(_levels.empty()) return {};
+
+    const Float size = projectedSize(transformationMatrix, camera);
+
+    /* Level l is used below FullDetailSize/2^(l - 1). Go coarser or finer
+       only when the size gets past the threshold by the hysteresis margin. */
+    auto threshold = [](UnsignedInt level) {
+        return FullDetailSize/Float(1 << (level - 1));
+    };
+    while(_current + 1 < _levels.size() && size < threshold(_current + 1)*(1.0f - Hysteresis))
+        ++_current;
+    while(_current > 0 && size > threshold(_current)*(1.0f + Hysteresis))
+        --_current;
+
+    return _levels[_current];
+}
+
+}}
@@ -0,0 +1,123 @@
+#ifndef Magnum_Examples_MeshLod_h
+#define Magnum_Examples_MeshLod_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/SceneGraph/SceneGraph.h>
+#include <Magnum/Trade/Trade.h>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Range of the index buffer containing one level of detail
+
+All levels of a mesh share the same vertex data and their indices are stored
+one after another in the same index buffer. An @ref indexCount of zero means
+the whole mesh.
+*/
+struct MeshLevel {
+    UnsignedInt indexOffset;
+    UnsignedInt indexCount;
+};
+
+/**
+@brief Simplify a triangle mesh using quadric edge collapse
+
+Collapses edges with the lowest quadric error (Garland and Heckbert,
+*Surface Simplification Using Quadric Error Metrics*, 1997) until the index
+count drops below @p targetIndexCount or no more edges can be collapsed
+without flipping a triangle. Vertices with the same position are treated as
+one so attribute seams don't tear apart, and an edge always collapses into
+one of its existing vertices, so the result references the original vertex
+data and can be stored next to the original indices. Open boundaries are
+preserved with additional boundary planes.
+*/
+std::vector<UnsignedInt> simplifyMesh(const std::vector<UnsignedInt>& indices, const std::vector<Vector3>& positions, std::size_t targetIndexCount);
+
+/**
+@brief Generate a chain of levels of detail
+
+Each level is simplified from the previous one to about a quarter of its
+triangles, stopping after @p levelCount levels in total or once the
+simplification doesn't make enough progress. The indices are appended to
+@ref Trade::MeshData3D::indices(), the returned ranges include the original
+mesh as the first level. Expects an indexed triangle mesh.
+*/
+std::vector<MeshLevel> generateLods(Trade::MeshData3D& data, UnsignedInt levelCount);
+
+/**
+@brief Level of detail selection for a single drawable
+
+Picks a level based on the projected size of the mesh bounding sphere. Each
+level is meant for half the size of the previous one, as it has a quarter of
+the triangles and the covered pixel count falls to a quarter as well. To
+avoid levels flickering when the size is close to a threshold, the level
+switches only after the size gets past the threshold by a margin.
+*/
+class MeshLod {
+    public:
+        /**
+         * @brief Constructor
+         * @param levels    Levels of the mesh, can be empty
+         * @param bounds    Bounding box of the mesh
+         *
+         * The @p levels view is expected to stay in scope for the whole
+         * lifetime of the instance.
+         */
+        explicit MeshLod(Containers::ArrayView<const MeshLevel> levels, const Range3D& bounds): _levels{levels}, _center{bounds.center()}, _radius{bounds.size().length()*0.5f} {}
+
+        /**
+         * @brief Select a level to draw
+         *
+         * Returns a zero index count, meaning the whole mesh, if there are no
+         * levels.
+         */
+        MeshLevel select(const Matrix4& transformationMatrix, SceneGraph::Camera3D& camera);
+
+        /**
+         * @brief Projected size
+         *
+         * Diameter of the mesh bounding sphere projected to the screen, in
+         * pixels. Infinity if the camera is inside the sphere.
+         */
+        Float projectedSize(const Matrix4& transformationMatrix, SceneGraph::Camera3D& camera) const;
+
+    private:
+        Containers::ArrayView<const MeshLevel> _levels;
+        Vector3 _center;
+        Float _radius;
+        UnsignedInt _current{};
+};
+
+}}
+
+#endif
@@ -0,0 +1,229 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <Magnum/Math/Vector3.h>
+#include <Magnum/Trade/MeshData3D.h>
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+template<class T> void remapArray(std::vector<T>& array, const std::vector<UnsignedInt>& remap, const UnsignedInt count) {
+    std::vector<T> out(count);
+    for(std::size_t i = 0; i != array.size(); ++i)
+        if(remap[i] != ~UnsignedInt{}) out[remap[i]] = array[i];
+    array = std::move(out);
+}
+
+}
+
+VertexCacheStatistics analyzeVertexCache(const std::vector<UnsignedInt>& indices, const UnsignedInt vertexCount, const UnsignedInt cacheSize) {
+    /* A vertex is in the FIFO if less than cacheSize other vertices were
+       inserted since it got inserted */
+    std::vector<UnsignedLong> cachedAt(vertexCount, 0);
+    UnsignedLong time = cacheSize + 1;
+    UnsignedLong misses = 0;
+    for(const UnsignedInt index: indices) {
+        if(time - cachedAt[index] > cacheSize) {
+            cachedAt[index] = time++;
+            ++misses;
+        }
+    }
+
+    return {vertexCount, indices.size()/3, misses};
+}
+
+void optimizeVertexCache(std::vector<UnsignedInt>& indices, const UnsignedInt vertexCount, std::vector<UnsignedInt>& clusters, const UnsignedInt cacheSize) {
+    const std::size_t triangleCount = indices.size()/3;
+
+    /* Triangles adjacent to each vertex, and count of adjacent triangles
+       that weren't emitted yet */
+    std::vector<UnsignedInt> liveCount(vertexCount), offsets(vertexCount + 1), adjacency(triangleCount*3);
+    for(const UnsignedInt index: indices) ++liveCount[index];
+    for(UnsignedInt i = 0; i != vertexCount; ++i)
+        offsets[i + 1] = offsets[i] + liveCount[i];
+    {
+        std::vector<UnsignedInt> position(offsets.begin(), offsets.end() - 1);
+        for(std::size_t i = 0; i != triangleCount*3; ++i)
+            adjacency[position[indices[i]]++] = i/3;
+    }
+
+    std::vector<UnsignedLong> cachedAt(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount);
+    std::vector<UnsignedInt> deadEnds, candidates, out;
+    out.reserve(triangleCount*3);
+    UnsignedLong time = cacheSize + 1;
+    UnsignedInt cursor = 0;
+
+    /* Continue from the most recently used vertex that still has some
+       triangles left, or the next one in the original order */
+    auto skipDeadEnd = [&]() -> Int {
+        while(!deadEnds.empty()) {
+            const UnsignedInt vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if(liveCount[vertex]) return vertex;
+        }
+        for(; cursor != vertexCount; ++cursor)
+            if(liveCount[cursor]) return cursor;
+        return -1;
+    };
+
+    clusters.assign(1, 0);
+    Int fanning = skipDeadEnd();
+    while(fanning != -1) {
+        /* Emit all remaining triangles around the fanning vertex */
+        candidates.clear();
+        for(UnsignedInt i = offsets[fanning]; i != offsets[fanning + 1]; ++i) {
+            const UnsignedInt triangle = adjacency[i];
+            if(emitted[triangle]) continue;
+            emitted[triangle] = true;
+
+            for(UnsignedInt j = 0; j != 3; ++j) {
+                const UnsignedInt vertex = indices[triangle*3 + j];
+                out.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                --liveCount[vertex];
+                if(time - cachedAt[vertex] > cacheSize)
+                    cachedAt[vertex] = time++;
+            }
+        }
+
+        /* Pick the candidate that was in the cache the longest but will still
+           be there after fanning around it */
+        Int next = -1;
+        Long bestPriority = -1;
+        for(const UnsignedInt vertex: candidates) {
+            if(!liveCount[vertex]) continue;
+            Long priority = 0;
+            if(time - cachedAt[vertex] + 2*liveCount[vertex] <= cacheSize)
+                priority = time - cachedAt[vertex];
+            if(priority > bestPriority) {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+
+        /* Dead end, start a new cluster */
+        if(next == -1) {
+            next = skipDeadEnd();
+            if(next != -1) clusters.push_back(out.size()/3);
+        }
+
+        fanning = next;
+    }
+
+    indices.swap(out);
+}
+
+void optimizeOverdraw(std::vector<UnsignedInt>& indices, const std::vector<Vector3>& positions, const std::vector<UnsignedInt>& clusters) {
+    if(clusters.size() < 2) return;
+    const UnsignedInt triangleCount = indices.size()/3;
+
+    struct Cluster {
+        UnsignedInt begin, end;
+        Vector3 center, normal;
+        Float order;
+    };
+
+    /* Area-weighted centroid and average normal of each cluster and of the
+       whole mesh */
+    std::vector<Cluster> sorted(clusters.size());
+    Vector3 meshCenter;
+    Float meshArea = 0.0f;
+    for(std::size_t i = 0; i != clusters.size(); ++i) {
+        Cluster& cluster = sorted[i];
+        cluster.begin = clusters[i];
+        cluster.end = i + 1 != clusters.size() ? clusters[i + 1] : triangleCount;
+
+        Float area = 0.0f;
+        for(UnsignedInt triangle = cluster.begin; triangle != cluster.end; ++triangle) {
+            const Vector3& a = positions[indices[triangle*3 + 0]];
+            const Vector3& b = positions[indices[triangle*3 + 1]];
+            const Vector3& c = positions[indices[triangle*3 + 2]];
+            const Vector3 normal = Math::cross(b - a, c - a);
+            const Float weight = normal.length();
+            cluster.center += (a + b + c)*(weight/3.0f);
+            cluster.normal += normal;
+            area += weight;
+        }
+
+        meshCenter += cluster.center;
+        meshArea += area;
+        if(area > 0.0f) cluster.center /= area;
+    }
+    if(meshArea > 0.0f) meshCenter /= meshArea;
+
+    /* Clusters facing away from the center the most go first */
+    for(Cluster& cluster: sorted) {
+        const Float length = cluster.normal.length();
+        cluster.order = length > 0.0f ?
+            Math::dot(cluster.center - meshCenter, cluster.normal/length) : 0.0f;
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) {
+        return a.order > b.order;
+    });
+
+    std::vector<UnsignedInt> out;
+    out.reserve(indices.size());
+    for(const Cluster& cluster: sorted)
+        out.insert(out.end(), indices.begin() + cluster.begin*3, indices.begin() + cluster.end*3);
+    indices.swap(out);
+}
+
+void optimizeVertexFetch(Trade::MeshData3D& data) {
+    /* Number vertices in order of their first use */
+    std::vector<UnsignedInt> remap(data.positions(0).size(), ~UnsignedInt{});
+    UnsignedInt count = 0;
+    for(UnsignedInt& index: data.indices()) {
+        if(remap[index] == ~UnsignedInt{}) remap[index] = count++;
+        index = remap[index];
+    }
+
+    for(UnsignedInt i = 0; i != data.positionArrayCount(); ++i)
+        remapArray(data.positions(i), remap, count);
+    for(UnsignedInt i = 0; i != data.normalArrayCount(); ++i)
+        remapArray(data.normals(i), remap, count);
+    for(UnsignedInt i = 0; i != data.textureCoords2DArrayCount(); ++i)
+        remapArray(data.textureCoords2D(i), remap, count);
+    for(UnsignedInt i = 0; i != data.colorArrayCount(); ++i)
+        remapArray(data.colors(i), remap, count);
+}
+
+void optimizeMesh(Trade::MeshData3D& data) {
+    std::vector<UnsignedInt> clusters;
+    optimizeVertexCache(data.indices(), data.positions(0).size(), clusters);
+    optimizeOverdraw(data.indices(), data.positions(0), clusters);
+    optimizeVertexFetch(data);
+}
+
+}}
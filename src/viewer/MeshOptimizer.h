@@ -0,0 +1,119 @@
+#ifndef Magnum_Examples_MeshOptimizer_h
+#define Magnum_Examples_MeshOptimizer_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Magnum/Magnum.h>
+#include <Magnum/Trade/Trade.h>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Post-transform vertex cache statistics
+
+Gathered by simulating a FIFO cache of given size over the index buffer.
+Statistics of multiple meshes can be summed together.
+*/
+struct VertexCacheStatistics {
+    UnsignedLong vertexCount;
+    UnsignedLong triangleCount;
+    UnsignedLong misses;
+
+    /**
+     * @brief Average cache miss ratio
+     *
+     * Transformed vertices per triangle. Ranges from 3 for no reuse at all
+     * to about 0.5 for an ideal ordering of a regular grid.
+     */
+    Float acmr() const { return triangleCount ? Float(misses)/triangleCount : 0.0f; }
+
+    /**
+     * @brief Average transformed vertex ratio
+     *
+     * How many times is each vertex transformed on average, 1 is optimal.
+     */
+    Float atvr() const { return vertexCount ? Float(misses)/vertexCount : 0.0f; }
+
+    VertexCacheStatistics& operator+=(const VertexCacheStatistics& other) {
+        vertexCount += other.vertexCount;
+        triangleCount += other.triangleCount;
+        misses += other.misses;
+        return *this;
+    }
+};
+
+/** @brief Simulate a FIFO post-transform vertex cache */
+VertexCacheStatistics analyzeVertexCache(const std::vector<UnsignedInt>& indices, UnsignedInt vertexCount, UnsignedInt cacheSize = 16);
+
+/**
+@brief Reorder triangles for post-transform vertex cache locality
+
+Implements the Tipsify algorithm from Sander, Nehab and Barczak, *Fast
+Triangle Reordering for Vertex Locality and Reduced Overdraw*, 2007. The
+algorithm fans around vertices and picks the next fanning vertex among those
+that are still likely in the cache. When it runs into a dead end, it continues
+from a recently used vertex or from the next one in the original order and a
+new cluster of triangles starts. Offsets of the clusters, in triangles, are
+written into @p clusters for use by @ref optimizeOverdraw().
+*/
+void optimizeVertexCache(std::vector<UnsignedInt>& indices, UnsignedInt vertexCount, std::vector<UnsignedInt>& clusters, UnsignedInt cacheSize = 16);
+
+/**
+@brief Reorder triangle clusters to reduce overdraw
+
+Sorts the clusters produced by @ref optimizeVertexCache() so the ones facing
+outwards from the mesh center come first. Those are likely to occlude the
+others from any viewpoint, so the depth test rejects more fragments of the
+clusters drawn later. Order of triangles inside each cluster is kept, so
+vertex cache locality is mostly preserved.
+*/
+void optimizeOverdraw(std::vector<UnsignedInt>& indices, const std::vector<Vector3>& positions, const std::vector<UnsignedInt>& clusters);
+
+/**
+@brief Reorder vertices for fetch locality
+
+Renumbers vertices in the order they are first referenced by the index
+buffer and reorders all vertex attributes accordingly, so vertex fetch reads
+the buffer mostly sequentially. Vertices not referenced by any triangle are
+dropped.
+*/
+void optimizeVertexFetch(Trade::MeshData3D& data);
+
+/**
+@brief Optimize a mesh for rendering
+
+Calls @ref optimizeVertexCache(), @ref optimizeOverdraw() and
+@ref optimizeVertexFetch() in this order. Expects an indexed triangle mesh.
+*/
+void optimizeMesh(Trade::MeshData3D& data);
+
+}}
+
+#endif
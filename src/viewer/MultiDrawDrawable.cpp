@@ -0,0 +1,206 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "MultiDrawDrawable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/GL/Context.h>
+#include <Magnum/GL/Extensions.h>
+#include <Magnum/GL/OpenGL.h>
+#include <Magnum/GL/Texture.h>
+#include <Magnum/GL/TextureArray.h>
+#include <Magnum/SceneGraph/Camera.h>
+#include <Magnum/Trade/MeshData3D.h>
+
+namespace Magnum { namespace Examples {
+
+void MultiDrawDrawable::draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D&) {
+    _renderer.add(_mesh, _texture, _textureArray, _textureLayer, transformationMatrix);
+}
+
+bool MultiDrawRenderer::isSupported() {
+    #ifndef MAGNUM_TARGET_GLES
+    return GL::Context::current().isVersionSupported(GL::Version::GL330) &&
+        GL::Context::current().isExtensionSupported<GL::Extensions::ARB::draw_indirect>() &&
+        GL::Context::current().isExtensionSupported<GL::Extensions::ARB::base_instance>() &&
+        GL::Context::current().isExtensionSupported<GL::Extensions::ARB::multi_draw_indirect>();
+    #else
+    return false;
+    #endif
+}
+
+MultiDrawRenderer::MultiDrawRenderer(const bool textureArrays): _texturedShader{InstancedShader::Flag::Textured}, _textureArrayShader{NoCreate} {
+    if(textureArrays)
+        _textureArrayShader = InstancedShader{InstancedShader::Flag::TextureArray};
+}
+
+MultiDrawRenderer::MeshRange& MultiDrawRenderer::beginMesh(const UnsignedInt id) {
+    if(id >= _ranges.size()) _ranges.resize(id + 1, MeshRange{});
+    MeshRange& range = _ranges[id];
+    range.indexOffset = _indices.size();
+    range.baseVertex = _vertices.size();
+    return range;
+}
+
+void MultiDrawRenderer::setMesh(const UnsignedInt id, const Trade::MeshData3D& data) {
+    MeshRange& range = beginMesh(id);
+
+    const std::vector<Vector3>& positions = data.positions(0);
+    const std::vector<Vector3>& normals = data.normals(0);
+    for(std::size_t i = 0; i != positions.size(); ++i)
+        _vertices.push_back({positions[i], normals[i],
+            data.hasTextureCoords2D() ? data.textureCoords2D(0)[i] : Vector2{}});
+
+    if(data.isIndexed())
+        _indices.insert(_indices.end(), data.indices().begin(), data.indices().end());
+    else for(UnsignedInt i = 0; i != positions.size(); ++i)
+        _indices.push_back(i);
+
+    range.indexCount = _indices.size() - range.indexOffset;
+}
+
+void MultiDrawRenderer::setMesh(const UnsignedInt id, const Containers::ArrayView<const char> vertexData, const bool textureCoordinates, const Containers::ArrayView<const char> indexData, const MeshIndexType indexType) {
+    MeshRange& range = beginMesh(id);
+
+    /* The attributes are in the same order as in our vertex, so just copy
+       the prefix that's present and leave the rest zero */
+    const std::size_t stride = textureCoordinates ? sizeof(Vertex) : sizeof(Vector3)*2;
+    const std::size_t vertexCount = vertexData.size()/stride;
+    for(std::size_t i = 0; i != vertexCount; ++i) {
+        Vertex vertex{};
+        std::memcpy(&vertex, vertexData.data() + i*stride, stride);
+        _vertices.push_back(vertex);
+    }
+
+    /* Expand the compressed indices back to 32 bits */
+    if(indexData.empty()) {
+        for(UnsignedInt i = 0; i != vertexCount; ++i) _indices.push_back(i);
+    } else if(indexType == MeshIndexType::UnsignedByte) {
+        const auto indices = Containers::arrayCast<const UnsignedByte>(indexData);
+        _indices.insert(_indices.end(), indices.begin(), indices.end());
+    } else if(indexType == MeshIndexType::UnsignedShort) {
+        const auto indices = Containers::arrayCast<const UnsignedShort>(indexData);
+        _indices.insert(_indices.end(), indices.begin(), indices.end());
+    } else {
+        const auto indices = Containers::arrayCast<const UnsignedInt>(indexData);
+        _indices.insert(_indices.end(), indices.begin(), indices.end());
+    }
+
+    range.indexCount = _indices.size() - range.indexOffset;
+}
+
+void MultiDrawRenderer::upload() {
+    _vertexBuffer.setData(Containers::arrayView(_vertices.data(), _vertices.size()), GL::BufferUsage::StaticDraw);
+    _indexBuffer.setData(Containers::arrayView(_indices.data(), _indices.size()), GL::BufferUsage::StaticDraw);
+
+    _mesh.setPrimitive(MeshPrimitive::Triangles)
+        .addVertexBuffer(_vertexBuffer, 0,
+            InstancedShader::Position{},
+            InstancedShader::Normal{},
+            InstancedShader::TextureCoordinates{})
+        .addVertexBufferInstanced(_instanceBuffer, 1, 0,
+            InstancedShader::TransformationMatrix{},
+            InstancedShader::NormalMatrix{},
+            InstancedShader::TextureLayer{})
+        .setIndexBuffer(_indexBuffer, 0, MeshIndexType::UnsignedInt);
+
+    Debug{} << "Packed" << _ranges.size() << "meshes into"
+        << _vertices.size()*sizeof(Vertex)/1024 << "kB of vertex and"
+        << _indices.size()*sizeof(UnsignedInt)/1024 << "kB of index data";
+
+    _vertices = {};
+    _indices = {};
+}
+
+void MultiDrawRenderer::draw() {
+    _commands.clear();
+    _groups.clear();
+    if(_draws.empty()) return;
+
+    /* Sort by texture and then mesh, so draws of the same mesh form one
+       command and commands with the same texture one multi-draw call. Draws
+       with different layers of the same texture array differ only in the
+       instance data, so they can share a command as well. */
+    std::sort(_draws.begin(), _draws.end(), [](const Draw& a, const Draw& b) {
+        if(a.texture != b.texture)
+            return std::less<GL::Texture2D*>{}(a.texture, b.texture);
+        if(a.textureArray != b.textureArray)
+            return std::less<GL::Texture2DArray*>{}(a.textureArray, b.textureArray);
+        return a.mesh < b.mesh;
+    });
+
+    _sortedInstances.clear();
+    for(std::size_t i = 0; i != _draws.size(); ++i) {
+        const Draw& draw = _draws[i];
+        if(_groups.empty() || _groups.back().texture != draw.texture || _groups.back().textureArray != draw.textureArray)
+            _groups.push_back({draw.texture, draw.textureArray, UnsignedInt(_commands.size()), 0});
+
+        if(!_groups.back().commandCount || _draws[i - 1].mesh != draw.mesh) {
+            const MeshRange& range = _ranges[draw.mesh];
+            _commands.push_back({range.indexCount, 0, range.indexOffset,
+                Int(range.baseVertex), UnsignedInt(_sortedInstances.size())});
+            ++_groups.back().commandCount;
+        }
+
+        ++_commands.back().instanceCount;
+        _sortedInstances.push_back(_instances[draw.instance]);
+    }
+
+    _instanceBuffer.setData(Containers::arrayView(_sortedInstances.data(), _sortedInstances.size()), GL::BufferUsage::StreamDraw);
+    _commandBuffer.setData(Containers::arrayView(_commands.data(), _commands.size()), GL::BufferUsage::StreamDraw);
+
+    #ifndef MAGNUM_TARGET_GLES
+    for(const Group& group: _groups) {
+        InstancedShader& shader = group.texture ? _texturedShader :
+            group.textureArray ? _textureArrayShader : _coloredShader;
+        if(group.texture) shader.bindDiffuseTexture(*group.texture);
+        else if(group.textureArray) shader.bindDiffuseTexture(*group.textureArray);
+
+        /* Magnum has no wrapper for indirect draws, so issue the call
+           directly. The state tracker needs to be told about that. */
+        GL::Context::current().resetState(GL::Context::State::EnterExternal);
+        glUseProgram(shader.id());
+        glBindVertexArray(_mesh.id());
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _commandBuffer.id());
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+            reinterpret_cast<const void*>(group.firstCommand*sizeof(Command)),
+            group.commandCount, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        GL::Context::current().resetState(GL::Context::State::ExitExternal);
+    }
+    #endif
+
+    _draws.clear();
+    _instances.clear();
+}
+
+}}
@@ -0,0 +1,224 @@
+#ifndef Magnum_Examples_MultiDrawDrawable_h
+#define Magnum_Examples_MultiDrawDrawable_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Mesh.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/SceneGraph/Drawable.h>
+#include <Magnum/Trade/Trade.h>
+
+#include "InstancedDrawable.h"
+#include "InstancedShader.h"
+#include "Types.h"
+
+namespace Magnum { namespace Examples {
+
+class MultiDrawRenderer;
+
+/**
+@brief Drawable that adds itself to a multi-draw command list
+
+Similarly to @ref InstancedDrawable, drawing the group with the camera only
+collects the transformations, the actual drawing is done in
+@ref MultiDrawRenderer::draw() afterwards.
+*/
+class MultiDrawDrawable: public SceneGraph::Drawable3D {
+    public:
+        /**
+         * @brief Constructor
+         *
+         * At most one of @p texture and @p textureArray is expected to be
+         * set, if neither, the mesh is drawn flat-colored. The
+         * @p textureLayer is used only with a texture array.
+         */
+        explicit MultiDrawDrawable(Object3D& object, MultiDrawRenderer& renderer, UnsignedInt mesh, GL::Texture2D* texture, GL::Texture2DArray* textureArray, UnsignedInt textureLayer, SceneGraph::DrawableGroup3D& group): SceneGraph::Drawable3D{object, &group}, _renderer(renderer), _mesh{mesh}, _texture{texture}, _textureArray{textureArray}, _textureLayer{textureLayer} {}
+
+    private:
+        void draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D&) override;
+
+        MultiDrawRenderer& _renderer;
+        UnsignedInt _mesh;
+        GL::Texture2D* _texture;
+        GL::Texture2DArray* _textureArray;
+        UnsignedInt _textureLayer;
+};
+
+/**
+@brief Draws meshes packed in a single buffer with multi-draw-indirect
+
+All meshes are packed into one vertex buffer with a common layout --- position,
+normal and texture coordinates, which are zero for meshes that don't have
+them --- and one index buffer with 32-bit indices. Each mesh is then just a
+range of the index buffer and a base vertex, and a single vertex array object
+describes all of them.
+
+Every frame the collected draws are sorted by texture and mesh. Draws of the
+same mesh become one indirect command, instanced with their transformations
+picked from an instance buffer via base instance, and all commands sharing a
+texture are submitted with one @fn_gl{MultiDrawElementsIndirect} call. A
+static scene thus needs only as many draw calls as there are textures, plus
+one for flat-colored meshes. With textures packed into texture arrays, the
+layer is another per-instance attribute and it's just one draw call per
+array.
+*/
+class MultiDrawRenderer {
+    public:
+        /**
+         * @brief Whether multi-draw-indirect rendering is supported
+         *
+         * Requires GLSL 3.30, @gl_extension{ARB,draw_indirect} for the
+         * indirect buffer binding, @gl_extension{ARB,base_instance} and
+         * @gl_extension{ARB,multi_draw_indirect}.
+         */
+        static bool isSupported();
+
+        /**
+         * @brief Constructor
+         *
+         * The texture array shader is compiled only if @p textureArrays is
+         * set.
+         */
+        explicit MultiDrawRenderer(bool textureArrays = false);
+
+        InstancedShader& coloredShader() { return _coloredShader; }
+        InstancedShader& texturedShader() { return _texturedShader; }
+        InstancedShader& textureArrayShader() { return _textureArrayShader; }
+
+        /**
+         * @brief Add mesh data
+         *
+         * Expects a triangle mesh with normals. Call @ref upload() after all
+         * meshes are added.
+         */
+        void setMesh(UnsignedInt id, const Trade::MeshData3D& data);
+
+        /**
+         * @brief Add mesh data in the scene cache format
+         * @param id                    Mesh ID
+         * @param vertexData            Interleaved positions and normals,
+         *      optionally followed by texture coordinates
+         * @param textureCoordinates    Whether @p vertexData contain texture
+         *      coordinates
+         * @param indexData             Index data or an empty view for a
+         *      non-indexed mesh
+         * @param indexType             Index type
+         */
+        void setMesh(UnsignedInt id, Containers::ArrayView<const char> vertexData, bool textureCoordinates, Containers::ArrayView<const char> indexData, MeshIndexType indexType);
+
+        /**
+         * @brief Upload the packed buffers
+         *
+         * Releases the CPU copy of the data afterwards.
+         */
+        void upload();
+
+        /**
+         * @brief Add a draw for the current frame
+         *
+         * Pass @cpp nullptr @ce for both @p texture and @p textureArray to
+         * draw the mesh flat-colored.
+         */
+        void add(UnsignedInt mesh, GL::Texture2D* texture, GL::Texture2DArray* textureArray, UnsignedInt textureLayer, const Matrix4& transformationMatrix) {
+            _draws.push_back({texture, textureArray, mesh, UnsignedInt(_instances.size())});
+            _instances.push_back({transformationMatrix, transformationMatrix.rotationScaling(), Float(textureLayer)});
+        }
+
+        /**
+         * @brief Draw everything added in this frame
+         *
+         * Expects that @ref FrameUniforms were updated for the camera the
+         * draws were collected with. Clears the draws for the next frame.
+         */
+        void draw();
+
+        /** @brief Draw calls issued in the last @ref draw() */
+        UnsignedInt drawCallCount() const { return _groups.size(); }
+
+        /** @brief Indirect commands submitted in the last @ref draw() */
+        UnsignedInt commandCount() const { return _commands.size(); }
+
+    private:
+        struct Vertex {
+            Vector3 position;
+            Vector3 normal;
+            Vector2 textureCoordinates;
+        };
+
+        struct MeshRange {
+            UnsignedInt indexOffset, indexCount;
+            UnsignedInt baseVertex;
+        };
+
+        struct Draw {
+            GL::Texture2D* texture;
+            GL::Texture2DArray* textureArray;
+            UnsignedInt mesh;
+            UnsignedInt instance;
+        };
+
+        /* Layout defined by the GL spec */
+        struct Command {
+            UnsignedInt count;
+            UnsignedInt instanceCount;
+            UnsignedInt firstIndex;
+            Int baseVertex;
+            UnsignedInt baseInstance;
+        };
+
+        /* Range of commands drawn with one multi-draw call */
+        struct Group {
+            GL::Texture2D* texture;
+            GL::Texture2DArray* textureArray;
+            UnsignedInt firstCommand, commandCount;
+        };
+
+        MeshRange& beginMesh(UnsignedInt id);
+
+        InstancedShader _coloredShader, _texturedShader, _textureArrayShader;
+
+        std::vector<MeshRange> _ranges;
+        std::vector<Vertex> _vertices;
+        std::vector<UnsignedInt> _indices;
+        GL::Buffer _vertexBuffer, _indexBuffer, _instanceBuffer, _commandBuffer;
+        GL::Mesh _mesh;
+
+        /* Reused between frames to avoid allocations */
+        std::vector<Draw> _draws;
+        std::vector<InstanceBatch::Instance> _instances, _sortedInstances;
+        std::vector<Command> _commands;
+        std::vector<Group> _groups;
+};
+
+}}
+
+#endif
@@ -0,0 +1,304 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <Magnum/Image.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/GL/DefaultFramebuffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/PixelFormat.h>
+#include <Magnum/GL/RenderbufferFormat.h>
+#include <Magnum/Math/Constants.h>
+#include <Magnum/Math/Functions.h>
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+/* Width of the depth buffer, the height is derived from the aspect ratio */
+constexpr Int DepthWidth = 256;
+
+/* Max count of occluders rasterized per frame */
+constexpr std::size_t MaxOccluderCount = 32;
+
+/* Twice the signed area of the triangle abc, positive if counterclockwise */
+Float edge(const Vector2& a, const Vector2& b, const Vector2& c) {
+    return (b.x() - a.x())*(c.y() - a.y()) - (b.y() - a.y())*(c.x() - a.x());
+}
+
+}
+
+void HierarchicalDepth::setSize(const Vector2i& size) {
+    _size = size;
+    _depth = Containers::Array<Float>{Containers::NoInit, std::size_t(size.product())};
+
+    _levelSizes.clear();
+    _levelOffsets.clear();
+    std::size_t offset = 0;
+    for(Vector2i levelSize = size;; levelSize = (levelSize + Vector2i{1})/2) {
+        _levelSizes.push_back(levelSize);
+        _levelOffsets.push_back(offset);
+        offset += levelSize.product();
+        if(levelSize == Vector2i{1}) break;
+    }
+    _pyramid.resize(offset);
+
+    clear();
+}
+
+void HierarchicalDepth::clear() {
+    std::fill(_depth.begin(), _depth.end(), 1.0f);
+}
+
+void HierarchicalDepth::rasterize(const Vector4& a, const Vector4& b, const Vector4& c) {
+    if(a.w() <= 0.0f || b.w() <= 0.0f || c.w() <= 0.0f) return;
+
+    /* Window coordinates */
+    const Vector2 size{_size};
+    auto window = [&](const Vector4& v) {
+        const Vector3 ndc = v.xyz()/v.w();
+        return Vector3{(ndc.xy()*0.5f + Vector2{0.5f})*size, ndc.z()*0.5f + 0.5f};
+    };
+    const Vector3 p0 = window(a);
+    Vector3 p1 = window(b), p2 = window(c);
+
+    /* Both windings, as occluders don't need to be closed */
+    Float area = edge(p0.xy(), p1.xy(), p2.xy());
+    if(Math::abs(area) < 1.0e-6f) return;
+    if(area < 0.0f) {
+        std::swap(p1, p2);
+        area = -area;
+    }
+
+    const Vector2i min = Math::max(Vector2i{Math::floor(Math::min(Math::min(p0.xy(), p1.xy()), p2.xy()))}, Vector2i{});
+    const Vector2i max = Math::min(Vector2i{Math::ceil(Math::max(Math::max(p0.xy(), p1.xy()), p2.xy()))}, _size - Vector2i{1});
+
+    /* Test pixel centers against the edges, depth in window space is linear
+       so it can be interpolated directly */
+    for(Int y = min.y(); y <= max.y(); ++y) {
+        for(Int x = min.x(); x <= max.x(); ++x) {
+            const Vector2 point{x + 0.5f, y + 0.5f};
+            const Float w0 = edge(p1.xy(), p2.xy(), point);
+            const Float w1 = edge(p2.xy(), p0.xy(), point);
+            const Float w2 = edge(p0.xy(), p1.xy(), point);
+            if(w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+
+            const Float z = (w0*p0.z() + w1*p1.z() + w2*p2.z())/area;
+            Float& depth = _depth[y*_size.x() + x];
+            if(z >= 0.0f && z < depth) depth = z;
+        }
+    }
+}
+
+void HierarchicalDepth::build() {
+    for(std::size_t i = 0; i != _depth.size(); ++i)
+        _pyramid[i] = Vector2{_depth[i]};
+
+    /* Each texel covers 2x2 texels of the previous level. For odd sizes the
+       last row or column covers just one. */
+    for(std::size_t level = 1; level != _levelSizes.size(); ++level) {
+        const Vector2i prevSize = _levelSizes[level - 1];
+        const Vector2* const prev = _pyramid.data() + _levelOffsets[level - 1];
+        Vector2* const current = _pyramid.data() + _levelOffsets[level];
+        for(Int y = 0; y != _levelSizes[level].y(); ++y) {
+            for(Int x = 0; x != _levelSizes[level].x(); ++x) {
+                const Int x1 = Math::min(2*x + 1, prevSize.x() - 1);
+                const Int y1 = Math::min(2*y + 1, prevSize.y() - 1);
+                const Vector2 a = prev[2*y*prevSize.x() + 2*x];
+                const Vector2 b = prev[2*y*prevSize.x() + x1];
+                const Vector2 c = prev[y1*prevSize.x() + 2*x];
+                const Vector2 d = prev[y1*prevSize.x() + x1];
+                current[y*_levelSizes[level].x() + x] = {
+                    Math::min(Math::min(a.x(), b.x()), Math::min(c.x(), d.x())),
+                    Math::max(Math::max(a.y(), b.y()), Math::max(c.y(), d.y()))};
+            }
+        }
+    }
+}
+
+bool HierarchicalDepth::isVisible(const Range2D& rectangle, const Float depth) const {
+    /* Texel range on the first level */
+    const Vector2 size{_size};
+    const Vector2i min = Math::clamp(Vector2i{Math::floor((rectangle.min()*0.5f + Vector2{0.5f})*size)}, Vector2i{}, _size - Vector2i{1});
+    const Vector2i max = Math::clamp(Vector2i{Math::floor((rectangle.max()*0.5f + Vector2{0.5f})*size)}, Vector2i{}, _size - Vector2i{1});
+
+    /* Coarsest level where the rectangle covers at most 2x2 texels */
+    Int level = 0;
+    while(std::size_t(level + 1) < _levelSizes.size() &&
+        ((max.x() >> level) - (min.x() >> level) > 1 ||
+         (max.y() >> level) - (min.y() >> level) > 1)) ++level;
+
+    _stack.clear();
+    for(Int y = min.y() >> level; y <= max.y() >> level; ++y)
+        for(Int x = min.x() >> level; x <= max.x() >> level; ++x)
+            _stack.emplace_back(level, x, y);
+
+    while(!_stack.empty()) {
+        const Vector3i texel = _stack.back();
+        _stack.pop_back();
+        const Int l = texel.x();
+        const Vector2 minMax = _pyramid[_levelOffsets[l] + texel.z()*_levelSizes[l].x() + texel.y()];
+
+        /* Everything in the texel is nearer, hidden here */
+        if(depth > minMax.y()) continue;
+
+        /* Nearer than everything in the texel or can't refine further */
+        if(depth < minMax.x() || l == 0) return true;
+
+        /* Refine the texel on the next level, only the part overlapping the
+           rectangle */
+        const Int childLevel = l - 1;
+        const Vector2i childMin = Math::max(texel.yz()*2, Vector2i{min.x() >> childLevel, min.y() >> childLevel});
+        const Vector2i childMax = Math::min(Math::min(texel.yz()*2 + Vector2i{1}, _levelSizes[childLevel] - Vector2i{1}), Vector2i{max.x() >> childLevel, max.y() >> childLevel});
+        for(Int y = childMin.y(); y <= childMax.y(); ++y)
+            for(Int x = childMin.x(); x <= childMax.x(); ++x)
+                _stack.emplace_back(childLevel, x, y);
+    }
+
+    return false;
+}
+
+bool OcclusionCuller::isGpuRasterizerSupported() {
+    #ifndef MAGNUM_TARGET_GLES
+    return true;
+    #else
+    return false;
+    #endif
+}
+
+OcclusionCuller::OcclusionCuller(const Rasterizer rasterizer): _rasterizer{rasterizer} {
+    if(_rasterizer == Rasterizer::Gpu) _shader = Shaders::Flat3D{};
+}
+
+void OcclusionCuller::setOccluder(const UnsignedInt id, std::vector<Vector3> positions, std::vector<UnsignedInt> indices, GL::Mesh& mesh, const Matrix4& meshTransformation) {
+    if(id >= _meshes.size()) _meshes.resize(id + 1);
+    _meshes[id].positions = std::move(positions);
+    _meshes[id].indices = std::move(indices);
+    _meshes[id].mesh = &mesh;
+    _meshes[id].meshTransformation = meshTransformation;
+}
+
+void OcclusionCuller::begin(const Matrix4& projectionMatrix, const Matrix4& rootMatrix, const Vector2i& viewport) {
+    _projectionMatrix = projectionMatrix;
+    _rootMatrix = rootMatrix;
+    _matrix = projectionMatrix*rootMatrix;
+    _occluders.clear();
+
+    const Vector2i size{DepthWidth, Math::max(DepthWidth*viewport.y()/Math::max(viewport.x(), 1), 1)};
+    if(size != _depth.size()) {
+        _depth.setSize(size);
+        if(_rasterizer == Rasterizer::Gpu) {
+            _depthRenderbuffer = GL::Renderbuffer{};
+            _depthRenderbuffer.setStorage(GL::RenderbufferFormat::DepthComponent32F, size);
+            _framebuffer = GL::Framebuffer{{{}, size}};
+            _framebuffer
+                .attachRenderbuffer(GL::Framebuffer::BufferAttachment::Depth, _depthRenderbuffer)
+                .mapForDraw(GL::Framebuffer::DrawAttachment::None);
+        }
+    }
+}
+
+void OcclusionCuller::addOccluder(const UnsignedInt id, const Matrix4& transformation, const Range3D& bounds) {
+    /* Approximate on-screen size by the bounding box diagonal divided by its
+       distance */
+    const Float distance = -_rootMatrix.transformPoint(bounds.center()).z();
+    _occluders.push_back({id, transformation, bounds.size().length()/Math::max(distance, 1.0e-3f)});
+}
+
+void OcclusionCuller::rasterize() {
+    /* Keep only the largest ones */
+    if(_occluders.size() > MaxOccluderCount) {
+        std::nth_element(_occluders.begin(), _occluders.begin() + MaxOccluderCount, _occluders.end(),
+            [](const Occluder& a, const Occluder& b) { return a.size > b.size; });
+        _occluders.resize(MaxOccluderCount);
+    }
+
+    /* Draw them on the GPU and read the depth back. This stalls until the
+       GPU finishes, but the buffer is small. */
+    #ifndef MAGNUM_TARGET_GLES
+    if(_rasterizer == Rasterizer::Gpu) {
+        _framebuffer
+            .clear(GL::FramebufferClear::Depth)
+            .bind();
+        for(const Occluder& occluder: _occluders) {
+            const Mesh& mesh = _meshes[occluder.id];
+            _shader.setTransformationProjectionMatrix(_matrix*occluder.transformation*mesh.meshTransformation);
+            mesh.mesh->draw(_shader);
+        }
+
+        Image2D image = _framebuffer.read({{}, _depth.size()}, Image2D{GL::PixelFormat::DepthComponent, GL::PixelType::Float});
+        const Containers::ArrayView<const Float> depth = Containers::arrayCast<const Float>(image.data());
+        std::copy(depth.begin(), depth.end(), _depth.depth().begin());
+        GL::defaultFramebuffer.bind();
+
+    /* Or transform and rasterize every triangle on the CPU */
+    } else
+    #endif
+    {
+        _depth.clear();
+        std::vector<Vector4> clip;
+        for(const Occluder& occluder: _occluders) {
+            const Mesh& mesh = _meshes[occluder.id];
+            const Matrix4 matrix = _matrix*occluder.transformation;
+            clip.resize(mesh.positions.size());
+            for(std::size_t i = 0; i != mesh.positions.size(); ++i)
+                clip[i] = matrix*Vector4{mesh.positions[i], 1.0f};
+            for(std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+                _depth.rasterize(clip[mesh.indices[i]], clip[mesh.indices[i + 1]], clip[mesh.indices[i + 2]]);
+        }
+    }
+
+    _depth.build();
+}
+
+bool OcclusionCuller::isVisible(const Range3D& bounds) const {
+    /* Screen-space rectangle and nearest depth of all eight corners. If any
+       is behind the camera, the box intersects the near plane and is
+       visible. */
+    Vector2 min{Constants::inf()}, max{-Constants::inf()};
+    Float depth = 1.0f;
+    for(std::size_t i = 0; i != 8; ++i) {
+        const Vector4 clip = _matrix*Vector4{
+            (i & 1 ? bounds.max() : bounds.min()).x(),
+            (i & 2 ? bounds.max() : bounds.min()).y(),
+            (i & 4 ? bounds.max() : bounds.min()).z(), 1.0f};
+        if(clip.w() <= 0.0f) return true;
+
+        const Vector3 ndc = clip.xyz()/clip.w();
+        min = Math::min(min, ndc.xy());
+        max = Math::max(max, ndc.xy());
+        depth = Math::min(depth, ndc.z()*0.5f + 0.5f);
+    }
+
+    return _depth.isVisible({min, max}, depth);
+}
+
+}}
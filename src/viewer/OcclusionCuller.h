@@ -0,0 +1,214 @@
+#ifndef Magnum_Examples_OcclusionCuller_h
+#define Magnum_Examples_OcclusionCuller_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Corrade/Containers/Array.h>
+#include <Magnum/GL/Framebuffer.h>
+#include <Magnum/GL/Renderbuffer.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/Shaders/Flat.h>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Hierarchical depth buffer
+
+A low-resolution depth buffer with a pyramid of minimal and maximal depth
+values above it, used to test whether a screen-space rectangle at given depth
+is hidden behind what was drawn into it. Depth values are in window space,
+with zero being the near plane. Doesn't depend on GL, the depth can be either
+rasterized in software with @ref rasterize() or filled from a GPU readback
+through @ref depth().
+*/
+class HierarchicalDepth {
+    public:
+        /** @brief Set size, implies @ref clear() */
+        void setSize(const Vector2i& size);
+
+        Vector2i size() const { return _size; }
+
+        /** @brief Clear the depth to the far plane */
+        void clear();
+
+        /**
+         * @brief Depth values
+         *
+         * Row-major, starting from the bottom row. Call @ref build() after
+         * modifying them.
+         */
+        Containers::ArrayView<Float> depth() { return _depth; }
+
+        /**
+         * @brief Rasterize a triangle
+         *
+         * Vertices are in clip space. Triangles crossing the near plane are
+         * skipped, which only makes the culling less aggressive, never
+         * wrong. Call @ref build() after all triangles are rasterized.
+         */
+        void rasterize(const Vector4& a, const Vector4& b, const Vector4& c);
+
+        /** @brief Build the min/max pyramid from the depth values */
+        void build();
+
+        /**
+         * @brief Whether a rectangle is visible
+         * @param rectangle     Rectangle in normalized device coordinates
+         * @param depth         Nearest window-space depth of the rectangle
+         *
+         * Starts at the coarsest pyramid level where the rectangle covers
+         * at most 2x2 texels. A texel nearer than the rectangle hides it, a
+         * texel further than the rectangle means it's visible and only
+         * texels where it's in between get refined on finer levels.
+         */
+        bool isVisible(const Range2D& rectangle, Float depth) const;
+
+    private:
+        Vector2i _size;
+        Containers::Array<Float> _depth;
+        /* Min and max depth of all levels one after another, the first
+           level being the full-resolution depth */
+        std::vector<Vector2> _pyramid;
+        std::vector<Vector2i> _levelSizes;
+        std::vector<std::size_t> _levelOffsets;
+        /* Level and texel coordinates, reused between tests */
+        mutable std::vector<Vector3i> _stack;
+};
+
+/**
+@brief Occlusion culling against a hierarchical depth buffer
+
+Each frame, the largest occluders in view are rendered into a
+@ref HierarchicalDepth, either on the GPU and read back, or rasterized in
+software on the CPU, which works even without a GPU. Bounding boxes of other
+objects are then projected to the screen and tested against it. Only meshes
+with their geometry set through @ref setOccluder() are used as occluders,
+which should be the ones with large simple surfaces such as walls.
+
+Transformations and bounds are relative to a common root, same as in
+@ref FrustumCuller.
+*/
+class OcclusionCuller {
+    public:
+        enum class Rasterizer: UnsignedByte {
+            Gpu,    /**< Rasterize occluders on the GPU and read the depth back */
+            Cpu     /**< Rasterize occluders in software */
+        };
+
+        /**
+         * @brief Whether the GPU rasterizer is supported
+         *
+         * Reading the depth back needs desktop GL.
+         */
+        static bool isGpuRasterizerSupported();
+
+        explicit OcclusionCuller(Rasterizer rasterizer);
+
+        Rasterizer rasterizer() const { return _rasterizer; }
+
+        /**
+         * @brief Use a mesh as an occluder
+         * @param id                    Mesh ID
+         * @param positions             Vertex positions for the software
+         *      rasterizer
+         * @param indices               Triangle indices for the software
+         *      rasterizer
+         * @param mesh                  Mesh for the GPU rasterizer
+         * @param meshTransformation    Transformation to apply to @p mesh,
+         *      such as a dequantization matrix
+         */
+        void setOccluder(UnsignedInt id, std::vector<Vector3> positions, std::vector<UnsignedInt> indices, GL::Mesh& mesh, const Matrix4& meshTransformation);
+
+        /** @brief Whether a mesh is used as an occluder */
+        bool isOccluder(UnsignedInt id) const {
+            return id < _meshes.size() && !_meshes[id].indices.empty();
+        }
+
+        /**
+         * @brief Start a new frame
+         * @param projectionMatrix  Camera projection matrix
+         * @param rootMatrix        Camera matrix multiplied with the root
+         *      transformation
+         * @param viewport          Camera viewport size, to keep the aspect
+         *      ratio of the depth buffer
+         */
+        void begin(const Matrix4& projectionMatrix, const Matrix4& rootMatrix, const Vector2i& viewport);
+
+        /**
+         * @brief Add an occluder candidate
+         * @param id                Mesh ID, expected to be an occluder
+         * @param transformation    Transformation relative to the root
+         * @param bounds            Bounding box relative to the root
+         */
+        void addOccluder(UnsignedInt id, const Matrix4& transformation, const Range3D& bounds);
+
+        /**
+         * @brief Rasterize the occluders
+         *
+         * Picks the candidates that are largest on screen, rasterizes them
+         * and builds the depth pyramid.
+         */
+        void rasterize();
+
+        /** @brief Whether a bounding box relative to the root is visible */
+        bool isVisible(const Range3D& bounds) const;
+
+        /** @brief Count of occluders rasterized in the last frame */
+        std::size_t occluderCount() const { return _occluders.size(); }
+
+    private:
+        struct Mesh {
+            std::vector<Vector3> positions;
+            std::vector<UnsignedInt> indices;
+            GL::Mesh* mesh;
+            Matrix4 meshTransformation;
+        };
+
+        struct Occluder {
+            UnsignedInt id;
+            Matrix4 transformation;
+            Float size;
+        };
+
+        Rasterizer _rasterizer;
+        std::vector<Mesh> _meshes;
+        std::vector<Occluder> _occluders;
+        Matrix4 _projectionMatrix, _rootMatrix, _matrix;
+        HierarchicalDepth _depth;
+
+        GL::Renderbuffer _depthRenderbuffer{NoCreate};
+        GL::Framebuffer _framebuffer{NoCreate};
+        Shaders::Flat3D _shader{NoCreate};
+};
+
+}}
+
+#endif
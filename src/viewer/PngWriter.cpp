@@ -0,0 +1,159 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "PngWriter.h"
+
+#include <algorithm>
+#include <Corrade/Utility/Assert.h>
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+/* Deflate stored blocks can have at most this many bytes */
+constexpr std::size_t MaxStoredBlockSize = 0xffff;
+
+void appendBigEndian(std::string& out, const UnsignedInt value) {
+    out += char(value >> 24);
+    out += char(value >> 16);
+    out += char(value >> 8);
+    out += char(value);
+}
+
+UnsignedInt crc32(UnsignedInt crc, const Containers::ArrayView<const char> data) {
+    static const auto table = [] {
+        struct Table { UnsignedInt data[256]; } out;
+        for(UnsignedInt i = 0; i != 256; ++i) {
+            UnsignedInt c = i;
+            for(std::size_t k = 0; k != 8; ++k)
+                c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            out.data[i] = c;
+        }
+        return out;
+    }();
+
+    crc = ~crc;
+    for(const char byte: data)
+        crc = table.data[(crc ^ UnsignedByte(byte)) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+UnsignedInt adler32(const UnsignedInt adler, const Containers::ArrayView<const char> data) {
+    UnsignedInt a = adler & 0xffff, b = adler >> 16;
+    for(const char byte: data) {
+        a = (a + UnsignedByte(byte)) % 65521;
+        b = (b + a) % 65521;
+    }
+    return b << 16 | a;
+}
+
+}
+
+PngWriter::PngWriter(const std::string& filename, const Vector2i& size, const UnsignedInt channelCount): _out{filename, std::ofstream::binary}, _rowSize{std::size_t(size.x())*channelCount}, _remaining{UnsignedLong(size.y())*(_rowSize + 1)} {
+    CORRADE_INTERNAL_ASSERT(channelCount == 3 || channelCount == 4);
+
+    _out.write("\x89PNG\r\n\x1a\n", 8);
+
+    /* 8 bits per channel, RGB or RGBA, no interlacing */
+    std::string header;
+    appendBigEndian(header, size.x());
+    appendBigEndian(header, size.y());
+    header += char(8);
+    header += char(channelCount == 4 ? 6 : 2);
+    header += std::string(3, '\0');
+    writeChunk("IHDR", {header.data(), header.size()});
+
+    /* Zlib stream header, the lowest compression level */
+    writeChunk("IDAT", {"\x78\x01", 2});
+}
+
+void PngWriter::writeRows(const Containers::ArrayView<const char> data) {
+    CORRADE_INTERNAL_ASSERT(data.size() % _rowSize == 0);
+
+    /* Put the bytes into stored blocks, starting a new one when the current
+       is full. Blocks can span more calls, the very last one of the image is
+       marked as final. */
+    _buffer.clear();
+    auto append = [&](const char* bytes, std::size_t size) {
+        _adler32 = adler32(_adler32, {bytes, size});
+        while(size) {
+            if(!_blockRemaining) {
+                CORRADE_INTERNAL_ASSERT(_remaining);
+                _blockRemaining = std::min(_remaining, UnsignedLong(MaxStoredBlockSize));
+                _remaining -= _blockRemaining;
+                _buffer += char(_remaining ? 0 : 1);
+                _buffer += char(_blockRemaining);
+                _buffer += char(_blockRemaining >> 8);
+                _buffer += char(~_blockRemaining);
+                _buffer += char(~_blockRemaining >> 8);
+            }
+
+            const std::size_t blockSize = std::min(size, _blockRemaining);
+            _buffer.append(bytes, blockSize);
+            bytes += blockSize;
+            size -= blockSize;
+            _blockRemaining -= blockSize;
+        }
+    };
+
+    /* Each row is prefixed with a filter type, zero means no filtering */
+    for(std::size_t offset = 0; offset != data.size(); offset += _rowSize) {
+        const char filter = 0;
+        append(&filter, 1);
+        append(data + offset, _rowSize);
+    }
+
+    writeChunk("IDAT", {_buffer.data(), _buffer.size()});
+}
+
+bool PngWriter::finish() {
+    CORRADE_INTERNAL_ASSERT(!_remaining && !_blockRemaining);
+
+    std::string checksum;
+    appendBigEndian(checksum, _adler32);
+    writeChunk("IDAT", {checksum.data(), checksum.size()});
+    writeChunk("IEND", {});
+
+    _out.close();
+    return bool(_out);
+}
+
+void PngWriter::writeChunk(const char* const type, const Containers::ArrayView<const char> data) {
+    std::string header;
+    appendBigEndian(header, data.size());
+    header.append(type, 4);
+    _out.write(header.data(), header.size());
+    _out.write(data.data(), data.size());
+
+    std::string footer;
+    appendBigEndian(footer, crc32(crc32(0, {type, 4}), data));
+    _out.write(footer.data(), footer.size());
+}
+
+}}
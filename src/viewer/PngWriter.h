@@ -0,0 +1,95 @@
+#ifndef Magnum_Examples_PngWriter_h
+#define Magnum_Examples_PngWriter_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <fstream>
+#include <string>
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector2.h>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief PNG file written row by row
+
+Unlike image converter plugins, which need the whole image in memory, this
+writes the image rows as they come, so arbitrarily large images can be
+produced with memory for just a few rows. To not depend on zlib, the pixel
+data are stored in uncompressed deflate blocks --- the file is as large as
+the raw pixels, but any PNG reader can open it.
+
+Only 8-bit RGB and RGBA is supported.
+*/
+class PngWriter {
+    public:
+        /**
+         * @brief Open a file and write the header
+         * @param filename      File to write to
+         * @param size          Image size
+         * @param channelCount  Either 3 for RGB or 4 for RGBA
+         */
+        explicit PngWriter(const std::string& filename, const Vector2i& size, UnsignedInt channelCount);
+
+        /** @brief Whether the file was opened and all writes succeeded */
+        bool isGood() const { return bool(_out); }
+
+        /**
+         * @brief Write rows
+         *
+         * Expects whole tightly-packed rows, top to bottom. All rows
+         * together have to add up to the image height.
+         */
+        void writeRows(Containers::ArrayView<const char> data);
+
+        /**
+         * @brief Finish the file
+         *
+         * Expects that all rows were written. Returns @cpp false @ce if
+         * anything failed to be written.
+         */
+        bool finish();
+
+    private:
+        void writeChunk(const char* type, Containers::ArrayView<const char> data);
+
+        std::ofstream _out;
+        std::size_t _rowSize;
+        /* Bytes of the zlib stream not yet assigned to a block and left in
+           the current block */
+        UnsignedLong _remaining;
+        std::size_t _blockRemaining{};
+        UnsignedInt _adler32{1};
+        std::string _buffer;
+};
+
+}}
+
+#endif
@@ -0,0 +1,172 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "QuantizedMesh.h"
+
+#include <tuple>
+#include <Magnum/Mesh.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Packing.h>
+#include <Magnum/MeshTools/CompressIndices.h>
+#include <Magnum/Shaders/Generic.h>
+#include <Magnum/Trade/MeshData3D.h>
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+/* Flat meshes have a zero-sized bounding box along one axis. Use a unit scale
+   there instead so the positions can be divided by it. */
+Vector3 boundsScale(const Range3D& bounds) {
+    Vector3 scale = bounds.size();
+    for(std::size_t i = 0; i != 3; ++i)
+        if(!(scale[i] > 0.0f)) scale[i] = 1.0f;
+    return scale;
+}
+
+UnsignedInt packNormal(const Vector3& normal) {
+    const Math::Vector3<Int> packed{Math::round(Math::clamp(normal, -1.0f, 1.0f)*511.0f)};
+    return (UnsignedInt(packed.x()) & 0x3ff) |
+           (UnsignedInt(packed.y()) & 0x3ff) << 10 |
+           (UnsignedInt(packed.z()) & 0x3ff) << 20;
+}
+
+}
+
+static_assert(sizeof(QuantizedVertex) == 16, "unexpected quantized vertex size");
+
+Matrix4 dequantizationMatrix(const Range3D& bounds) {
+    return Matrix4::translation(bounds.min())*Matrix4::scaling(boundsScale(bounds));
+}
+
+Containers::Array<QuantizedVertex> quantizeVertices(const Range3D& bounds, const Containers::StridedArrayView1D<const Vector3>& positions, const Containers::StridedArrayView1D<const Vector3>& normals, const Containers::StridedArrayView1D<const Vector2>& textureCoordinates) {
+    const Vector3 scale = boundsScale(bounds);
+
+    Containers::Array<QuantizedVertex> out{Containers::ValueInit, positions.size()};
+    for(std::size_t i = 0; i != positions.size(); ++i) {
+        QuantizedVertex& vertex = out[i];
+        vertex.position = Math::pack<Math::Vector3<UnsignedShort>>(
+            Math::clamp((positions[i] - bounds.min())/scale, 0.0f, 1.0f));
+
+        if(!normals.empty() && !normals[i].isZero())
+            vertex.normal = packNormal(normals[i].normalized());
+
+        if(!textureCoordinates.empty())
+            vertex.textureCoordinates = Math::packHalf(textureCoordinates[i]);
+    }
+
+    return out;
+}
+
+void addQuantizedVertexBuffer(GL::Mesh& mesh, GL::Buffer&& buffer, const bool textureCoordinates) {
+    /* The packed normal format needs four components, the shaders use just
+       the first three */
+    typedef Shaders::Generic3D::Position Position;
+    typedef Shaders::Generic3D::TextureCoordinates TextureCoordinates;
+    typedef GL::Attribute<Shaders::Generic3D::Normal::Location, Vector4> PackedNormal;
+
+    const Position position{Position::DataType::UnsignedShort, Position::DataOption::Normalized};
+    const PackedNormal normal{PackedNormal::DataType::Int2101010Rev, PackedNormal::DataOption::Normalized};
+    if(textureCoordinates)
+        mesh.addVertexBuffer(std::move(buffer), 0, position, 2,
+            TextureCoordinates{TextureCoordinates::DataType::Half}, normal);
+    else
+        mesh.addVertexBuffer(std::move(buffer), 0, position, 6, normal);
+}
+
+GL::Mesh compileQuantized(const Trade::MeshData3D& data, const Range3D& bounds) {
+    const std::vector<Vector3>& positions = data.positions(0);
+    Containers::ArrayView<const Vector3> normals;
+    Containers::ArrayView<const Vector2> textureCoordinates;
+    if(data.hasNormals())
+        normals = Containers::arrayView(data.normals(0).data(), data.normals(0).size());
+    if(data.hasTextureCoords2D())
+        textureCoordinates = Containers::arrayView(data.textureCoords2D(0).data(), data.textureCoords2D(0).size());
+
+    const Containers::Array<QuantizedVertex> vertexData = quantizeVertices(bounds, Containers::arrayView(positions.data(), positions.size()), normals, textureCoordinates);
+    GL::Buffer vertices;
+    vertices.setData(vertexData, GL::BufferUsage::StaticDraw);
+
+    GL::Mesh mesh;
+    mesh.setPrimitive(data.primitive());
+    addQuantizedVertexBuffer(mesh, std::move(vertices), data.hasTextureCoords2D());
+
+    if(data.isIndexed()) {
+        Containers::Array<char> indexData;
+        MeshIndexType indexType;
+        UnsignedInt indexStart, indexEnd;
+        std::tie(indexData, indexType, indexStart, indexEnd) = MeshTools::compressIndices(data.indices());
+
+        GL::Buffer indices;
+        indices.setData(indexData, GL::BufferUsage::StaticDraw);
+        mesh.setCount(data.indices().size())
+            .setIndexBuffer(std::move(indices), 0, indexType, indexStart, indexEnd);
+    } else mesh.setCount(positions.size());
+
+    return mesh;
+}
+
+GL::Mesh compilePositions(const MeshPrimitive primitive, const Containers::StridedArrayView1D<const Vector3>& positions, const Range3D& bounds, const bool quantized, const Containers::ArrayView<const char> indexData, const MeshIndexType indexType, const UnsignedInt indexStart, const UnsignedInt indexEnd, const UnsignedInt count) {
+    typedef Shaders::Generic3D::Position Position;
+
+    GL::Mesh mesh;
+    mesh.setPrimitive(primitive)
+        .setCount(count);
+
+    /* Quantized positions are padded to four bytes like in the full
+       vertex */
+    GL::Buffer vertices;
+    if(quantized) {
+        const Containers::Array<QuantizedVertex> quantizedData = quantizeVertices(bounds, positions, {}, {});
+        Containers::Array<Math::Vector4<UnsignedShort>> vertexData{Containers::NoInit, positions.size()};
+        for(std::size_t i = 0; i != positions.size(); ++i)
+            vertexData[i] = {quantizedData[i].position, 0};
+        vertices.setData(vertexData, GL::BufferUsage::StaticDraw);
+        mesh.addVertexBuffer(std::move(vertices), 0,
+            Position{Position::DataType::UnsignedShort, Position::DataOption::Normalized}, 2);
+    } else {
+        Containers::Array<Vector3> vertexData{Containers::NoInit, positions.size()};
+        for(std::size_t i = 0; i != positions.size(); ++i)
+            vertexData[i] = positions[i];
+        vertices.setData(vertexData, GL::BufferUsage::StaticDraw);
+        mesh.addVertexBuffer(std::move(vertices), 0, Position{});
+    }
+
+    if(!indexData.empty()) {
+        GL::Buffer indices;
+        indices.setData(indexData, GL::BufferUsage::StaticDraw);
+        mesh.setIndexBuffer(std::move(indices), 0, indexType, indexStart, indexEnd);
+    }
+
+    return mesh;
+}
+
+}}
@@ -0,0 +1,113 @@
+#ifndef Magnum_Examples_QuantizedMesh_h
+#define Magnum_Examples_QuantizedMesh_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Magnum/Mesh.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/GL/GL.h>
+#include <Magnum/Trade/Trade.h>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Compact vertex layout
+
+Half the size of the 32-bit float position, normal and texture coordinate
+layout produced by @ref MeshTools::compile(). Everything is decoded by the
+vertex fetch, so the stock @ref Shaders::Phong and @ref Shaders::Flat work
+unchanged --- it only needs the matrix from @ref dequantizationMatrix()
+applied on top of the object transformation, while the normal matrix is
+derived from the object transformation alone.
+*/
+struct QuantizedVertex {
+    /**
+     * Position relative to the mesh bounding box, normalized to the full
+     * range of the type
+     */
+    Math::Vector3<UnsignedShort> position;
+    UnsignedShort:16;
+
+    /** Texture coordinates as half-floats, zero if the mesh has none */
+    Math::Vector2<UnsignedShort> textureCoordinates;
+
+    /** Unit normal packed as signed normalized 2-10-10-10 */
+    UnsignedInt normal;
+};
+
+/**
+@brief Matrix converting quantized positions back to the mesh space
+
+Maps the unit cube to @p bounds. Multiply it from the right to the object
+transformation, but derive the normal matrix from the object transformation
+only --- the normals are stored unscaled.
+*/
+Matrix4 dequantizationMatrix(const Range3D& bounds);
+
+/**
+@brief Quantize vertex data
+
+Positions are expected to be inside @p bounds. @p textureCoordinates can be
+empty.
+*/
+Containers::Array<QuantizedVertex> quantizeVertices(const Range3D& bounds, const Containers::StridedArrayView1D<const Vector3>& positions, const Containers::StridedArrayView1D<const Vector3>& normals, const Containers::StridedArrayView1D<const Vector2>& textureCoordinates);
+
+/**
+@brief Add a buffer with quantized vertices to a mesh
+
+Configures the attributes for the @ref Shaders::Generic locations. Texture
+coordinates are added only if @p textureCoordinates is @cpp true @ce.
+*/
+void addQuantizedVertexBuffer(GL::Mesh& mesh, GL::Buffer&& buffer, bool textureCoordinates);
+
+/**
+@brief Compile a mesh with quantized vertices
+
+Like @ref MeshTools::compile(), but with the @ref QuantizedVertex layout and
+positions relative to @p bounds.
+*/
+GL::Mesh compileQuantized(const Trade::MeshData3D& data, const Range3D& bounds);
+
+/**
+@brief Compile a position-only mesh
+
+Used for the depth pre-pass. If @p quantized is set, positions are quantized
+relative to @p bounds the same way as in @ref quantizeVertices(), so they
+match the full mesh exactly, otherwise @p bounds are ignored. The
+@p indexData are expected to be already compressed, pass an empty view for a
+non-indexed mesh. The @p count is the index or vertex count to draw.
+*/
+GL::Mesh compilePositions(MeshPrimitive primitive, const Containers::StridedArrayView1D<const Vector3>& positions, const Range3D& bounds, bool quantized, Containers::ArrayView<const char> indexData, MeshIndexType indexType, UnsignedInt indexStart, UnsignedInt indexEnd, UnsignedInt count);
+
+}}
+
+#endif
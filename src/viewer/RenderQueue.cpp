@@ -0,0 +1,314 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "RenderQueue.h"
+
+#include <utility>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/MeshView.h>
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/GL/Texture.h>
+#include <Magnum/Math/Constants.h>
+#include <Magnum/SceneGraph/Camera.h>
+#include <Magnum/Shaders/Flat.h>
+#include <Magnum/Shaders/Phong.h>
+
+namespace Magnum { namespace Examples {
+
+#ifndef MAGNUM_TARGET_GLES
+namespace {
+
+/* Sample queries used in turns. Three are enough for the result to be
+   available by the time a query gets reused even with a few frames queued
+   up in the driver. */
+constexpr std::size_t SampleQueryCount = 3;
+
+}
+#endif
+
+RenderQueue::RenderQueue(Shaders::Flat3D& coloredShader, Shaders::Phong& texturedShader): _coloredShader(coloredShader), _texturedShader(texturedShader) {}
+
+void RenderQueue::addColored(const Matrix4& transformationMatrix, const Matrix3x3& normalMatrix, const UnsignedInt meshId, GL::Mesh& mesh, const MeshLevel& level, const Color4& color) {
+    _draws.push_back({transformationMatrix, normalMatrix, &mesh, level, nullptr, color, -transformationMatrix.translation().z(), meshId, 0});
+}
+
+void RenderQueue::addTextured(const Matrix4& transformationMatrix, const Matrix3x3& normalMatrix, const UnsignedInt meshId, GL::Mesh& mesh, const MeshLevel& level, const UnsignedInt textureId, GL::Texture2D& texture) {
+    _draws.push_back({transformationMatrix, normalMatrix, &mesh, level, &texture, {}, -transformationMatrix.translation().z(), meshId, textureId});
+}
+
+#ifndef MAGNUM_TARGET_GLES
+RenderQueue& RenderQueue::setSampleCounting(const bool enabled) {
+    if(!enabled) _sampleQueries.clear();
+    else if(_sampleQueries.empty()) {
+        _sampleQueries.reserve(SampleQueryCount);
+        for(std::size_t i = 0; i != SampleQueryCount; ++i)
+            _sampleQueries.emplace_back(GL::SampleQuery::Target::SamplesPassed);
+    }
+    _nextSampleQuery = 0;
+    _pendingSampleQueries = 0;
+    _shadedSampleCount = 0;
+    return *this;
+}
+
+UnsignedLong RenderQueue::shadedSampleCount() {
+    /* Take the newest result the GPU already finished. Anything older than
+       that is outdated, so it's dropped. */
+    for(UnsignedInt i = 0; i != _pendingSampleQueries; ++i) {
+        GL::SampleQuery& query = _sampleQueries[(_nextSampleQuery + SampleQueryCount - 1 - i) % SampleQueryCount];
+        if(!query.resultAvailable()) continue;
+
+        _shadedSampleCount = query.result<UnsignedLong>();
+        _pendingSampleQueries = i;
+        break;
+    }
+
+    return _shadedSampleCount;
+}
+#endif
+
+void RenderQueue::sort() {
+    /* LSD radix sort, eight bits at a time. Histograms of all digits are
+       calculated in a single pass and digits that are the same for all keys
+       are skipped, which is quite common for the high bits. */
+    UnsignedInt histogram[8][256]{};
+    for(const Key& key: _keys)
+        for(std::size_t digit = 0; digit != 8; ++digit)
+            ++histogram[digit][(key.key >> 8*digit) & 0xff];
+
+    _keysScratch.resize(_keys.size());
+    for(std::size_t digit = 0; digit != 8; ++digit) {
+        UnsignedInt* const offsets = histogram[digit];
+        if(offsets[(_keys.front().key >> 8*digit) & 0xff] == _keys.size())
+            continue;
+
+        UnsignedInt offset = 0;
+        for(std::size_t i = 0; i != 256; ++i) {
+            const UnsignedInt count = offsets[i];
+            offsets[i] = offset;
+            offset += count;
+        }
+
+        for(const Key& key: _keys)
+            _keysScratch[offsets[(key.key >> 8*digit) & 0xff]++] = key;
+        std::swap(_keys, _keysScratch);
+    }
+}
+
+void RenderQueue::drawPrepass() {
+    /* No color writes and no state changes except for the mesh, the order is
+       the same as for the shading pass after */
+    GL::Renderer::setColorMask(false, false, false, false);
+
+    ++_programSwitches;
+    for(const Key& key: _keys) {
+        /* Blended draws don't write depth */
+        if(key.key >> 63) continue;
+
+        const Draw& entry = _draws[key.draw];
+        GL::Mesh& mesh = entry.meshId < _depthMeshes.size() && _depthMeshes[entry.meshId] ? *_depthMeshes[entry.meshId] : *entry.mesh;
+        _depthShader->setTransformationMatrix(entry.transformationMatrix);
+        _uniformUploadSize += sizeof(Matrix4);
+        ++_drawCallCount;
+
+        if(entry.level.indexCount) GL::MeshView{mesh}
+            .setCount(entry.level.indexCount)
+            .setIndexRange(entry.level.indexOffset)
+            .draw(*_depthShader);
+        else mesh.draw(*_depthShader);
+    }
+
+    /* Shade only what's exactly at the depth written above, no need to
+       write it again */
+    GL::Renderer::setColorMask(true, true, true, true);
+    GL::Renderer::setDepthFunction(GL::Renderer::DepthFunction::Equal);
+    GL::Renderer::setDepthMask(false);
+}
+
+void RenderQueue::draw(SceneGraph::Camera3D& camera, const Vector3& lightPosition) {
+    _programSwitches = _textureSwitches = _meshSwitches = 0;
+    _drawCallCount = _draws.size();
+    _uniformUploadSize = 0;
+    if(_draws.empty()) {
+        #ifndef MAGNUM_TARGET_GLES
+        _pendingSampleQueries = 0;
+        _shadedSampleCount = 0;
+        #endif
+        return;
+    }
+
+    /* Depth is quantized relative to the range covered by all draws */
+    Float minDepth = Constants::inf(), maxDepth = -Constants::inf();
+    for(const Draw& entry: _draws) {
+        minDepth = Math::min(minDepth, entry.depth);
+        maxDepth = Math::max(maxDepth, entry.depth);
+    }
+    const Double depthScale = maxDepth > minDepth ? 1.0/Double(maxDepth - minDepth) : 0.0;
+
+    /* Opaque keys have the highest bit zero, then one bit for the shader, 16
+       bits for texture ID, 16 bits for mesh ID and 30 bits of depth, nearest
+       first. Blended keys have the highest bit set, followed by 32 bits of
+       depth, farthest first. The mesh ID is in the lowest bits there to
+       break ties. IDs that don't fit are truncated, which only makes the
+       order slightly worse. */
+    _keys.clear();
+    for(std::size_t i = 0; i != _draws.size(); ++i) {
+        const Draw& entry = _draws[i];
+        const Double depth = (entry.depth - minDepth)*depthScale;
+        UnsignedLong key;
+        if(!entry.texture && entry.color.a() < 1.0f) {
+            key = 1ull << 63 |
+                UnsignedLong((1.0 - depth)*0xffffffffu) << 31 |
+                (entry.meshId & 0xffff);
+        } else {
+            key = UnsignedLong(entry.texture ? 1 : 0) << 62 |
+                UnsignedLong(entry.textureId & 0xffff) << 46 |
+                UnsignedLong(entry.meshId & 0xffff) << 30 |
+                UnsignedLong(depth*0x3fffffff);
+        }
+        _keys.push_back({key, UnsignedInt(i)});
+    }
+    if(_sorted) sort();
+
+    /* The depth would differ between the stock shaders and the depth-only
+       shader, so the pre-pass is done only with the uniform block ones */
+    const bool prepass = _depthShader && _coloredSceneShader && _texturedSceneShader;
+    if(prepass) drawPrepass();
+
+    #ifndef MAGNUM_TARGET_GLES
+    /* If the query being reused was never read, its result is lost, which
+       is fine as there's a newer one by then */
+    if(!_sampleQueries.empty()) _sampleQueries[_nextSampleQuery].begin();
+    #endif
+
+    GL::AbstractShaderProgram* currentShader = nullptr;
+    GL::Texture2D* currentTexture = nullptr;
+    GL::Mesh* currentMesh = nullptr;
+    bool blending = false;
+    for(const Key& key: _keys) {
+        const Draw& entry = _draws[key.draw];
+
+        /* Blended draws are all at the end if sorted, but not otherwise */
+        const bool blended = key.key >> 63;
+        if(blended != blending) {
+            blending = blended;
+            GL::Renderer::setFeature(GL::Renderer::Feature::Blending, blending);
+            GL::Renderer::setBlendFunction(
+                GL::Renderer::BlendFunction::SourceAlpha,
+                GL::Renderer::BlendFunction::OneMinusSourceAlpha);
+            GL::Renderer::setDepthMask(!blending && !prepass);
+
+            /* Blended draws are tested against the full depth buffer from
+               the pre-pass */
+            if(prepass) GL::Renderer::setDepthFunction(blending ?
+                GL::Renderer::DepthFunction::Less :
+                GL::Renderer::DepthFunction::Equal);
+        }
+
+        /* Projection and light are already in the uniform buffer */
+        if(entry.texture && _texturedSceneShader) {
+            if(currentShader != _texturedSceneShader) {
+                ++_programSwitches;
+                currentShader = _texturedSceneShader;
+            }
+            if(currentTexture != entry.texture) {
+                ++_textureSwitches;
+                currentTexture = entry.texture;
+                _texturedSceneShader->bindDiffuseTexture(*entry.texture);
+            }
+            _texturedSceneShader->setTransformationMatrix(entry.transformationMatrix)
+                .setNormalMatrix(entry.normalMatrix);
+            _uniformUploadSize += sizeof(Matrix4) + sizeof(Matrix3x3);
+        } else if(!entry.texture && _coloredSceneShader) {
+            if(currentShader != _coloredSceneShader) {
+                ++_programSwitches;
+                currentShader = _coloredSceneShader;
+            }
+            _coloredSceneShader->setTransformationMatrix(entry.transformationMatrix)
+                .setColor(entry.color);
+            _uniformUploadSize += sizeof(Matrix4) + sizeof(Color4);
+        } else if(entry.texture) {
+            if(currentShader != &_texturedShader) {
+                ++_programSwitches;
+                currentShader = &_texturedShader;
+                _texturedShader
+                    .setLightPosition(lightPosition)
+                    .setProjectionMatrix(camera.projectionMatrix());
+                _uniformUploadSize += sizeof(Vector3) + sizeof(Matrix4);
+            }
+            if(currentTexture != entry.texture) {
+                ++_textureSwitches;
+                currentTexture = entry.texture;
+                _texturedShader.bindDiffuseTexture(*entry.texture);
+            }
+            _texturedShader
+                .setTransformationMatrix(entry.transformationMatrix)
+                .setNormalMatrix(entry.normalMatrix);
+            _uniformUploadSize += sizeof(Matrix4) + sizeof(Matrix3x3);
+        } else {
+            if(currentShader != &_coloredShader) {
+                ++_programSwitches;
+                currentShader = &_coloredShader;
+            }
+            _coloredShader
+                .setTransformationProjectionMatrix(camera.projectionMatrix()*entry.transformationMatrix)
+                .setColor(entry.color);
+            _uniformUploadSize += sizeof(Matrix4) + sizeof(Color4);
+        }
+
+        if(currentMesh != entry.mesh) {
+            ++_meshSwitches;
+            currentMesh = entry.mesh;
+        }
+
+        /* Levels of detail are ranges in the same index buffer */
+        if(entry.level.indexCount) GL::MeshView{*entry.mesh}
+            .setCount(entry.level.indexCount)
+            .setIndexRange(entry.level.indexOffset)
+            .draw(*currentShader);
+        else entry.mesh->draw(*currentShader);
+    }
+
+    #ifndef MAGNUM_TARGET_GLES
+    if(!_sampleQueries.empty()) {
+        _sampleQueries[_nextSampleQuery].end();
+        _nextSampleQuery = (_nextSampleQuery + 1) % SampleQueryCount;
+        _pendingSampleQueries = Math::min(_pendingSampleQueries + 1, UnsignedInt(SampleQueryCount));
+    }
+    #endif
+
+    if(blending) GL::Renderer::disable(GL::Renderer::Feature::Blending);
+    if(blending || prepass) {
+        GL::Renderer::setDepthMask(true);
+        GL::Renderer::setDepthFunction(GL::Renderer::DepthFunction::Less);
+    }
+
+    _draws.clear();
+}
+
+}}
@@ -0,0 +1,261 @@
+#ifndef Magnum_Examples_RenderQueue_h
+#define Magnum_Examples_RenderQueue_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/Optional.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/GL/GL.h>
+#ifndef MAGNUM_TARGET_GLES
+#include <Magnum/GL/SampleQuery.h>
+#endif
+#include <Magnum/SceneGraph/SceneGraph.h>
+#include <Magnum/Shaders/Shaders.h>
+
+#include "MeshLod.h"
+#include "SceneShader.h"
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Render queue sorted by GL state
+
+Drawables add their draws here instead of issuing them directly. On
+@ref draw() the queue radix-sorts them by a 64-bit key and submits them in
+that order, setting uniforms that are the same for all draws only when the
+shader changes and binding a texture only when it differs from the previous
+draw.
+
+If @ref SceneShader "SceneShaders" are set, the projection matrix and light
+position are taken from the @ref FrameUniforms buffer instead and only the
+per-draw uniforms are set.
+
+Opaque draws come first, ordered by shader, texture, mesh and then
+front-to-back, so draws sharing state are adjacent and the nearest ones get
+drawn first to maximize early depth test rejection. Translucent draws ---
+flat-colored ones with alpha less than one --- are drawn after with blending
+enabled and depth writes disabled, ordered back-to-front by their origin.
+
+With @ref setDepthPrepass(), opaque draws are first rendered into the depth
+buffer only, using position-only meshes, and then shaded with
+@ref GL::Renderer::DepthFunction::Equal, so every covered sample gets shaded
+just once regardless of the draw order. That pays off when fragment shading
+is expensive and there's a lot of overdraw, otherwise it's just twice the
+vertex work. @ref setSampleCounting() measures the difference.
+*/
+class RenderQueue {
+    public:
+        explicit RenderQueue(Shaders::Flat3D& coloredShader, Shaders::Phong& texturedShader);
+
+        /**
+         * @brief Whether to sort the draws
+         *
+         * Enabled by default. If disabled, the draws are submitted in the
+         * order they were added, which makes it possible to compare the state
+         * switch counts.
+         */
+        RenderQueue& setSorted(bool sorted) {
+            _sorted = sorted;
+            return *this;
+        }
+
+        /**
+         * @brief Draw with shaders using the per-frame uniform block
+         *
+         * If set, the shaders passed in the constructor are not used. Pass
+         * @cpp nullptr @ce for both to go back to them.
+         */
+        RenderQueue& setSceneShaders(SceneShader* coloredShader, SceneShader* texturedShader) {
+            _coloredSceneShader = coloredShader;
+            _texturedSceneShader = texturedShader;
+            return *this;
+        }
+
+        /**
+         * @brief Meshes for the depth pre-pass
+         *
+         * Position-only meshes indexed by the mesh ID passed to
+         * @ref addColored() and @ref addTextured(), with the same vertex
+         * format and index buffer as the full meshes so the depth matches
+         * exactly. Draws with a mesh ID outside of the range or a
+         * @ref Containers::NullOpt mesh use the full mesh instead.
+         */
+        RenderQueue& setDepthMeshes(Containers::ArrayView<Containers::Optional<GL::Mesh>> meshes) {
+            _depthMeshes = meshes;
+            return *this;
+        }
+
+        /**
+         * @brief Enable a depth pre-pass
+         *
+         * The @p shader is expected to be a @ref SceneShader::Flag::DepthOnly
+         * variant. Used only together with @ref setSceneShaders(), as depth
+         * of the stock shaders isn't guaranteed to match. Pass
+         * @cpp nullptr @ce to disable the pre-pass again.
+         */
+        RenderQueue& setDepthPrepass(SceneShader* shader) {
+            _depthShader = shader;
+            return *this;
+        }
+
+        /** @brief Depth pre-pass shader or @cpp nullptr @ce if disabled */
+        SceneShader* depthPrepass() const { return _depthShader; }
+
+        #ifndef MAGNUM_TARGET_GLES
+        /**
+         * @brief Count samples passing the depth test in the shading pass
+         *
+         * Wraps everything after the depth pre-pass in an occlusion query.
+         * A few queries are used in turns, so results are read only once the
+         * GPU finished them and the CPU never waits. Disabled by default. Not
+         * available on OpenGL ES.
+         */
+        RenderQueue& setSampleCounting(bool enabled);
+
+        /**
+         * @brief Samples shaded in the last finished @ref draw()
+         *
+         * Doesn't wait for the GPU, so this is usually the count from one or
+         * two frames back. Returns @cpp 0 @ce if sample counting is disabled,
+         * no result is available yet or the last @ref draw() had nothing to
+         * draw. With the depth pre-pass enabled this is
+         * close to the count of covered samples, without it includes all
+         * overdraw that wasn't rejected by the early depth test.
+         */
+        UnsignedLong shadedSampleCount();
+        #endif
+
+        /**
+         * @brief Add a flat-colored draw
+         * @param transformationMatrix  Object transformation relative to the
+         *      camera
+         * @param normalMatrix  Normal matrix. Passed separately as the
+         *      transformation can include mesh dequantization, which
+         *      doesn't apply to normals.
+         * @param meshId    Small integer identifying the mesh, used for sorting
+         * @param mesh      Mesh
+         * @param level     Level of detail to draw
+         * @param color     Color. If alpha is less than one, the draw is
+         *      blended.
+         */
+        void addColored(const Matrix4& transformationMatrix, const Matrix3x3& normalMatrix, UnsignedInt meshId, GL::Mesh& mesh, const MeshLevel& level, const Color4& color);
+
+        /**
+         * @brief Add a textured draw
+         *
+         * Similar to @ref addColored(), @p textureId is again a small integer
+         * identifying the texture for sorting.
+         */
+        void addTextured(const Matrix4& transformationMatrix, const Matrix3x3& normalMatrix, UnsignedInt meshId, GL::Mesh& mesh, const MeshLevel& level, UnsignedInt textureId, GL::Texture2D& texture);
+
+        /**
+         * @brief Sort and submit all draws
+         * @param camera        Camera the draws were collected with
+         * @param lightPosition Light position in camera space
+         *
+         * With @ref setSceneShaders(), @p camera and @p lightPosition are
+         * expected to be already uploaded in @ref FrameUniforms. Clears the
+         * queue afterwards.
+         */
+        void draw(SceneGraph::Camera3D& camera, const Vector3& lightPosition);
+
+        /** @brief Shader program changes in the last @ref draw() */
+        UnsignedInt programSwitches() const { return _programSwitches; }
+
+        /** @brief Texture binding changes in the last @ref draw() */
+        UnsignedInt textureSwitches() const { return _textureSwitches; }
+
+        /** @brief Mesh (vertex array) changes in the last @ref draw() */
+        UnsignedInt meshSwitches() const { return _meshSwitches; }
+
+        /**
+         * @brief Draw calls submitted in the last @ref draw()
+         *
+         * Includes draws done in the depth pre-pass.
+         */
+        UnsignedInt drawCallCount() const { return _drawCallCount; }
+
+        /**
+         * @brief Bytes of uniform data set in the last @ref draw()
+         *
+         * Includes both the per-draw and per-shader uniforms, not the
+         * @ref FrameUniforms buffer.
+         */
+        UnsignedLong uniformUploadSize() const { return _uniformUploadSize; }
+
+    private:
+        struct Draw {
+            Matrix4 transformationMatrix;
+            Matrix3x3 normalMatrix;
+            GL::Mesh* mesh;
+            MeshLevel level;
+            GL::Texture2D* texture;
+            Color4 color;
+            Float depth;
+            UnsignedInt meshId, textureId;
+        };
+
+        struct Key {
+            UnsignedLong key;
+            UnsignedInt draw;
+        };
+
+        void sort();
+        void drawPrepass();
+
+        Shaders::Flat3D& _coloredShader;
+        Shaders::Phong& _texturedShader;
+        SceneShader* _coloredSceneShader{};
+        SceneShader* _texturedSceneShader{};
+        SceneShader* _depthShader{};
+        Containers::ArrayView<Containers::Optional<GL::Mesh>> _depthMeshes;
+        #ifndef MAGNUM_TARGET_GLES
+        /* Ring of sample queries, the pending ones are those ended but not
+           read yet, the newest right before the next one to use */
+        std::vector<GL::SampleQuery> _sampleQueries;
+        std::size_t _nextSampleQuery{};
+        UnsignedInt _pendingSampleQueries{};
+        UnsignedLong _shadedSampleCount{};
+        #endif
+        bool _sorted{true};
+
+        /* Reused between frames to avoid allocations */
+        std::vector<Draw> _draws;
+        std::vector<Key> _keys, _keysScratch;
+
+        UnsignedInt _programSwitches{}, _textureSwitches{}, _meshSwitches{}, _drawCallCount{};
+        UnsignedLong _uniformUploadSize{};
+};
+
+}}
+
+#endif
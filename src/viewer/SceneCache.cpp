@@ -0,0 +1,486 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "SceneCache.h"
+
+#include <cstring>
+#include <tuple>
+#include <sys/stat.h>
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/Utility/Debug.h>
+#include <Corrade/Utility/String.h>
+#include <Magnum/Mesh.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/Math/Constants.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/MeshTools/CompressIndices.h>
+#include <Magnum/MeshTools/Interleave.h>
+#include <Magnum/Shaders/Generic.h>
+#include <Magnum/Trade/MeshData3D.h>
+#include <Magnum/Trade/TextureData.h>
+
+#include "QuantizedMesh.h"
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+/* Bump whenever any of the records change */
+constexpr UnsignedInt Version = 5;
+
+struct Header {
+    char magic[8];
+    UnsignedInt version;
+    UnsignedInt meshCount, textureCount, materialCount, objectCount;
+    Int:32;
+    UnsignedLong sourceSize;
+    Long sourceTime;
+    UnsignedLong meshOffset, textureOffset, materialOffset, objectOffset;
+    UnsignedLong dataOffset, dataSize;
+};
+
+constexpr const char Magic[8]{'M', 'G', 'N', 'V', 'W', 'C', 'H', '\0'};
+
+/* The records are read directly from the mapped memory, so make sure they
+   have the same layout everywhere */
+static_assert(sizeof(Header) == 96, "unexpected header size");
+static_assert(sizeof(ObjectRecord) == 80, "unexpected object record size");
+static_assert(sizeof(MaterialRecord) == 32, "unexpected material record size");
+static_assert(sizeof(MeshRecord) == 104, "unexpected mesh record size");
+static_assert(sizeof(TextureRecord) == 56, "unexpected texture record size");
+
+/* Keep everything in the file aligned so the records can be accessed in
+   place */
+constexpr std::size_t Alignment = 16;
+
+/* Size of given texture mip level in the data */
+std::size_t levelDataSize(const TextureRecord& record, const UnsignedInt level) {
+    const Vector2i size = Math::max(record.size >> level, Vector2i{1});
+    const std::size_t rowSize = size.x()*pixelSize(PixelFormat(record.format));
+    return (rowSize + record.alignment - 1)/record.alignment*record.alignment*size.y();
+}
+
+/* Whether a range is inside given size, written so large values from a
+   corrupted file can't wrap around */
+bool inRange(const UnsignedLong offset, const UnsignedLong size, const UnsignedLong total) {
+    return size <= total && offset <= total - size;
+}
+
+/* Size of an index type stored in the cache, zero if it's not valid */
+UnsignedInt indexTypeSize(const UnsignedInt type) {
+    switch(MeshIndexType(type)) {
+        case MeshIndexType::UnsignedByte: return 1;
+        case MeshIndexType::UnsignedShort: return 2;
+        case MeshIndexType::UnsignedInt: return 4;
+    }
+    return 0;
+}
+
+std::size_t aligned(std::size_t offset) {
+    return (offset + Alignment - 1)/Alignment*Alignment;
+}
+
+template<class T> Containers::ArrayView<const T> table(Containers::ArrayView<const char> file, UnsignedLong offset, UnsignedInt count) {
+    if(offset % alignof(T) || !inRange(offset, UnsignedLong(count)*sizeof(T), file.size()))
+        return nullptr;
+    return {reinterpret_cast<const T*>(file.data() + offset), count};
+}
+
+struct FileInfo {
+    bool exists, directory;
+    UnsignedLong size;
+    Long modificationTime;
+};
+
+FileInfo fileInfo(const std::string& filename) {
+    #ifndef CORRADE_TARGET_WINDOWS
+    struct stat s;
+    if(stat(filename.data(), &s) != 0) return {};
+    return {true, S_ISDIR(s.st_mode), UnsignedLong(s.st_size), Long(s.st_mtime)};
+    #else
+    struct _stat64 s;
+    if(_stat64(filename.data(), &s) != 0) return {};
+    return {true, (s.st_mode & _S_IFDIR) != 0, UnsignedLong(s.st_size), Long(s.st_mtime)};
+    #endif
+}
+
+template<class T> void appendTable(std::string& out, const std::vector<T>& data) {
+    out.append(aligned(out.size()) - out.size(), '\0');
+    out.append(reinterpret_cast<const char*>(data.data()), data.size()*sizeof(T));
+}
+
+}
+
+Range3D meshBounds(const Trade::MeshData3D& data) {
+    Range3D bounds{Vector3{Constants::inf()}, Vector3{-Constants::inf()}};
+    for(const Vector3& position: data.positions(0)) {
+        bounds.min() = Math::min(bounds.min(), position);
+        bounds.max() = Math::max(bounds.max(), position);
+    }
+    return bounds;
+}
+
+SourceStamp sourceStamp(const std::string& filename) {
+    const FileInfo info = fileInfo(filename);
+    if(!info.exists) return {};
+    SourceStamp out{info.size, info.modificationTime};
+
+    /* External textures are usually next to the scene or in a subdirectory,
+       take the newest of all those */
+    std::string path = Utility::Directory::path(filename);
+    if(path.empty()) path = ".";
+    std::vector<std::pair<std::string, bool>> directories{{path, true}};
+    while(!directories.empty()) {
+        const std::pair<std::string, bool> directory = directories.back();
+        directories.pop_back();
+        for(const std::string& entry: Utility::Directory::list(directory.first, Utility::Directory::Flag::SkipDotAndDotDot)) {
+            if(Utility::String::endsWith(entry, ".cache")) continue;
+
+            const std::string entryPath = Utility::Directory::join(directory.first, entry);
+            const FileInfo entryInfo = fileInfo(entryPath);
+            if(entryInfo.directory) {
+                if(directory.second) directories.emplace_back(entryPath, false);
+            } else out.modificationTime = Math::max(out.modificationTime, entryInfo.modificationTime);
+        }
+    }
+
+    return out;
+}
+
+Containers::Optional<SceneCache> SceneCache::open(const std::string& filename, const SourceStamp& source) {
+    if(!Utility::Directory::exists(filename)) return Containers::NullOpt;
+
+    SceneCache out;
+    out._file = Utility::Directory::mapRead(filename);
+    if(out._file.size() < sizeof(Header)) return Containers::NullOpt;
+
+    const auto& header = *reinterpret_cast<const Header*>(out._file.data());
+    if(std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version) {
+        Warning{} << "Scene cache" << filename << "has an unsupported format, ignoring";
+        return Containers::NullOpt;
+    }
+    if(header.sourceSize != source.size || header.sourceTime != source.modificationTime) {
+        Warning{} << "Scene cache" << filename << "is out of date, ignoring";
+        return Containers::NullOpt;
+    }
+
+    const Containers::ArrayView<const char> file = out._file;
+    out._meshes = table<MeshRecord>(file, header.meshOffset, header.meshCount);
+    out._textures = table<TextureRecord>(file, header.textureOffset, header.textureCount);
+    out._materials = table<MaterialRecord>(file, header.materialOffset, header.materialCount);
+    out._objects = table<ObjectRecord>(file, header.objectOffset, header.objectCount);
+    if(!inRange(header.dataOffset, header.dataSize, file.size()) ||
+       out._meshes.size() != header.meshCount ||
+       out._textures.size() != header.textureCount ||
+       out._materials.size() != header.materialCount ||
+       out._objects.size() != header.objectCount) {
+        Warning{} << "Scene cache" << filename << "is corrupted, ignoring";
+        return Containers::NullOpt;
+    }
+    out._data = file.slice(header.dataOffset, header.dataOffset + header.dataSize);
+
+    /* Verify that all data references are in bounds and all enum values
+       valid so we don't need to check that on every access. Meshes that
+       failed to import have everything zero. */
+    for(const MeshRecord& mesh: out._meshes) {
+        if(!mesh.vertexCount) continue;
+
+        UnsignedLong levelIndexCount = 0;
+        for(UnsignedInt level = 0; level < mesh.levelCount && level != MeshRecord::MaxLevelCount; ++level)
+            levelIndexCount += mesh.levelIndexCounts[level];
+        const UnsignedLong stride = mesh.flags & MeshRecord::TextureCoordinates ? 32 : 24;
+        const UnsignedInt indexSize = indexTypeSize(mesh.indexType);
+        if(!inRange(mesh.vertexOffset, mesh.vertexSize, out._data.size()) ||
+           mesh.vertexSize < mesh.vertexCount*stride ||
+           !inRange(mesh.indexOffset, mesh.indexSize, out._data.size()) ||
+           MeshPrimitive(mesh.primitive) != MeshPrimitive::Triangles ||
+           (mesh.indexCount && (!indexSize ||
+            mesh.indexSize != UnsignedLong(mesh.indexCount)*indexSize ||
+            mesh.indexStart > mesh.indexEnd ||
+            mesh.indexEnd >= mesh.vertexCount)) ||
+           (!mesh.indexCount && mesh.indexSize) ||
+           mesh.levelCount > MeshRecord::MaxLevelCount ||
+           levelIndexCount > mesh.indexCount) {
+            Warning{} << "Scene cache" << filename << "is corrupted, ignoring";
+            return Containers::NullOpt;
+        }
+    }
+    for(const TextureRecord& texture: out._textures) {
+        if(!texture.dataSize) continue;
+
+        /* Only formats the viewer can upload get written, and the size is
+           limited so the level sizes can't overflow */
+        const PixelFormat format = PixelFormat(texture.format);
+        if((format != PixelFormat::RGB8Unorm && format != PixelFormat::RGBA8Unorm) ||
+           (texture.alignment != 1 && texture.alignment != 2 &&
+            texture.alignment != 4 && texture.alignment != 8) ||
+           texture.size.min() < 1 || texture.size.max() > 65536 ||
+           texture.levelCount < 1 ||
+           texture.levelCount > Math::log2(UnsignedInt(texture.size.max())) + 1) {
+            Warning{} << "Scene cache" << filename << "is corrupted, ignoring";
+            return Containers::NullOpt;
+        }
+
+        UnsignedLong levelsSize = 0;
+        for(UnsignedInt level = 0; level != texture.levelCount; ++level)
+            levelsSize += levelDataSize(texture, level);
+        if(!inRange(texture.dataOffset, texture.dataSize, out._data.size()) ||
+           levelsSize != texture.dataSize) {
+            Warning{} << "Scene cache" << filename << "is corrupted, ignoring";
+            return Containers::NullOpt;
+        }
+    }
+
+    /* Same for references between the records. Objects can reference only
+       meshes that were imported, and only parents that come before them, as
+       the hierarchy is created in a single ordered pass. */
+    for(const MaterialRecord& material: out._materials) {
+        if(material.diffuseTexture < -1 ||
+           material.diffuseTexture >= Int(out._textures.size())) {
+            Warning{} << "Scene cache" << filename << "is corrupted, ignoring";
+            return Containers::NullOpt;
+        }
+    }
+    for(std::size_t i = 0; i != out._objects.size(); ++i) {
+        const ObjectRecord& object = out._objects[i];
+        if(object.parent < -1 || object.parent >= Int(i) ||
+           object.mesh < -1 || object.mesh >= Int(out._meshes.size()) ||
+           (object.mesh != -1 && !out._meshes[object.mesh].vertexCount) ||
+           object.material < -1 || object.material >= Int(out._materials.size())) {
+            Warning{} << "Scene cache" << filename << "is corrupted, ignoring";
+            return Containers::NullOpt;
+        }
+    }
+
+    return Containers::Optional<SceneCache>{std::move(out)};
+}
+
+Containers::ArrayView<const char> SceneCache::data(const UnsignedLong offset, const UnsignedLong size) const {
+    return _data.slice(offset, offset + size);
+}
+
+Containers::Optional<GL::Mesh> SceneCache::mesh(const UnsignedInt id, const bool quantized) const {
+    const MeshRecord& record = _meshes[id];
+    if(!record.vertexCount) return Containers::NullOpt;
+
+    const Containers::ArrayView<const char> vertexData = data(record.vertexOffset, record.vertexSize);
+    const bool textureCoordinates = record.flags & MeshRecord::TextureCoordinates;
+
+    GL::Mesh mesh;
+    mesh.setPrimitive(MeshPrimitive(record.primitive));
+    if(quantized) {
+        /* Pick the attributes out of the interleaved data */
+        const std::ptrdiff_t stride = textureCoordinates ? 32 : 24;
+        const Containers::StridedArrayView1D<const Vector3> positions{vertexData,
+            reinterpret_cast<const Vector3*>(vertexData.data()), record.vertexCount, stride};
+        const Containers::StridedArrayView1D<const Vector3> normals{vertexData,
+            reinterpret_cast<const Vector3*>(vertexData.data() + 12), record.vertexCount, stride};
+        Containers::StridedArrayView1D<const Vector2> textureCoordinateView;
+        if(textureCoordinates) textureCoordinateView = Containers::StridedArrayView1D<const Vector2>{vertexData,
+            reinterpret_cast<const Vector2*>(vertexData.data() + 24), record.vertexCount, stride};
+
+        const Containers::Array<QuantizedVertex> quantizedData = quantizeVertices(record.bounds, positions, normals, textureCoordinateView);
+        GL::Buffer vertices;
+        vertices.setData(quantizedData, GL::BufferUsage::StaticDraw);
+        addQuantizedVertexBuffer(mesh, std::move(vertices), textureCoordinates);
+    } else {
+        GL::Buffer vertices;
+        vertices.setData(vertexData, GL::BufferUsage::StaticDraw);
+        if(textureCoordinates)
+            mesh.addVertexBuffer(std::move(vertices), 0,
+                Shaders::Generic3D::Position{},
+                Shaders::Generic3D::Normal{},
+                Shaders::Generic3D::TextureCoordinates{});
+        else
+            mesh.addVertexBuffer(std::move(vertices), 0,
+                Shaders::Generic3D::Position{},
+                Shaders::Generic3D::Normal{});
+    }
+
+    if(record.indexCount) {
+        GL::Buffer indices;
+        indices.setData(data(record.indexOffset, record.indexSize), GL::BufferUsage::StaticDraw);
+        mesh.setCount(record.levelCount ? record.levelIndexCounts[0] : record.indexCount)
+            .setIndexBuffer(std::move(indices), 0, MeshIndexType(record.indexType), record.indexStart, record.indexEnd);
+    } else mesh.setCount(record.vertexCount);
+
+    return Containers::Optional<GL::Mesh>{std::move(mesh)};
+}
+
+Containers::Optional<GL::Mesh> SceneCache::positionMesh(const UnsignedInt id, const bool quantized) const {
+    const MeshRecord& record = _meshes[id];
+    if(!record.vertexCount) return Containers::NullOpt;
+
+    const Containers::ArrayView<const char> vertexData = data(record.vertexOffset, record.vertexSize);
+    const std::ptrdiff_t stride = record.flags & MeshRecord::TextureCoordinates ? 32 : 24;
+    const Containers::StridedArrayView1D<const Vector3> positions{vertexData,
+        reinterpret_cast<const Vector3*>(vertexData.data()), record.vertexCount, stride};
+
+    return Containers::Optional<GL::Mesh>{compilePositions(
+        MeshPrimitive(record.primitive), positions, record.bounds, quantized,
+        record.indexCount ? data(record.indexOffset, record.indexSize) : nullptr,
+        MeshIndexType(record.indexType), record.indexStart, record.indexEnd,
+        !record.indexCount ? record.vertexCount :
+            record.levelCount ? record.levelIndexCounts[0] : record.indexCount)};
+}
+
+std::vector<MeshLevel> SceneCache::levels(const UnsignedInt id) const {
+    const MeshRecord& record = _meshes[id];
+    std::vector<MeshLevel> levels;
+    UnsignedInt offset = 0;
+    for(UnsignedInt i = 0; i != record.levelCount; ++i) {
+        levels.push_back({offset, record.levelIndexCounts[i]});
+        offset += record.levelIndexCounts[i];
+    }
+    return levels;
+}
+
+Containers::ArrayView<const char> SceneCache::indexData(const UnsignedInt id) const {
+    const MeshRecord& record = _meshes[id];
+    if(!record.levelCount || !record.indexCount)
+        return data(record.indexOffset, record.indexSize);
+    return data(record.indexOffset, record.indexSize/record.indexCount*record.levelIndexCounts[0]);
+}
+
+ImageView2D SceneCache::image(const UnsignedInt id) const {
+    const TextureRecord& record = _textures[id];
+    return ImageView2D{PixelStorage{}.setAlignment(record.alignment),
+        PixelFormat(record.format), record.size,
+        data(record.dataOffset, levelDataSize(record, 0))};
+}
+
+std::vector<ImageView2D> SceneCache::imageLevels(const UnsignedInt id) const {
+    const TextureRecord& record = _textures[id];
+    std::vector<ImageView2D> levels;
+    levels.reserve(record.levelCount);
+    UnsignedLong offset = record.dataOffset;
+    for(UnsignedInt level = 0; level != record.levelCount; ++level) {
+        const std::size_t size = levelDataSize(record, level);
+        levels.emplace_back(PixelStorage{}.setAlignment(record.alignment),
+            PixelFormat(record.format), Math::max(record.size >> level, Vector2i{1}),
+            data(offset, size));
+        offset += size;
+    }
+    return levels;
+}
+
+SceneCacheWriter::SceneCacheWriter(const UnsignedInt meshCount, const UnsignedInt textureCount): _meshes(meshCount, MeshRecord{}), _textures(textureCount, TextureRecord{}) {}
+
+UnsignedLong SceneCacheWriter::appendData(const Containers::ArrayView<const char> data) {
+    _data.append(aligned(_data.size()) - _data.size(), '\0');
+    const UnsignedLong offset = _data.size();
+    _data.append(data.data(), data.size());
+    return offset;
+}
+
+void SceneCacheWriter::setMesh(const UnsignedInt id, const Trade::MeshData3D& data, const std::vector<MeshLevel>& levels) {
+    MeshRecord& record = _meshes[id];
+    record.levelCount = Math::min(UnsignedInt(levels.size()), UnsignedInt(MeshRecord::MaxLevelCount));
+    for(UnsignedInt i = 0; i != record.levelCount; ++i)
+        record.levelIndexCounts[i] = levels[i].indexCount;
+    record.primitive = UnsignedInt(data.primitive());
+    record.vertexCount = data.positions(0).size();
+    record.bounds = meshBounds(data);
+
+    /* Interleave the attributes in the same order as the cached mesh expects
+       them */
+    Containers::Array<char> vertexData;
+    if(data.hasTextureCoords2D()) {
+        record.flags |= MeshRecord::TextureCoordinates;
+        vertexData = MeshTools::interleave(data.positions(0), data.normals(0), data.textureCoords2D(0));
+    } else vertexData = MeshTools::interleave(data.positions(0), data.normals(0));
+    record.vertexOffset = appendData(vertexData);
+    record.vertexSize = vertexData.size();
+
+    if(data.isIndexed()) {
+        Containers::Array<char> indexData;
+        MeshIndexType indexType;
+        std::tie(indexData, indexType, record.indexStart, record.indexEnd) = MeshTools::compressIndices(data.indices());
+        record.indexType = UnsignedInt(indexType);
+        record.indexCount = data.indices().size();
+        record.indexOffset = appendData(indexData);
+        record.indexSize = indexData.size();
+    }
+}
+
+void SceneCacheWriter::setTexture(const UnsignedInt id, const Trade::TextureData& texture, const std::vector<ImageView2D>& levels) {
+    TextureRecord& record = _textures[id];
+    record.size = levels[0].size();
+    record.format = UnsignedInt(levels[0].format());
+    record.alignment = levels[0].storage().alignment();
+    record.levelCount = levels.size();
+    record.magnificationFilter = UnsignedInt(texture.magnificationFilter());
+    record.minificationFilter = UnsignedInt(texture.minificationFilter());
+    record.mipmapFilter = UnsignedInt(texture.mipmapFilter());
+    record.wrapping[0] = UnsignedInt(texture.wrapping().x());
+    record.wrapping[1] = UnsignedInt(texture.wrapping().y());
+
+    /* The levels are stored right after each other, without the alignment
+       padding appendData() would add */
+    record.dataOffset = appendData(levels[0].data());
+    for(std::size_t i = 1; i != levels.size(); ++i)
+        _data.append(levels[i].data(), levels[i].data().size());
+    record.dataSize = _data.size() - record.dataOffset;
+}
+
+bool SceneCacheWriter::write(const std::string& filename, const SourceStamp& source) const {
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.sourceSize = source.size;
+    header.sourceTime = source.modificationTime;
+    header.meshCount = _meshes.size();
+    header.textureCount = _textures.size();
+    header.materialCount = _materials.size();
+    header.objectCount = _objects.size();
+
+    std::string out(sizeof(Header), '\0');
+    header.meshOffset = aligned(out.size());
+    appendTable(out, _meshes);
+    header.textureOffset = aligned(out.size());
+    appendTable(out, _textures);
+    header.materialOffset = aligned(out.size());
+    appendTable(out, _materials);
+    header.objectOffset = aligned(out.size());
+    appendTable(out, _objects);
+    out.append(aligned(out.size()) - out.size(), '\0');
+    header.dataOffset = out.size();
+    header.dataSize = _data.size();
+    std::memcpy(&out[0], &header, sizeof(Header));
+
+    /* Write the header and tables first and append the (potentially huge)
+       data section after, to avoid copying it */
+    return Utility::Directory::write(filename, Containers::arrayView(out.data(), out.size())) &&
+        Utility::Directory::append(filename, Containers::arrayView(_data.data(), _data.size()));
+}
+
+}}
@@ -0,0 +1,290 @@
+#ifndef Magnum_Examples_SceneCache_h
+#define Magnum_Examples_SceneCache_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <string>
+#include <vector>
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Utility/Directory.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/GL/GL.h>
+#include <Magnum/Trade/Trade.h>
+
+#include "MeshLod.h"
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Flattened scene object
+
+Objects are stored in an array ordered so that parents always come before
+their children, which makes it possible to create the whole hierarchy in a
+single pass without recursion.
+*/
+struct ObjectRecord {
+    Matrix4 transformation;
+    Int parent;     /**< Parent object or @cpp -1 @ce for a root object */
+    Int mesh;       /**< Mesh ID or @cpp -1 @ce */
+    Int material;   /**< Material ID or @cpp -1 @ce for a default material */
+    Int:32;
+};
+
+/** @brief The subset of Phong material properties the viewer uses */
+struct MaterialRecord {
+    Color4 diffuseColor;
+    Int diffuseTexture; /**< Texture ID or @cpp -1 @ce if not textured */
+    Int:32;
+    Int:32;
+    Int:32;
+};
+
+struct MeshRecord {
+    enum: UnsignedInt {
+        TextureCoordinates = 1 << 0
+    };
+
+    enum: UnsignedInt {
+        MaxLevelCount = 4
+    };
+
+    UnsignedLong vertexOffset, vertexSize;
+    UnsignedLong indexOffset, indexSize;
+    UnsignedInt vertexCount, indexCount;
+    UnsignedInt primitive, indexType;
+    UnsignedInt indexStart, indexEnd;
+    UnsignedInt flags;
+    Range3D bounds;     /**< Bounding box of vertex positions */
+
+    /**
+     * Index counts of levels of detail, stored one after another in the
+     * index data. Zero if the mesh has no levels.
+     */
+    UnsignedInt levelCount;
+    UnsignedInt levelIndexCounts[MaxLevelCount];
+};
+
+struct TextureRecord {
+    UnsignedLong dataOffset, dataSize;
+    Vector2i size;
+    UnsignedInt format;
+    Int alignment;
+    UnsignedInt magnificationFilter, minificationFilter, mipmapFilter;
+    UnsignedInt wrapping[2];
+
+    /**
+     * Count of mip levels, stored one after another in the data with the
+     * same alignment. The first level has @ref size, each next level half of
+     * the previous one.
+     */
+    UnsignedInt levelCount;
+};
+
+/** @brief Bounding box of all vertex positions in a mesh */
+Range3D meshBounds(const Trade::MeshData3D& data);
+
+/**
+@brief Stamp of the files a scene cache was created from
+
+The cache contains also decoded images of external textures, so besides size
+of the scene file, the modification time is the newest of the scene file and
+all files in its directory and immediate subdirectories. Files with a
+`.cache` extension are skipped, as that's where the cache itself is written.
+*/
+struct SourceStamp {
+    UnsignedLong size;
+    Long modificationTime;
+};
+
+/** @brief Stamp of a scene file, zero-filled if the file doesn't exist */
+SourceStamp sourceStamp(const std::string& filename);
+
+/**
+@brief Memory-mapped binary scene cache
+
+A flat file containing everything the viewer needs to display a scene ---
+pre-interleaved vertex data, compressed indices, decoded texels, materials
+and the object hierarchy. The file is memory-mapped and the GPU resources
+are uploaded straight from the mapping, without any importer involved.
+
+The file starts with a header, followed by mesh, texture, material and object
+tables and then a data section with the actual vertex, index and pixel data.
+All offsets in the records are relative to the data section. The format is
+native-endian and meant only as a local cache, not for distribution.
+*/
+class SceneCache {
+    public:
+        /**
+         * @brief Open a cache file
+         *
+         * Returns @ref Containers::NullOpt if the file doesn't exist, is
+         * corrupted or was created from source files with a different
+         * stamp than @p source. Besides data ranges, sizes of vertex, index
+         * and image data are checked against the counts, formats and
+         * layouts they're described with, enum values to be valid, all
+         * record references to be in bounds and parents to be before their
+         * children, so a file that passes can be used without further
+         * checks.
+         */
+        static Containers::Optional<SceneCache> open(const std::string& filename, const SourceStamp& source);
+
+        Containers::ArrayView<const MeshRecord> meshes() const { return _meshes; }
+        Containers::ArrayView<const TextureRecord> textures() const { return _textures; }
+        Containers::ArrayView<const MaterialRecord> materials() const { return _materials; }
+        Containers::ArrayView<const ObjectRecord> objects() const { return _objects; }
+
+        /**
+         * @brief Create a mesh
+         *
+         * Returns @ref Containers::NullOpt if the mesh failed to import when
+         * the cache was created. The mesh is configured for the
+         * @ref Shaders::Generic attribute locations. If the mesh has levels
+         * of detail, the index buffer contains all of them and the mesh
+         * count is set to the first one. If @p quantized is set, the vertex
+         * data are converted to the @ref QuantizedVertex layout relative to
+         * @ref MeshRecord::bounds on upload.
+         */
+        Containers::Optional<GL::Mesh> mesh(UnsignedInt id, bool quantized = false) const;
+
+        /**
+         * @brief Create a position-only mesh
+         *
+         * Returns @ref Containers::NullOpt if the mesh failed to import when
+         * the cache was created. Contains all levels of detail and positions
+         * quantized if @p quantized is set, matching @ref mesh() exactly.
+         */
+        Containers::Optional<GL::Mesh> positionMesh(UnsignedInt id, bool quantized = false) const;
+
+        /** @brief Levels of detail of a mesh, empty if it has none */
+        std::vector<MeshLevel> levels(UnsignedInt id) const;
+
+        /**
+         * @brief Interleaved vertex data of a mesh
+         *
+         * Positions and normals, followed by texture coordinates if
+         * @ref MeshRecord::TextureCoordinates is set. Points directly into
+         * the mapped file.
+         */
+        Containers::ArrayView<const char> vertexData(UnsignedInt id) const {
+            return data(_meshes[id].vertexOffset, _meshes[id].vertexSize);
+        }
+
+        /**
+         * @brief Compressed index data of a mesh
+         *
+         * Only the full-detail level if the mesh has levels of detail. Empty
+         * if the mesh is not indexed. Points directly into the mapped file.
+         */
+        Containers::ArrayView<const char> indexData(UnsignedInt id) const;
+
+        /**
+         * @brief Image data of a texture
+         *
+         * Points directly into the mapped file. Check
+         * @ref TextureRecord::dataSize for zero first to see if the texture
+         * was available. Only the first level if the texture has more.
+         */
+        ImageView2D image(UnsignedInt id) const;
+
+        /**
+         * @brief Image data of all texture mip levels
+         *
+         * Points directly into the mapped file, so uploading just some of the
+         * levels touches only the pages containing them.
+         */
+        std::vector<ImageView2D> imageLevels(UnsignedInt id) const;
+
+    private:
+        explicit SceneCache() = default;
+
+        Containers::ArrayView<const char> data(UnsignedLong offset, UnsignedLong size) const;
+
+        Containers::Array<const char, Utility::Directory::MapDeleter> _file;
+        Containers::ArrayView<const char> _data;
+        Containers::ArrayView<const MeshRecord> _meshes;
+        Containers::ArrayView<const TextureRecord> _textures;
+        Containers::ArrayView<const MaterialRecord> _materials;
+        Containers::ArrayView<const ObjectRecord> _objects;
+};
+
+/**
+@brief Scene cache writer
+
+Collects the imported data and writes them to a file that can be opened later
+with @ref SceneCache::open(). Meshes and textures that fail to import are
+simply not set and get recorded as empty.
+*/
+class SceneCacheWriter {
+    public:
+        explicit SceneCacheWriter(UnsignedInt meshCount, UnsignedInt textureCount);
+
+        /**
+         * @brief Interleave and compress the mesh data and add them
+         *
+         * If @p levels are not empty, the mesh indices are expected to
+         * contain all of them, as produced by @ref generateLods().
+         */
+        void setMesh(UnsignedInt id, const Trade::MeshData3D& data, const std::vector<MeshLevel>& levels = {});
+
+        /**
+         * @brief Add decoded texture mip levels along with the sampler state
+         *
+         * The @p levels are expected to go from the finest one, all with the
+         * same alignment, as produced by @ref generateMipChain().
+         */
+        void setTexture(UnsignedInt id, const Trade::TextureData& texture, const std::vector<ImageView2D>& levels);
+
+        void setMaterials(std::vector<MaterialRecord> materials) {
+            _materials = std::move(materials);
+        }
+
+        void setObjects(std::vector<ObjectRecord> objects) {
+            _objects = std::move(objects);
+        }
+
+        /** @brief Write the cache, returns @cpp false @ce on failure */
+        bool write(const std::string& filename, const SourceStamp& source) const;
+
+    private:
+        UnsignedLong appendData(Containers::ArrayView<const char> data);
+
+        std::vector<MeshRecord> _meshes;
+        std::vector<TextureRecord> _textures;
+        std::vector<MaterialRecord> _materials;
+        std::vector<ObjectRecord> _objects;
+        std::string _data;
+};
+
+}}
+
+#endif
@@ -0,0 +1,128 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "SceneShader.h"
+
+#include <Corrade/Containers/Reference.h>
+#include <Corrade/Utility/Resource.h>
+#include <Magnum/GL/Context.h>
+#include <Magnum/GL/Shader.h>
+#include <Magnum/GL/Texture.h>
+#include <Magnum/GL/Version.h>
+#include <Magnum/Math/Matrix4.h>
+
+#include "FrameUniforms.h"
+
+namespace Magnum { namespace Examples {
+
+SceneShader::SceneShader(const Flag flags): _flags{flags} {
+    #ifndef MAGNUM_TARGET_GLES
+    const GL::Version version = GL::Version::GL330;
+    #else
+    const GL::Version version = GL::Version::GLES300;
+    #endif
+    MAGNUM_ASSERT_GL_VERSION_SUPPORTED(version);
+
+    const Utility::Resource rs{"viewer-data"};
+
+    GL::Shader vert{version, GL::Shader::Type::Vertex};
+    GL::Shader frag{version, GL::Shader::Type::Fragment};
+
+    /* The fragment shader is the same as for instanced drawing, so both
+       look the same */
+    const std::string preamble =
+        flags == Flag::Textured ? "#define TEXTURED\n" :
+        flags == Flag::DepthOnly ? "#define DEPTH_ONLY\n" : "";
+    vert.addSource(preamble);
+    vert.addSource(rs.get("FrameUniforms.glsl"));
+    vert.addSource(rs.get("SceneShader.vert"));
+    frag.addSource(preamble);
+    frag.addSource(rs.get("InstancedShader.frag"));
+
+    CORRADE_INTERNAL_ASSERT_OUTPUT(GL::Shader::compile({vert, frag}));
+
+    bindAttributeLocation(Position::Location, "position");
+    if(flags == Flag::Textured) {
+        bindAttributeLocation(Normal::Location, "normal");
+        bindAttributeLocation(TextureCoordinates::Location, "textureCoordinates");
+    }
+
+    attachShaders({vert, frag});
+
+    CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+
+    setUniformBlockBinding(uniformBlockIndex("Frame"), FrameUniforms::Binding);
+    _transformationMatrixUniform = uniformLocation("transformationMatrix");
+    if(flags == Flag::Textured) {
+        _normalMatrixUniform = uniformLocation("normalMatrix");
+        _ambientColorUniform = uniformLocation("ambientColor");
+        _specularColorUniform = uniformLocation("specularColor");
+        _shininessUniform = uniformLocation("shininess");
+        setUniform(uniformLocation("diffuseTexture"), DiffuseTextureLayer);
+    } else if(flags != Flag::DepthOnly) {
+        _colorUniform = uniformLocation("color");
+    }
+}
+
+SceneShader& SceneShader::setTransformationMatrix(const Matrix4& matrix) {
+    setUniform(_transformationMatrixUniform, matrix);
+    return *this;
+}
+
+SceneShader& SceneShader::setNormalMatrix(const Matrix3x3& matrix) {
+    setUniform(_normalMatrixUniform, matrix);
+    return *this;
+}
+
+SceneShader& SceneShader::setAmbientColor(const Color4& color) {
+    setUniform(_ambientColorUniform, color);
+    return *this;
+}
+
+SceneShader& SceneShader::setSpecularColor(const Color4& color) {
+    setUniform(_specularColorUniform, color);
+    return *this;
+}
+
+SceneShader& SceneShader::setShininess(const Float shininess) {
+    setUniform(_shininessUniform, shininess);
+    return *this;
+}
+
+SceneShader& SceneShader::bindDiffuseTexture(GL::Texture2D& texture) {
+    texture.bind(DiffuseTextureLayer);
+    return *this;
+}
+
+SceneShader& SceneShader::setColor(const Color4& color) {
+    setUniform(_colorUniform, color);
+    return *this;
+}
+
+}}
@@ -0,0 +1,117 @@
+#ifndef Magnum_Examples_SceneShader_h
+#define Magnum_Examples_SceneShader_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Shaders/Generic.h>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Shader drawing a single object with per-frame data from a uniform block
+
+Counterpart to @ref InstancedShader for objects drawn one by one. Projection
+matrix and light position come from the @ref FrameUniforms buffer, so only
+the transformation and normal matrix and the color need to be set for each
+draw. The colored variant is equivalent to @ref Shaders::Flat3D, the textured
+variant to a single-light @ref Shaders::Phong with a diffuse texture.
+
+The position is declared @glsl invariant @ce in all variants, so the
+depth-only variant used for a depth pre-pass produces exactly the same depth
+as the shading pass after.
+*/
+class SceneShader: public GL::AbstractShaderProgram {
+    public:
+        typedef Shaders::Generic3D::Position Position;
+        typedef Shaders::Generic3D::Normal Normal;
+        typedef Shaders::Generic3D::TextureCoordinates TextureCoordinates;
+
+        /** @brief Shader variant */
+        enum class Flag: UnsignedByte {
+            /** Textured with a diffuse texture */
+            Textured = 1 << 0,
+
+            /**
+             * Depth only, for a depth pre-pass. Needs just the position
+             * attribute and the transformation matrix, no color is written.
+             */
+            DepthOnly = 1 << 1
+        };
+
+        explicit SceneShader(NoCreateT): GL::AbstractShaderProgram{NoCreate} {}
+
+        explicit SceneShader(Flag flags = {});
+
+        Flag flags() const { return _flags; }
+
+        /** @brief Set camera-relative transformation matrix */
+        SceneShader& setTransformationMatrix(const Matrix4& matrix);
+
+        /**
+         * @brief Set normal matrix
+         *
+         * Used only if @ref Flag::Textured is set, same for the functions
+         * below.
+         */
+        SceneShader& setNormalMatrix(const Matrix3x3& matrix);
+
+        SceneShader& setAmbientColor(const Color4& color);
+
+        SceneShader& setSpecularColor(const Color4& color);
+
+        SceneShader& setShininess(Float shininess);
+
+        SceneShader& bindDiffuseTexture(GL::Texture2D& texture);
+
+        /**
+         * @brief Set color
+         *
+         * Used only if neither @ref Flag::Textured nor @ref Flag::DepthOnly
+         * is set.
+         */
+        SceneShader& setColor(const Color4& color);
+
+    private:
+        enum: Int { DiffuseTextureLayer = 0 };
+
+        Flag _flags;
+        Int _transformationMatrixUniform,
+            _normalMatrixUniform{-1},
+            _colorUniform{-1},
+            _ambientColorUniform{-1},
+            _specularColorUniform{-1},
+            _shininessUniform{-1};
+};
+
+}}
+
+#endif
@@ -0,0 +1,93 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "TextureArrays.h"
+
+#include <algorithm>
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/Math/Functions.h>
+
+namespace Magnum { namespace Examples {
+
+TextureArrays::TextureArrays(const UnsignedInt textureCount): _locations(textureCount, Location{-1, 0}) {}
+
+void TextureArrays::add(const UnsignedInt id, const SamplerFilter magnificationFilter, const SamplerFilter minificationFilter, const SamplerMipmap mipmapFilter, const Array2D<SamplerWrapping>& wrapping, const GL::TextureFormat format, const ImageView2D& image) {
+    Containers::Array<char> data{Containers::NoInit, image.data().size()};
+    std::copy(image.data().begin(), image.data().end(), data.begin());
+    _pending[Key{image.size().x(), image.size().y(), format, magnificationFilter, minificationFilter, mipmapFilter, wrapping.x(), wrapping.y()}]
+        .emplace_back(id, Image2D{image.storage(), image.format(), image.size(), std::move(data)});
+}
+
+void TextureArrays::upload() {
+    /* Count the arrays first so the vector doesn't reallocate and the
+       pointers given out by array() stay valid */
+    const UnsignedInt maxLayerCount = GL::Texture2DArray::maxSize().z();
+    std::size_t arrayCount = 0;
+    for(const auto& group: _pending)
+        arrayCount += (group.second.size() + maxLayerCount - 1)/maxLayerCount;
+    _arrays.reserve(_arrays.size() + arrayCount);
+
+    std::size_t textureCount = 0;
+    for(auto& group: _pending) {
+        const Vector2i size{std::get<0>(group.first), std::get<1>(group.first)};
+        std::vector<std::pair<UnsignedInt, Image2D>>& images = group.second;
+
+        for(std::size_t begin = 0; begin < images.size(); begin += maxLayerCount) {
+            const std::size_t end = Math::min(begin + maxLayerCount, images.size());
+            const Int array = _arrays.size();
+
+            _arrays.emplace_back();
+            GL::Texture2DArray& texture = _arrays.back();
+            texture
+                .setMagnificationFilter(std::get<3>(group.first))
+                .setMinificationFilter(std::get<4>(group.first), std::get<5>(group.first))
+                .setWrapping({std::get<6>(group.first), std::get<7>(group.first)})
+                .setStorage(Math::log2(size.max()) + 1, std::get<2>(group.first), {size, Int(end - begin)});
+
+            for(std::size_t i = begin; i != end; ++i) {
+                const Image2D& image = images[i].second;
+                texture.setSubImage(0, {0, 0, Int(i - begin)}, ImageView3D{image.storage(), image.format(), {size, 1}, image.data()});
+                _locations[images[i].first] = Location{array, UnsignedInt(i - begin)};
+            }
+
+            texture.generateMipmap();
+        }
+
+        textureCount += images.size();
+    }
+
+    Debug{} << "Packed" << textureCount << "textures into" << _arrays.size()
+        << "texture arrays";
+
+    _pending = {};
+}
+
+}}
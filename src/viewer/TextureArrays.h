@@ -0,0 +1,116 @@
+#ifndef Magnum_Examples_TextureArrays_h
+#define Magnum_Examples_TextureArrays_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <map>
+#include <tuple>
+#include <vector>
+#include <Magnum/Array.h>
+#include <Magnum/Image.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/Sampler.h>
+#include <Magnum/GL/GL.h>
+#include <Magnum/GL/TextureArray.h>
+#include <Magnum/GL/TextureFormat.h>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Textures packed into layers of texture arrays
+
+Textures with the same size, format and sampler state are put into layers of
+a single @ref GL::Texture2DArray. Batched drawables then carry just the layer
+index along with their transformation, so objects with different textures
+can be drawn in one instanced or multi-draw call without rebinding anything
+in between.
+
+Since the array storage is immutable and its layer count has to be known
+upfront, the images are first collected with @ref add() and uploaded all at
+once in @ref upload().
+*/
+class TextureArrays {
+    public:
+        /**
+         * @brief Constructor
+         * @param textureCount  Count of texture IDs
+         */
+        explicit TextureArrays(UnsignedInt textureCount);
+
+        /**
+         * @brief Add a texture
+         *
+         * Makes a copy of the image data, which is released in
+         * @ref upload().
+         */
+        void add(UnsignedInt id, SamplerFilter magnificationFilter, SamplerFilter minificationFilter, SamplerMipmap mipmapFilter, const Array2D<SamplerWrapping>& wrapping, GL::TextureFormat format, const ImageView2D& image);
+
+        /**
+         * @brief Create and upload all texture arrays
+         *
+         * Groups with more textures than the implementation-defined layer
+         * count limit get split into multiple arrays. Mip levels are
+         * generated on the GPU.
+         */
+        void upload();
+
+        /**
+         * @brief Texture array containing given texture
+         *
+         * Returns @cpp nullptr @ce if the texture wasn't added. Valid only
+         * after @ref upload().
+         */
+        GL::Texture2DArray* array(UnsignedInt id) {
+            return _locations[id].array == -1 ? nullptr : &_arrays[_locations[id].array];
+        }
+
+        /** @brief Layer containing given texture */
+        UnsignedInt layer(UnsignedInt id) const { return _locations[id].layer; }
+
+        /** @brief Count of texture arrays created in @ref upload() */
+        std::size_t arrayCount() const { return _arrays.size(); }
+
+    private:
+        /* Textures can share an array only if all of these match. The size
+           is split into components as vectors aren't ordered. */
+        typedef std::tuple<Int, Int, GL::TextureFormat, SamplerFilter, SamplerFilter, SamplerMipmap, SamplerWrapping, SamplerWrapping> Key;
+
+        struct Location {
+            Int array;
+            UnsignedInt layer;
+        };
+
+        std::vector<Location> _locations;
+        std::map<Key, std::vector<std::pair<UnsignedInt, Image2D>>> _pending;
+        std::vector<GL::Texture2DArray> _arrays;
+};
+
+}}
+
+#endif
@@ -0,0 +1,113 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "TextureDecoder.h"
+
+#include <algorithm>
+#include <functional>
+#include <Corrade/PluginManager/Manager.h>
+#include <Magnum/Trade/AbstractImporter.h>
+
+namespace Magnum { namespace Examples {
+
+TextureDecoder::TextureDecoder(const std::string& plugin, const std::string& filename, Trade::AbstractImporter& importer, std::vector<Job> jobs, const std::size_t threadCount): _importer(importer), _filename{filename}, _jobs{std::move(jobs)} {
+    /* No point in having more threads than there are images */
+    const std::size_t count = std::min(threadCount, _jobs.size());
+
+    /* Every worker gets its own manager, as the importer loads further
+       plugins through it while opening the file and decoding the images */
+    _workers.reserve(count);
+    for(std::size_t i = 0; i != count; ++i) {
+        Worker worker;
+        worker.manager.reset(new PluginManager::Manager<Trade::AbstractImporter>);
+        worker.importer = worker.manager->loadAndInstantiate(plugin);
+        if(!worker.importer) break;
+        _workers.push_back(std::move(worker));
+    }
+
+    _threads.reserve(_workers.size());
+    for(Worker& worker: _workers)
+        _threads.emplace_back(&TextureDecoder::work, this, std::ref(*worker.importer));
+}
+
+TextureDecoder::~TextureDecoder() {
+    /* Make the workers skip whatever is left if we bail out early */
+    _nextJob = _jobs.size();
+    for(std::thread& thread: _threads) thread.join();
+}
+
+TextureDecoder::Result TextureDecoder::decode(Trade::AbstractImporter& importer, const Job& job) {
+    const auto start = std::chrono::steady_clock::now();
+    Containers::Optional<Trade::ImageData2D> image = importer.image2D(job.image);
+    _decodeTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return Result{job.texture, std::move(image)};
+}
+
+void TextureDecoder::work(Trade::AbstractImporter& importer) {
+    /* If the file can't be opened, still consume the jobs so the GL thread
+       isn't left waiting for them */
+    const bool opened = importer.openFile(_filename);
+
+    for(;;) {
+        const std::size_t id = _nextJob++;
+        if(id >= _jobs.size()) break;
+
+        Result result = opened ? decode(importer, _jobs[id]) :
+            Result{_jobs[id].texture, Containers::NullOpt};
+
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _done.push_back(std::move(result));
+        }
+        _condition.notify_one();
+    }
+
+    importer.close();
+}
+
+bool TextureDecoder::next(UnsignedInt& texture, Containers::Optional<Trade::ImageData2D>& image) {
+    if(_consumed == _jobs.size()) return false;
+
+    Result result;
+    if(_threads.empty()) {
+        result = decode(_importer, _jobs[_consumed]);
+    } else {
+        std::unique_lock<std::mutex> lock{_mutex};
+        _condition.wait(lock, [this]{ return !_done.empty(); });
+        result = std::move(_done.front());
+        _done.pop_front();
+    }
+
+    ++_consumed;
+    texture = result.texture;
+    image = std::move(result.image);
+    return true;
+}
+
+}}
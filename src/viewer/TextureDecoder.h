@@ -0,0 +1,146 @@
+#ifndef Magnum_Examples_TextureDecoder_h
+#define Magnum_Examples_TextureDecoder_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Containers/Pointer.h>
+#include <Corrade/PluginManager/PluginManager.h>
+#include <Magnum/Trade/ImageData.h>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Decodes texture images on a pool of worker threads
+
+Neither importer instances nor the plugin manager are thread-safe, and opening
+a file or decoding an image may load further plugins --- a scene importer loads
+the concrete importer for given file format and that uses
+@ref Trade::AnyImageImporter "AnyImageImporter" for each image. Because of that,
+every worker gets its own plugin manager together with its own instance of the
+same plugin, opens the file on its own and then picks images to decode from a
+shared job list. The file is thus parsed once per worker, not once per image.
+Decoded images are handed back through a queue, which the GL thread drains with
+@ref next() and uploads them as they arrive, in whatever order they finish.
+
+With zero threads the images are decoded lazily on the calling thread inside
+@ref next() using the importer passed to the constructor, which gives the same
+behavior as a plain serial loop.
+*/
+class TextureDecoder {
+    public:
+        struct Job {
+            UnsignedInt texture;
+            UnsignedInt image;
+        };
+
+        /**
+         * @brief Constructor
+         * @param plugin        Importer plugin name
+         * @param filename      File to open in each worker
+         * @param importer      Already opened importer used when
+         *      @p threadCount is zero
+         * @param jobs          Images to decode
+         * @param threadCount   Worker thread count
+         *
+         * Worker plugin managers and importers are created here, on the
+         * calling thread. After that, each is used only by the worker it
+         * belongs to.
+         */
+        explicit TextureDecoder(const std::string& plugin, const std::string& filename, Trade::AbstractImporter& importer, std::vector<Job> jobs, std::size_t threadCount);
+
+        /** @brief Joins all worker threads */
+        ~TextureDecoder();
+
+        /**
+         * @brief Next decoded image
+         *
+         * Blocks until some worker finishes an image. Returns @cpp false @ce
+         * once all jobs were consumed, otherwise fills @p texture with the
+         * texture ID the image belongs to and @p image with the decoded
+         * image or @ref Containers::NullOpt if decoding failed.
+         */
+        bool next(UnsignedInt& texture, Containers::Optional<Trade::ImageData2D>& image);
+
+        /** @brief Worker thread count */
+        std::size_t threadCount() const { return _threads.size(); }
+
+        /**
+         * @brief Time spent decoding
+         *
+         * Sum of time spent in @ref Trade::AbstractImporter::image2D() across
+         * all workers, not including opening the file. Compare with wall-clock
+         * time to see how well the decoding got parallelized.
+         */
+        std::chrono::nanoseconds decodeTime() const {
+            return std::chrono::nanoseconds{_decodeTime.load()};
+        }
+
+    private:
+        /* The manager has to outlive the importer instantiated from it */
+        struct Worker {
+            Containers::Pointer<PluginManager::Manager<Trade::AbstractImporter>> manager;
+            Containers::Pointer<Trade::AbstractImporter> importer;
+        };
+
+        struct Result {
+            UnsignedInt texture;
+            Containers::Optional<Trade::ImageData2D> image;
+        };
+
+        void work(Trade::AbstractImporter& importer);
+        Result decode(Trade::AbstractImporter& importer, const Job& job);
+
+        Trade::AbstractImporter& _importer;
+        std::string _filename;
+        std::vector<Job> _jobs;
+        std::vector<Worker> _workers;
+        std::vector<std::thread> _threads;
+
+        std::atomic<std::size_t> _nextJob{0};
+        std::atomic<std::int_least64_t> _decodeTime{0};
+        std::size_t _consumed{0};
+
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        std::deque<Result> _done;
+};
+
+}}
+
+#endif
@@ -0,0 +1,244 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/GL/Framebuffer.h>
+#include <Magnum/GL/Texture.h>
+#include <Magnum/Math/Functions.h>
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+/* Levels up to this size are uploaded right away and never evicted */
+constexpr Int CoarseLevelSize = 64;
+
+/* Upload at most this much per frame to avoid stalls, unless a single level
+   is larger */
+constexpr UnsignedLong MaxUploadSize = 8*1024*1024;
+
+}
+
+MipChain generateMipChain(const ImageView2D& image) {
+    MipChain out;
+    if(image.format() != PixelFormat::RGB8Unorm && image.format() != PixelFormat::RGBA8Unorm)
+        return out;
+
+    /* Calculate sizes of all levels to allocate them at once */
+    const std::size_t pixelSize = image.pixelSize();
+    std::vector<Vector2i> sizes;
+    std::size_t dataSize = 0;
+    for(Vector2i size = image.size();; size = Math::max(size/2, Vector2i{1})) {
+        sizes.push_back(size);
+        dataSize += size.product()*pixelSize;
+        if(size == Vector2i{1}) break;
+    }
+    out.data = Containers::Array<char>{Containers::NoInit, dataSize};
+
+    /* Copy the first level row by row to get rid of the row padding */
+    const std::size_t rowSize = image.size().x()*pixelSize;
+    const std::size_t alignment = image.storage().alignment();
+    const std::size_t sourceStride = (rowSize + alignment - 1)/alignment*alignment;
+    for(Int y = 0; y != image.size().y(); ++y)
+        std::copy_n(image.data() + y*sourceStride, rowSize, out.data + y*rowSize);
+
+    /* Downsample each level from the previous one. For odd sizes the last
+       row or column gets repeated. */
+    std::size_t offset = 0;
+    for(std::size_t level = 1; level != sizes.size(); ++level) {
+        const Vector2i prevSize = sizes[level - 1];
+        const Vector2i size = sizes[level];
+        const char* prev = out.data + offset;
+        offset += prevSize.product()*pixelSize;
+        char* current = out.data + offset;
+
+        for(Int y = 0; y != size.y(); ++y) {
+            const Int y0 = Math::min(2*y, prevSize.y() - 1);
+            const Int y1 = Math::min(2*y + 1, prevSize.y() - 1);
+            for(Int x = 0; x != size.x(); ++x) {
+                const Int x0 = Math::min(2*x, prevSize.x() - 1);
+                const Int x1 = Math::min(2*x + 1, prevSize.x() - 1);
+                for(std::size_t c = 0; c != pixelSize; ++c) {
+                    auto texel = [&](Int px, Int py) {
+                        return UnsignedInt(UnsignedByte(prev[(py*prevSize.x() + px)*pixelSize + c]));
+                    };
+                    current[(y*size.x() + x)*pixelSize + c] = char((texel(x0, y0) + texel(x1, y0) + texel(x0, y1) + texel(x1, y1) + 2)/4);
+                }
+            }
+        }
+    }
+
+    offset = 0;
+    for(const Vector2i& size: sizes) {
+        const std::size_t levelSize = size.product()*pixelSize;
+        out.levels.emplace_back(PixelStorage{}.setAlignment(1), image.format(), size, out.data.slice(offset, offset + levelSize));
+        offset += levelSize;
+    }
+
+    return out;
+}
+
+TextureStreamer::TextureStreamer(const UnsignedInt textureCount, const UnsignedLong budget): _budget{budget}, _frame{1}, _entries(textureCount) {}
+
+void TextureStreamer::setTexture(const UnsignedInt id, GL::Texture2D& texture, const SamplerFilter magnificationFilter, const SamplerFilter minificationFilter, const SamplerMipmap mipmapFilter, const Array2D<SamplerWrapping>& wrapping, const GL::TextureFormat format, std::vector<ImageView2D> levels, Containers::Array<char> data) {
+    Entry& entry = _entries[id];
+    entry.texture = &texture;
+    entry.magnificationFilter = magnificationFilter;
+    entry.minificationFilter = minificationFilter;
+    entry.mipmapFilter = mipmapFilter;
+    entry.wrapping = wrapping;
+    entry.format = format;
+    entry.levels = std::move(levels);
+    entry.data = std::move(data);
+
+    /* Nothing is resident yet, upload the coarse levels */
+    entry.coarse = 0;
+    while(entry.coarse + 1 < entry.levels.size() && entry.levels[entry.coarse].size().max() > CoarseLevelSize)
+        ++entry.coarse;
+    entry.resident = entry.requested = entry.levels.size();
+    entry.lastUsed = 0;
+    setResident(entry, entry.coarse);
+}
+
+UnsignedLong TextureStreamer::levelSize(const Entry& entry, const UnsignedInt level) const {
+    return entry.levels[level].pixelSize()*entry.levels[level].size().product();
+}
+
+void TextureStreamer::setResident(Entry& entry, const UnsignedInt level) {
+    for(UnsignedInt i = entry.resident; i < level; ++i)
+        _residentSize -= levelSize(entry, i);
+    for(UnsignedInt i = level; i < entry.resident; ++i)
+        _residentSize += levelSize(entry, i);
+    const UnsignedInt previous = entry.resident;
+    entry.resident = level;
+
+    /* The storage is immutable, so create a new texture with just the
+       resident levels and replace the old one */
+    GL::Texture2D texture;
+    texture
+        .setMagnificationFilter(entry.magnificationFilter)
+        .setMinificationFilter(entry.minificationFilter, entry.mipmapFilter)
+        .setWrapping(entry.wrapping)
+        .setStorage(entry.levels.size() - level, entry.format, entry.levels[level].size());
+
+    /* Levels that were resident already are copied over on the GPU, only the
+       newly resident ones get uploaded */
+    GL::Framebuffer read{NoCreate}, draw{NoCreate};
+    for(UnsignedInt i = level; i != entry.levels.size(); ++i) {
+        if(i < previous) {
+            texture.setSubImage(i - level, {}, entry.levels[i]);
+            continue;
+        }
+
+        const Range2Di rectangle{{}, entry.levels[i].size()};
+        if(!read.id()) {
+            read = GL::Framebuffer{rectangle};
+            draw = GL::Framebuffer{rectangle};
+        }
+        read.attachTexture(GL::Framebuffer::ColorAttachment{0}, *entry.texture, i - previous);
+        draw.attachTexture(GL::Framebuffer::ColorAttachment{0}, texture, i - level);
+        GL::AbstractFramebuffer::blit(read, draw, rectangle, GL::FramebufferBlit::Color);
+    }
+
+    *entry.texture = std::move(texture);
+}
+
+void TextureStreamer::request(const UnsignedInt id, const Float projectedSize) {
+    Entry& entry = _entries[id];
+    if(!entry.texture) return;
+
+    /* The level that has about one texel per pixel. Coarser levels are always
+       resident, so no need to go further. */
+    const Float ratio = Float(entry.levels[0].size().max())/projectedSize;
+    const UnsignedInt level = ratio <= 1.0f ? 0 :
+        ratio >= Float(1 << entry.coarse) ? entry.coarse :
+        UnsignedInt(std::log2(ratio));
+    entry.requested = Math::min(entry.requested, level);
+    entry.lastUsed = _frame;
+}
+
+bool TextureStreamer::makeRoom(const UnsignedLong size, bool& changed) {
+    while(_residentSize + size > _budget) {
+        /* Find the least recently used texture that has levels to evict. A
+           texture visible in this frame is a candidate only if it has finer
+           levels than it currently needs. */
+        Entry* candidate = nullptr;
+        for(Entry& entry: _entries) {
+            if(!entry.texture || entry.resident >= entry.coarse) continue;
+            if(entry.lastUsed == _frame && entry.resident >= entry.requested) continue;
+            if(!candidate || entry.lastUsed < candidate->lastUsed)
+                candidate = &entry;
+        }
+        if(!candidate) return false;
+
+        setResident(*candidate, candidate->resident + 1);
+        changed = true;
+    }
+
+    return true;
+}
+
+bool TextureStreamer::update() {
+    /* Textures wanting finer levels than they have, the most blurry ones
+       first so all visible textures get sharper at a similar pace */
+    _pending.clear();
+    for(UnsignedInt i = 0; i != _entries.size(); ++i)
+        if(_entries[i].texture && _entries[i].requested < _entries[i].resident)
+            _pending.push_back(i);
+    std::sort(_pending.begin(), _pending.end(), [this](UnsignedInt a, UnsignedInt b) {
+        return _entries[a].resident - _entries[a].requested > _entries[b].resident - _entries[b].requested;
+    });
+
+    /* Upload one finer level for each, as long as the upload size and the
+       budget allow it */
+    bool changed = false;
+    UnsignedLong uploaded = 0;
+    for(const UnsignedInt id: _pending) {
+        Entry& entry = _entries[id];
+        const UnsignedLong size = levelSize(entry, entry.resident - 1);
+        if(uploaded && uploaded + size > MaxUploadSize) break;
+        if(!makeRoom(size, changed)) continue;
+
+        setResident(entry, entry.resident - 1);
+        uploaded += size;
+        changed = true;
+    }
+
+    /* Drawables request again in the next frame */
+    for(Entry& entry: _entries) entry.requested = entry.levels.size();
+    ++_frame;
+
+    return changed;
+}
+
+}}
@@ -0,0 +1,152 @@
+#ifndef Magnum_Examples_TextureStreamer_h
+#define Magnum_Examples_TextureStreamer_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Corrade/Containers/Array.h>
+#include <Magnum/Array.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/Sampler.h>
+#include <Magnum/GL/GL.h>
+#include <Magnum/GL/TextureFormat.h>
+
+namespace Magnum { namespace Examples {
+
+/** @brief Image with all its mip levels in a single allocation */
+struct MipChain {
+    Containers::Array<char> data;
+
+    /** Levels from the finest to 1x1, pointing into @ref data */
+    std::vector<ImageView2D> levels;
+};
+
+/**
+@brief Generate a mip chain on the CPU
+
+Copies the image and successively downsamples it with a 2x2 box filter. All
+levels are tightly packed with the row alignment set to 1. Only
+@ref PixelFormat::RGB8Unorm and @ref PixelFormat::RGBA8Unorm are supported,
+for other formats an empty chain is returned.
+*/
+MipChain generateMipChain(const ImageView2D& image);
+
+/**
+@brief Streams texture mip levels in and out of GPU memory
+
+Only the coarse levels of each texture are uploaded initially. Drawables then
+@ref request() the level they need based on how large they are on screen and
+@ref update() uploads the finer levels, a step at a time. Once the resident
+size would exceed the budget, the finest levels of textures that were not
+visible for the longest time are evicted to make room.
+
+Changing the resident levels means recreating the texture, as its storage is
+immutable. Levels that stay resident are copied from the old texture on the
+GPU, so only the newly resident level is uploaded and evictions upload
+nothing. The new texture is move-assigned to the original instance, so
+references to it stay valid.
+*/
+class TextureStreamer {
+    public:
+        /**
+         * @brief Constructor
+         * @param textureCount  Count of texture IDs
+         * @param budget        GPU memory budget in bytes
+         */
+        explicit TextureStreamer(UnsignedInt textureCount, UnsignedLong budget);
+
+        /**
+         * @brief Start streaming a texture
+         * @param id            Texture ID
+         * @param texture       Texture to manage. Expected to stay at the
+         *      same address for the whole streamer lifetime.
+         * @param format        Texture format
+         * @param levels        All image levels, from the finest to 1x1.
+         *      Expected to stay valid for the whole streamer lifetime.
+         * @param data          Data the @p levels point to, if they should
+         *      be owned by the streamer
+         *
+         * Uploads all levels not larger than 64 pixels right away. Those are
+         * never evicted.
+         */
+        void setTexture(UnsignedInt id, GL::Texture2D& texture, SamplerFilter magnificationFilter, SamplerFilter minificationFilter, SamplerMipmap mipmapFilter, const Array2D<SamplerWrapping>& wrapping, GL::TextureFormat format, std::vector<ImageView2D> levels, Containers::Array<char> data = {});
+
+        /**
+         * @brief Request a texture to be drawn at given size
+         *
+         * Called by drawables every frame they're visible, with the size of
+         * the object on screen in pixels, assuming the texture spans the
+         * object once. If more drawables use the same texture, the largest
+         * request wins.
+         */
+        void request(UnsignedInt id, Float projectedSize);
+
+        /**
+         * @brief Upload or evict levels
+         *
+         * Called once per frame after all drawables made their requests.
+         * Returns @cpp true @ce if any texture changed and the frame should
+         * be drawn again.
+         */
+        bool update();
+
+        /** @brief GPU memory budget in bytes */
+        UnsignedLong budget() const { return _budget; }
+
+        /** @brief Size of all resident levels in bytes */
+        UnsignedLong residentSize() const { return _residentSize; }
+
+    private:
+        struct Entry {
+            GL::Texture2D* texture;
+            SamplerFilter magnificationFilter, minificationFilter;
+            SamplerMipmap mipmapFilter;
+            Array2D<SamplerWrapping> wrapping;
+            GL::TextureFormat format;
+            std::vector<ImageView2D> levels;
+            Containers::Array<char> data;
+
+            /* Finest resident, coarsest always-resident and finest requested
+               level */
+            UnsignedInt resident, coarse, requested;
+            UnsignedLong lastUsed;
+        };
+
+        UnsignedLong levelSize(const Entry& entry, UnsignedInt level) const;
+        void setResident(Entry& entry, UnsignedInt level);
+        bool makeRoom(UnsignedLong size, bool& changed);
+
+        UnsignedLong _budget, _residentSize{}, _frame;
+        std::vector<Entry> _entries;
+        std::vector<UnsignedInt> _pending;
+};
+
+}}
+
+#endif
@@ -0,0 +1,202 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "TransformCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/SceneGraph/MatrixTransformation3D.h>
+#include <Magnum/SceneGraph/Scene.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define MAGNUM_EXAMPLES_TRANSFORMCACHE_SSE
+#endif
+
+#include "Types.h"
+
+namespace Magnum { namespace Examples {
+
+Matrix4 multiply(const Matrix4& a, const Matrix4& b) {
+    #ifdef MAGNUM_EXAMPLES_TRANSFORMCACHE_SSE
+    /* Each column of the result is a linear combination of columns of a,
+       weighted by the corresponding column of b */
+    const __m128 a0 = _mm_loadu_ps(a[0].data());
+    const __m128 a1 = _mm_loadu_ps(a[1].data());
+    const __m128 a2 = _mm_loadu_ps(a[2].data());
+    const __m128 a3 = _mm_loadu_ps(a[3].data());
+    Matrix4 out{NoInit};
+    for(std::size_t i = 0; i != 4; ++i) {
+        const Float* const column = b[i].data();
+        __m128 result = _mm_mul_ps(a0, _mm_set1_ps(column[0]));
+        result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(column[1])));
+        result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(column[2])));
+        result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(column[3])));
+        _mm_storeu_ps(out[i].data(), result);
+    }
+    return out;
+    #else
+    return a*b;
+    #endif
+}
+
+UnsignedInt TransformCache::add(const Int parent, const Matrix4& transformation) {
+    _parents.push_back(parent);
+    _transformations.push_back(transformation);
+    _absoluteTransformations.emplace_back();
+    _dirty.push_back(true);
+    _firstDirty = Math::min(_firstDirty, _parents.size() - 1);
+    return _parents.size() - 1;
+}
+
+void TransformCache::setTransformation(const UnsignedInt id, const Matrix4& transformation) {
+    _transformations[id] = transformation;
+    _dirty[id] = true;
+    _firstDirty = Math::min(_firstDirty, std::size_t(id));
+}
+
+std::size_t TransformCache::update() {
+    /* Parents are before children, so a dirty flag propagates down the whole
+       subtree in a single pass */
+    std::size_t count = 0;
+    for(std::size_t i = _firstDirty; i < _parents.size(); ++i) {
+        const Int parent = _parents[i];
+        if(parent != -1 && _dirty[parent]) _dirty[i] = true;
+        if(!_dirty[i]) continue;
+
+        _absoluteTransformations[i] = parent == -1 ? _transformations[i] :
+            multiply(_absoluteTransformations[parent], _transformations[i]);
+        ++count;
+    }
+
+    /* Clear the flags only after, as they're needed for the propagation */
+    if(_firstDirty < _dirty.size())
+        std::fill(_dirty.begin() + _firstDirty, _dirty.end(), 0);
+    _firstDirty = _dirty.size();
+    return count;
+}
+
+void TransformCache::transformations(const Matrix4& transformation, const Containers::ArrayView<const UnsignedInt> ids, const Containers::ArrayView<Matrix4> out) const {
+    for(std::size_t i = 0; i != ids.size(); ++i)
+        out[i] = multiply(transformation, _absoluteTransformations[ids[i]]);
+}
+
+void benchmarkTransformCache(const UnsignedInt objectCount) {
+    if(!objectCount) return;
+
+    /* Random hierarchy with a single root, each object parented to some
+       earlier one */
+    std::mt19937 random;
+    std::uniform_real_distribution<Float> angle{0.0f, 360.0f}, offset{-1.0f, 1.0f};
+    Scene3D scene;
+    std::vector<Object3D*> objects;
+    std::vector<std::reference_wrapper<Object3D>> objectReferences;
+    TransformCache cache;
+    objects.reserve(objectCount);
+    objectReferences.reserve(objectCount);
+    for(UnsignedInt i = 0; i != objectCount; ++i) {
+        const Int parent = i ? Int(random()%i) : -1;
+        const Matrix4 transformation =
+            Matrix4::translation({offset(random), offset(random), offset(random)})*
+            Matrix4::rotation(Deg(angle(random)), Vector3{offset(random), offset(random), 1.0f}.normalized());
+
+        auto* object = new Object3D{parent == -1 ? &scene : objects[parent]};
+        object->setTransformation(transformation);
+        objects.push_back(object);
+        objectReferences.push_back(*object);
+        cache.add(parent, transformation);
+    }
+
+    /* Average time of given operation in milliseconds */
+    constexpr UnsignedInt Iterations = 10;
+    auto measure = [](const std::function<void()>& operation) {
+        const auto start = std::chrono::steady_clock::now();
+        for(UnsignedInt i = 0; i != Iterations; ++i) operation();
+        return std::chrono::duration<Double, std::milli>(std::chrono::steady_clock::now() - start).count()/Iterations;
+    };
+
+    std::vector<Matrix4> sceneGraphTransformations;
+    const Double sceneGraphTime = measure([&]{
+        sceneGraphTransformations = scene.transformationMatrices(objectReferences);
+    });
+
+    /* Dirtying the root recalculates everything */
+    const Double fullTime = measure([&]{
+        cache.setTransformation(0, cache.transformation(0));
+        cache.update();
+    });
+
+    /* Verify both give the same result */
+    Float difference = 0.0f;
+    for(UnsignedInt i = 0; i != objectCount; ++i)
+        for(std::size_t j = 0; j != 4; ++j)
+            difference = Math::max(difference, Math::abs(sceneGraphTransformations[i][j] - cache.absoluteTransformation(i)[j]).max());
+
+    /* Dirty a single object somewhere in the middle */
+    std::size_t subtreeCount = 0;
+    const Double subtreeTime = measure([&]{
+        cache.setTransformation(objectCount/2, cache.transformation(objectCount/2));
+        subtreeCount = cache.update();
+    });
+
+    const Double cleanTime = measure([&]{ cache.update(); });
+
+    /* Batch multiplication with a camera matrix, SSE and scalar */
+    std::vector<UnsignedInt> ids(objectCount);
+    for(UnsignedInt i = 0; i != objectCount; ++i) ids[i] = i;
+    Containers::Array<Matrix4> out{objectCount};
+    const Matrix4 camera = Matrix4::lookAt({0.0f, 0.0f, 10.0f}, {}, Vector3::yAxis()).inverted();
+    const Double batchTime = measure([&]{
+        cache.transformations(camera, Containers::arrayView(ids.data(), ids.size()), out);
+    });
+    const Double scalarBatchTime = measure([&]{
+        for(UnsignedInt i = 0; i != objectCount; ++i)
+            out[i] = camera*cache.absoluteTransformation(i);
+    });
+
+    Debug{} << "Absolute transformations of" << objectCount << "objects:";
+    Debug{} << "  scene graph:" << sceneGraphTime << "ms";
+    Debug{} << "  cache, everything dirty:" << fullTime << "ms, max difference" << difference;
+    Debug{} << "  cache," << subtreeCount << "objects in a dirty subtree:" << subtreeTime << "ms";
+    Debug{} << "  cache, nothing dirty:" << cleanTime << "ms";
+    Debug{} << "  multiplying with camera matrix:" << batchTime << "ms batched,"
+        << scalarBatchTime << "ms scalar"
+        #ifdef MAGNUM_EXAMPLES_TRANSFORMCACHE_SSE
+        << "(SSE enabled)";
+        #else
+        << "(SSE not available)";
+        #endif
+}
+
+}}
@@ -0,0 +1,133 @@
+#ifndef Magnum_Examples_TransformCache_h
+#define Magnum_Examples_TransformCache_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019 —
+            Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Math/Matrix4.h>
+
+namespace Magnum { namespace Examples {
+
+/**
+@brief Multiply two matrices
+
+Equivalent to @cpp a*b @ce, but using SSE if the target supports it.
+*/
+Matrix4 multiply(const Matrix4& a, const Matrix4& b);
+
+/**
+@brief Flattened cache of absolute object transformations
+
+Unlike @ref SceneGraph::Object, which walks up the hierarchy every time an
+absolute transformation is queried, this stores the hierarchy as plain
+arrays of parent indices, relative and absolute transformations. Parents
+always come before their children, so all absolute transformations can be
+updated in a single linear pass. Changing a transformation only marks the
+node as dirty and @ref update() then recalculates just the dirty nodes and
+their descendants, skipping everything before the first dirty node.
+
+Absolute transformations are relative to a common root that isn't part of the
+cache, which means transforming the root --- such as rotating the whole scene
+--- doesn't make anything dirty. The root transformation is applied when
+@ref transformations() are queried.
+*/
+class TransformCache {
+    public:
+        /**
+         * @brief Add a node
+         * @param parent            Parent node ID or @cpp -1 @ce for a node
+         *      directly under the root. Has to be already added.
+         * @param transformation    Transformation relative to the parent
+         * @return Node ID
+         */
+        UnsignedInt add(Int parent, const Matrix4& transformation);
+
+        /** @brief Node count */
+        std::size_t size() const { return _parents.size(); }
+
+        /** @brief Parent node ID or @cpp -1 @ce */
+        Int parent(UnsignedInt id) const { return _parents[id]; }
+
+        /** @brief Transformation relative to the parent */
+        const Matrix4& transformation(UnsignedInt id) const {
+            return _transformations[id];
+        }
+
+        /** @brief Set transformation relative to the parent */
+        void setTransformation(UnsignedInt id, const Matrix4& transformation);
+
+        /**
+         * @brief Transformation relative to the root
+         *
+         * Valid only after @ref update() if any transformation changed.
+         */
+        const Matrix4& absoluteTransformation(UnsignedInt id) const {
+            return _absoluteTransformations[id];
+        }
+
+        /**
+         * @brief Update absolute transformations of dirty nodes
+         * @return Count of recalculated nodes
+         */
+        std::size_t update();
+
+        /**
+         * @brief Absolute transformations of given nodes
+         * @param transformation    Transformation to multiply each absolute
+         *      transformation with, such as camera matrix multiplied with
+         *      the root transformation
+         * @param ids               Node IDs
+         * @param out               Where to put the transformations, expected
+         *      to have the same size as @p ids
+         */
+        void transformations(const Matrix4& transformation, Containers::ArrayView<const UnsignedInt> ids, Containers::ArrayView<Matrix4> out) const;
+
+    private:
+        std::vector<Int> _parents;
+        std::vector<Matrix4> _transformations;
+        std::vector<Matrix4> _absoluteTransformations;
+        /* Not std::vector<bool> to avoid bit twiddling in the update loop */
+        std::vector<UnsignedByte> _dirty;
+        std::size_t _firstDirty{};
+};
+
+/**
+@brief Benchmark the transformation cache
+
+Creates a random hierarchy of @p objectCount objects both in the scene graph
+and in a @ref TransformCache, and prints how long it takes to calculate all
+absolute transformations with each, to update a single dirty subtree and to
+multiply the matrices with and without SSE.
+*/
+void benchmarkTransformCache(UnsignedInt objectCount);
+
+}}
+
+#endif
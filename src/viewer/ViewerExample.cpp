@@ -28,19 +28,43 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <map>
+#include <thread>
+#include <tuple>
 #include <Corrade/Containers/Array.h>
 #include <Corrade/Containers/Optional.h>
 #include <Corrade/PluginManager/Manager.h>
 #include <Corrade/Utility/Arguments.h>
+#include <Corrade/Utility/FormatStl.h>
+#include <Magnum/Array.h>
+#include <Magnum/Image.h>
+#include <Magnum/ImageView.h>
 #include <Magnum/Mesh.h>
 #include <Magnum/PixelFormat.h>
+#include <Magnum/Sampler.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
+#include <Magnum/GL/Framebuffer.h>
 #include <Magnum/GL/Mesh.h>
+#include <Magnum/Math/ConfigurationValue.h>
+#ifndef MAGNUM_TARGET_GLES
+#include <Magnum/GL/PrimitiveQuery.h>
+#endif
+#include <Magnum/GL/Renderbuffer.h>
+#include <Magnum/GL/RenderbufferFormat.h>
 #include <Magnum/GL/Renderer.h>
 #include <Magnum/GL/Texture.h>
+#include <Magnum/GL/TextureArray.h>
 #include <Magnum/GL/TextureFormat.h>
+#ifndef MAGNUM_TARGET_GLES
+#include <Magnum/GL/TimeQuery.h>
+#endif
 #include <Magnum/MeshTools/Compile.h>
+#include <Magnum/MeshTools/CompressIndices.h>
 #include <Magnum/Platform/Sdl2Application.h>
 #include <Magnum/SceneGraph/Camera.h>
 #include <Magnum/SceneGraph/Drawable.h>
@@ -57,12 +81,162 @@
 #include <Magnum/Shaders/MeshVisualizer.h>
 #include <Magnum/Shaders/Flat.h>
 
+#include "Deduplicator.h"
+#include "FrameAccumulator.h"
+#include "FrameUniforms.h"
+#include "FrustumCuller.h"
+#include "InstancedDrawable.h"
+#include "MeshLod.h"
+#include "MeshOptimizer.h"
+#include "MultiDrawDrawable.h"
+#include "OcclusionCuller.h"
+#include "PngWriter.h"
+#include "QuantizedMesh.h"
+#include "RenderQueue.h"
+#include "SceneCache.h"
+#include "SceneShader.h"
+#include "TextureArrays.h"
+#include "TextureDecoder.h"
+#include "TextureStreamer.h"
+#include "TransformCache.h"
+#include "Types.h"
+
 namespace Magnum { namespace Examples {
 
 using namespace Math::Literals;
 
-typedef SceneGraph::Object<SceneGraph::MatrixTransformation3D> Object3D;
-typedef SceneGraph::Scene<SceneGraph::MatrixTransformation3D> Scene3D;
+namespace {
+
+/* World-space position of the light used by the textured drawables */
+constexpr Vector3 LightPosition{-100.0f, 100.0f, 100.0f};
+
+/* Meshes simple enough to be rasterized as occluders */
+constexpr UnsignedInt MaxOccluderTriangleCount = 1024;
+
+/* How many times to render a tile again if streamed texture levels changed */
+constexpr UnsignedInt MaxTileRefinements = 4;
+
+Double milliseconds(std::chrono::nanoseconds duration) {
+    return std::chrono::duration<Double, std::milli>(duration).count();
+}
+
+/* Compare the size of vertex data uploaded as 32-bit floats, as done by
+   MeshTools::compile(), with the quantized layout */
+void printVertexMemory(const UnsignedLong vertexCount, const UnsignedLong texturedVertexCount, const bool quantized) {
+    const UnsignedLong floatSize = vertexCount*(3 + 3)*4 + texturedVertexCount*2*4;
+    const UnsignedLong quantizedSize = vertexCount*sizeof(QuantizedVertex);
+    if(!floatSize) return;
+    Debug{} << "Vertex data take" << floatSize/1024 << "kB as floats and"
+        << quantizedSize/1024 << "kB quantized (" << Debug::nospace
+        << 100*quantizedSize/floatSize << Debug::nospace << "%), using"
+        << (quantized ? "quantized" : "floats");
+}
+
+/* Approximate GPU memory taken by a compiled mesh, including index type
+   compression done by MeshTools::compressIndices() */
+UnsignedLong meshSize(const Trade::MeshData3D& data, const bool quantized) {
+    const UnsignedLong vertexCount = data.positions(0).size();
+    UnsignedLong size = vertexCount*(quantized ? sizeof(QuantizedVertex) :
+        data.hasTextureCoords2D() ? 32 : 24);
+    if(data.isIndexed()) {
+        UnsignedInt max = 0;
+        for(const UnsignedInt index: data.indices()) max = Math::max(max, index);
+        size += data.indices().size()*(max > 0xffff ? 4 : max > 0xff ? 2 : 1);
+    }
+    return size;
+}
+
+std::vector<UnsignedInt> decompressIndices(const Containers::ArrayView<const char> data, const MeshIndexType type) {
+    std::vector<UnsignedInt> out;
+    if(type == MeshIndexType::UnsignedByte) {
+        for(const char index: data) out.push_back(UnsignedByte(index));
+    } else if(type == MeshIndexType::UnsignedShort) {
+        for(std::size_t i = 0; i + 2 <= data.size(); i += 2) {
+            UnsignedShort index;
+            std::memcpy(&index, data + i, 2);
+            out.push_back(index);
+        }
+    } else {
+        for(std::size_t i = 0; i + 4 <= data.size(); i += 4) {
+            UnsignedInt index;
+            std::memcpy(&index, data + i, 4);
+            out.push_back(index);
+        }
+    }
+    return out;
+}
+
+/* The benchmark and tiled rendering modes need to be known before the window
+   gets created, so they're looked for directly instead of waiting for
+   Utility::Arguments */
+bool isOffscreen(const Platform::Application::Arguments& arguments) {
+    for(int i = 1; i < arguments.argc; ++i)
+        if(std::strcmp(arguments.argv[i], "--benchmark") == 0 ||
+           std::strcmp(arguments.argv[i], "--tiled-render") == 0) return true;
+    return false;
+}
+
+/* For offscreen rendering, the window is hidden and SDL uses its EGL-backed
+   offscreen driver, unless told otherwise, so no display is needed */
+Platform::Application::Configuration windowConfiguration(const Platform::Application::Arguments& arguments) {
+    Platform::Application::Configuration configuration;
+    configuration.setTitle("Magnum Viewer Example");
+    if(isOffscreen(arguments)) {
+        #ifndef CORRADE_TARGET_WINDOWS
+        setenv("SDL_VIDEODRIVER", "offscreen", 0);
+        #endif
+        configuration.setWindowFlags(Platform::Application::Configuration::WindowFlag::Hidden);
+    } else configuration.setWindowFlags(Platform::Application::Configuration::WindowFlag::Resizable);
+    return configuration;
+}
+
+/* Software rasterizers are slow enough even without multisampling, and the
+   offscreen modes don't use the default framebuffer anyway */
+Platform::Application::GLConfiguration glConfiguration(const Platform::Application::Arguments& arguments) {
+    return Platform::Application::GLConfiguration{}
+        .setSampleCount(isOffscreen(arguments) ? 0 : 16);
+}
+
+/* Color and depth target for the offscreen modes */
+struct OffscreenFramebuffer {
+    explicit OffscreenFramebuffer(const Vector2i& size): framebuffer{{{}, size}} {
+        color.setStorage(GL::RenderbufferFormat::RGBA8, size);
+        depth.setStorage(GL::RenderbufferFormat::DepthComponent24, size);
+        framebuffer
+            .attachRenderbuffer(GL::Framebuffer::ColorAttachment{0}, color)
+            .attachRenderbuffer(GL::Framebuffer::BufferAttachment::Depth, depth);
+    }
+
+    GL::Renderbuffer color, depth;
+    GL::Framebuffer framebuffer;
+};
+
+Containers::Optional<GL::TextureFormat> textureFormat(const PixelFormat format) {
+    if(format == PixelFormat::RGB8Unorm)
+        return GL::TextureFormat::RGB8;
+    if(format == PixelFormat::RGBA8Unorm)
+        return GL::TextureFormat::RGBA8;
+    return Containers::NullOpt;
+}
+
+Containers::Optional<GL::Texture2D> createTexture(SamplerFilter magnificationFilter, SamplerFilter minificationFilter, SamplerMipmap mipmapFilter, const Array2D<SamplerWrapping>& wrapping, const ImageView2D& image) {
+    const Containers::Optional<GL::TextureFormat> format = textureFormat(image.format());
+    if(!format) return Containers::NullOpt;
+
+    /* Configure the texture */
+    GL::Texture2D texture;
+    texture
+        .setMagnificationFilter(magnificationFilter)
+        .setMinificationFilter(minificationFilter, mipmapFilter)
+        .setWrapping(wrapping)
+        .setStorage(Math::log2(image.size().max()) + 1, *format, image.size())
+        .setSubImage(0, {}, image)
+        .generateMipmap();
+
+    return Containers::Optional<GL::Texture2D>{std::move(texture)};
+}
+
+}
 
 class ViewerExample: public Platform::Application {
     public:
@@ -71,6 +245,7 @@ class ViewerExample: public Platform::Application {
     private:
         void drawEvent() override;
         void viewportEvent(ViewportEvent& event) override;
+        void keyPressEvent(KeyEvent& event) override;
         void mousePressEvent(MouseEvent& event) override;
         void mouseReleaseEvent(MouseEvent& event) override;
         void mouseMoveEvent(MouseMoveEvent& event) override;
@@ -78,7 +253,25 @@ class ViewerExample: public Platform::Application {
 
         Vector3 positionOnSphere(const Vector2i& position) const;
 
-        void addObject(Trade::AbstractImporter& importer, Containers::ArrayView<const Containers::Optional<Trade::PhongMaterialData>> materials, Object3D& parent, UnsignedInt i);
+        /* Culls and draws the scene into given framebuffer */
+        void render(GL::AbstractFramebuffer& framebuffer);
+
+        /* Bytes of uniform data uploaded in the last frame */
+        UnsignedLong uniformUploadSize() const;
+
+        /* Renders the benchmark frames offscreen and writes the statistics */
+        void benchmark();
+
+        /* Renders a large image in tiles and writes it to a PNG file */
+        void renderTiled();
+
+        /* Schedules a redraw and restarts progressive accumulation. Call
+           whenever anything affecting the rendered image changes. */
+        void markDirty();
+
+        void loadCache(const SceneCache& cache, bool quantized, UnsignedLong textureBudget, bool textureArrays);
+        void importObjects(Trade::AbstractImporter& importer, Containers::ArrayView<const Containers::Optional<Trade::PhongMaterialData>> materials, std::vector<ObjectRecord>& objects, const std::vector<UnsignedInt>& roots);
+        void addObjects(Containers::ArrayView<const ObjectRecord> objects, Containers::ArrayView<const MaterialRecord> materials);
 
         Shaders::Phong _coloredShader,
             _texturedShader{Shaders::Phong::Flag::DiffuseTexture};
@@ -87,17 +280,99 @@ class ViewerExample: public Platform::Application {
 
         Shaders::Flat3D _flatShader{NoCreate};
 
+        /* If uniform buffers are supported, projection and light are
+           uploaded once per frame and shared by the shaders below and the
+           instanced ones. The queue then uses these instead of the two
+           above. */
+        Containers::Pointer<FrameUniforms> _frameUniforms;
+        SceneShader _coloredSceneShader{NoCreate}, _texturedSceneShader{NoCreate};
+
+        /* Depth-only shader and position-only meshes for the depth
+           pre-pass, if enabled. Needs the uniform block shaders above. */
+        SceneShader _depthShader{NoCreate};
+        Containers::Array<Containers::Optional<GL::Mesh>> _depthMeshes;
+
+        /* Colored and textured drawables are drawn through a queue sorted by
+           GL state */
+        RenderQueue _renderQueue{_flatShader, _texturedShader};
+
+        /* Drawables sharing the same mesh and texture are drawn instanced,
+           if supported */
+        Containers::Pointer<InstanceRenderer> _instanceRenderer;
+
+        /* Or, alternatively, everything is packed into a single buffer and
+           drawn with multi-draw-indirect */
+        Containers::Pointer<MultiDrawRenderer> _multiDrawRenderer;
+
         Containers::Array<Containers::Optional<GL::Mesh>> _meshes;
+        Containers::Array<Range3D> _meshBounds;
+        /* Dequantization matrices if meshes are quantized, identity
+           otherwise */
+        Containers::Array<Matrix4> _meshTransformations;
+        Containers::Array<std::vector<MeshLevel>> _meshLevels;
         Containers::Array<Containers::Optional<GL::Texture2D>> _textures;
 
+        /* Textures packed into texture arrays for batched drawing instead of
+           the above, if enabled */
+        Containers::Pointer<TextureArrays> _textureArrays;
+
+        /* Uploads texture mip levels on demand within a memory budget, if
+           enabled. When loaded from the scene cache, the levels point into
+           its mapping, so it's kept for the whole streamer lifetime. */
+        Containers::Optional<SceneCache> _sceneCache;
+        Containers::Pointer<TextureStreamer> _textureStreamer;
+
         Scene3D _scene;
         Object3D _manipulator, _cameraObject;
+        /* All scene objects, direct children of the manipulator with their
+           transformations in _transforms. Has to be destroyed before it,
+           which happens in reverse order so children are always removed from
+           their parents before these get destroyed. */
+        Containers::Array<Object3D> _objects;
         SceneGraph::Camera3D* _camera;
-        SceneGraph::DrawableGroup3D _drawables;
+        Matrix4 _projectionMatrix;
+        SceneGraph::DrawableGroup3D _drawables, _instancedDrawables;
         Vector3 _previousPosition;
 
+        /* Absolute transformations of all objects relative to the
+           manipulator, so rotating the scene doesn't need any update. All
+           drawables with their transformation cache nodes, used if culling
+           is disabled. */
+        TransformCache _transforms;
+        std::vector<SceneGraph::Drawable3D*> _drawableList;
+        std::vector<UnsignedInt> _drawableTransforms;
+        std::vector<Matrix4> _drawableTransformations;
+
+        /* Draws only drawables in the view frustum instead of the groups
+           above, if enabled */
+        Containers::Pointer<FrustumCuller> _culler;
+
+        /* Additionally culls drawables hidden behind large occluders, if
+           enabled */
+        Containers::Pointer<OcclusionCuller> _occlusionCuller;
+        std::string _title;
+
+        /* Frames are drawn only when something changes, unless continuous
+           redraw is requested. If the progressive mode is enabled, jittered
+           frames keep being accumulated while idle until the count is
+           reached. */
+        bool _continuous;
+        UnsignedInt _progressiveFrameCount;
+        Containers::Pointer<FrameAccumulator> _accumulator;
+
+        /* If non-zero, the given count of frames is rendered offscreen along
+           an orbit around the scene and the application exits */
+        UnsignedInt _benchmarkFrameCount;
+        std::string _benchmarkOutput;
+
+        /* If non-empty, an image of given size is rendered in tiles of given
+           size to this file and the application exits */
+        std::string _tiledRenderOutput;
+        Vector2i _tiledRenderSize;
+        Int _tileSize;
+
         Color4 blue = 0x0000ffff_rgbaf;
-        Color4 opaque = 0x00000000_rgbaf;
+        Color4 flatColor = 0xfffffff_rgbf;
 
         Color4 wfColor = 0x00ff08_rgbf;
         Color4 wfpColor = 0x00000000_rgbaf;
@@ -105,41 +380,71 @@ class ViewerExample: public Platform::Application {
 
 class ColoredDrawable: public SceneGraph::Drawable3D {
     public:
-
-        explicit ColoredDrawable(Object3D& object, Shaders::Flat3D& shader, GL::Mesh& mesh, const Color4& color, SceneGraph::DrawableGroup3D& group): SceneGraph::Drawable3D{object, &group}, _shader(shader), _mesh(mesh), _color{color} {}
+        explicit ColoredDrawable(Object3D& object, RenderQueue& queue, UnsignedInt meshId, GL::Mesh& mesh, const Matrix4& meshTransformation, const MeshLod& lod, const Color4& color, SceneGraph::DrawableGroup3D& group): SceneGraph::Drawable3D{object, &group}, _queue(queue), _meshId{meshId}, _mesh(mesh), _meshTransformation{meshTransformation}, _lod{lod}, _color{color} {}
 
     private:
         void draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D& camera) override;
 
-        Shaders::Flat3D& _shader;
+        RenderQueue& _queue;
+        UnsignedInt _meshId;
         GL::Mesh& _mesh;
+        Matrix4 _meshTransformation;
+        MeshLod _lod;
         Color4 _color;
 };
 
 class TexturedDrawable: public SceneGraph::Drawable3D {
     public:
-        explicit TexturedDrawable(Object3D& object, Shaders::Phong& shader, GL::Mesh& mesh, GL::Texture2D& texture, SceneGraph::DrawableGroup3D& group): SceneGraph::Drawable3D{object, &group}, _shader(shader), _mesh(mesh), _texture(texture) {}
+        explicit TexturedDrawable(Object3D& object, RenderQueue& queue, UnsignedInt meshId, GL::Mesh& mesh, const Matrix4& meshTransformation, const MeshLod& lod, UnsignedInt textureId, GL::Texture2D& texture, TextureStreamer* streamer, SceneGraph::DrawableGroup3D& group): SceneGraph::Drawable3D{object, &group}, _queue(queue), _meshId{meshId}, _mesh(mesh), _meshTransformation{meshTransformation}, _lod{lod}, _textureId{textureId}, _texture(texture), _streamer{streamer} {}
 
     private:
         void draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D& camera) override;
 
-        Shaders::Phong& _shader;
+        RenderQueue& _queue;
+        UnsignedInt _meshId;
         GL::Mesh& _mesh;
+        Matrix4 _meshTransformation;
+        MeshLod _lod;
+        UnsignedInt _textureId;
         GL::Texture2D& _texture;
+        TextureStreamer* _streamer;
 };
 
 ViewerExample::ViewerExample(const Arguments& arguments):
-    Platform::Application{arguments, Configuration{}
-        .setTitle("Magnum Viewer Example")
-        .setWindowFlags(Configuration::WindowFlag::Resizable),
-        GLConfiguration{}.setSampleCount(16)}
+    Platform::Application{arguments, windowConfiguration(arguments), glConfiguration(arguments)}
 {
     Utility::Arguments args;
     args.addArgument("file").setHelp("file", "file to load")
         .addOption("importer", "AnySceneImporter").setHelp("importer", "importer plugin to use")
+        .addBooleanOption("cache").setHelp("cache", "load the scene from a binary cache next to the file, creating it if it doesn't exist")
+        .addBooleanOption("no-instancing").setHelp("no-instancing", "draw every object separately even if instancing is supported")
+        .addBooleanOption("multidraw").setHelp("multidraw", "pack all meshes into a single buffer and draw them with multi-draw-indirect, if supported")
+        .addBooleanOption("no-culling").setHelp("no-culling", "draw all objects without frustum culling")
+        .addOption("occlusion", "none").setHelp("occlusion", "cull objects hidden behind large occluders, rasterizing them on the GPU or in software on the CPU", "none|gpu|cpu")
+        .addBooleanOption("no-sorting").setHelp("no-sorting", "draw objects in scene order instead of sorting them by GL state")
+        .addBooleanOption("lods").setHelp("lods", "generate simplified levels of detail for meshes on import")
+        .addBooleanOption("quantize").setHelp("quantize", "upload vertex data in a compact format with 16-bit positions, packed normals and half-float texture coordinates")
+        .addBooleanOption("depth-prepass").setHelp("depth-prepass", "draw opaque objects into the depth buffer first and then shade only the visible samples, toggle with P at runtime")
+        .addBooleanOption("optimize-meshes").setHelp("optimize-meshes", "reorder mesh triangles and vertices on import for vertex cache, overdraw and vertex fetch efficiency")
+        .addBooleanOption("continuous").setHelp("continuous", "redraw continuously instead of only when something changes")
+        .addOption("progressive", "0").setHelp("progressive", "accumulate up to N jittered frames while idle for supersampling, 0 disables", "N")
+        .addBooleanOption("texture-arrays").setHelp("texture-arrays", "pack textures of the same size and format into texture arrays, so batched objects with different textures can be drawn together, needs instancing or multi-draw")
+        .addOption("texture-budget", "0").setHelp("texture-budget", "upload only coarse texture mip levels initially and stream finer ones in as needed, keeping at most given amount of GPU memory, 0 uploads everything upfront", "MB")
+        .addOption("benchmark", "0").setHelp("benchmark", "render N frames offscreen along an orbit around the scene, write per-frame statistics as JSON and exit", "N")
+        .addOption("benchmark-output", "benchmark.json").setHelp("benchmark-output", "where to write the benchmark statistics", "file")
+        .addOption("tiled-render").setHelp("tiled-render", "render an image of --tiled-size in tiles, write it to a PNG file and exit", "file.png")
+        .addOption("tiled-size", "16384 16384").setHelp("tiled-size", "size of the tiled render", "\"W H\"")
+        .addOption("tile-size", "2048").setHelp("tile-size", "size of a single tile, limited by the maximal framebuffer size", "N")
+        .addOption("benchmark-transforms", "0").setHelp("benchmark-transforms", "compare absolute transformation calculation on a random hierarchy of N objects and exit", "N")
+        .addOption("decode-threads", std::to_string(std::thread::hardware_concurrency())).setHelp("decode-threads", "number of texture decoding threads, 0 decodes serially on the main thread", "N")
         .addSkippedPrefix("magnum", "engine-specific options")
         .parse(arguments.argc, arguments.argv);
 
+    if(const UnsignedInt objectCount = args.value<UnsignedInt>("benchmark-transforms")) {
+        benchmarkTransformCache(objectCount);
+        std::exit(0);
+    }
+
     /* Every scene needs a camera */
     _cameraObject
         .setParent(&_scene)
@@ -147,14 +452,47 @@ ViewerExample::ViewerExample(const Arguments& arguments):
 
     //float inf = 1/0;
 
+    _projectionMatrix = Matrix4::perspectiveProjection(35.0_degf, 1.0f, 0.01f, 2000.0f);
     (*(_camera = new SceneGraph::Camera3D{_cameraObject}))
         .setAspectRatioPolicy(SceneGraph::AspectRatioPolicy::Extend)
-        .setProjectionMatrix(Matrix4::perspectiveProjection(35.0_degf, 1.0f, 0.01f, 2000.0f))
+        .setProjectionMatrix(_projectionMatrix)
         .setViewport(GL::defaultFramebuffer.viewport().size());
 
+    _benchmarkFrameCount = args.value<UnsignedInt>("benchmark");
+    _benchmarkOutput = args.value("benchmark-output");
+    _tiledRenderOutput = args.value("tiled-render");
+    _tiledRenderSize = args.value<Vector2i>("tiled-size");
+    _tileSize = args.value<Int>("tile-size");
+    _continuous = args.isSet("continuous");
+    _progressiveFrameCount = _benchmarkFrameCount || !_tiledRenderOutput.empty() ? 0 : args.value<UnsignedInt>("progressive");
+    if(_progressiveFrameCount)
+        _accumulator.reset(new FrameAccumulator{GL::defaultFramebuffer.viewport().size()});
+
     /* Base object, parent of all (for easy manipulation) */
     _manipulator.setParent(&_scene);
 
+    /* The culling hierarchy is built relative to the manipulator, so rotating
+       the scene doesn't need it to be updated */
+    if(!args.isSet("no-culling"))
+        _culler.reset(new FrustumCuller{_manipulator, _transforms});
+
+    /* Occlusion culling works only on what's left after frustum culling */
+    const std::string occlusion = args.value("occlusion");
+    if(occlusion != "none") {
+        if(!_culler)
+            Warning{} << "Occlusion culling needs frustum culling, ignoring --occlusion";
+        else if(occlusion == "cpu")
+            _occlusionCuller.reset(new OcclusionCuller{OcclusionCuller::Rasterizer::Cpu});
+        else if(occlusion == "gpu" && OcclusionCuller::isGpuRasterizerSupported())
+            _occlusionCuller.reset(new OcclusionCuller{OcclusionCuller::Rasterizer::Gpu});
+        else if(occlusion == "gpu") {
+            Warning{} << "GPU occlusion culling is not supported, rasterizing on the CPU";
+            _occlusionCuller.reset(new OcclusionCuller{OcclusionCuller::Rasterizer::Cpu});
+        } else Warning{} << "Unknown --occlusion value" << occlusion << Debug::nospace << ", ignoring";
+
+        if(_occlusionCuller) _culler->setOcclusionCuller(_occlusionCuller.get());
+    }
+
     /* Setup renderer and shader defaults */
     GL::Renderer::enable(GL::Renderer::Feature::DepthTest);
     GL::Renderer::enable(GL::Renderer::Feature::FaceCulling);
@@ -172,7 +510,99 @@ ViewerExample::ViewerExample(const Arguments& arguments):
     _wireShader.setWireframeColor(wfColor);
     _wireShader.setColor(wfpColor);
     _flatShader = Shaders::Flat3D{};
-    _flatShader.setColor(0xfffffff_rgbf);
+    _flatShader.setColor(flatColor);
+    _renderQueue.setSorted(!args.isSet("no-sorting"));
+
+    if(FrameUniforms::isSupported()) {
+        _frameUniforms.reset(new FrameUniforms);
+        _coloredSceneShader = SceneShader{};
+        _coloredSceneShader.setColor(flatColor);
+        _texturedSceneShader = SceneShader{SceneShader::Flag::Textured};
+        _texturedSceneShader
+            .setAmbientColor(blue)
+            .setSpecularColor(blue)
+            .setShininess(20.0f);
+        _renderQueue.setSceneShaders(&_coloredSceneShader, &_texturedSceneShader);
+    }
+
+    /* The depth of both passes is guaranteed to match only with the uniform
+       block shaders */
+    if(args.isSet("depth-prepass")) {
+        if(_frameUniforms) {
+            _depthShader = SceneShader{SceneShader::Flag::DepthOnly};
+            _renderQueue.setDepthPrepass(&_depthShader);
+            #ifndef MAGNUM_TARGET_GLES
+            _renderQueue.setSampleCounting(true);
+            #endif
+        } else Warning{} << "Depth pre-pass needs uniform buffers, ignoring --depth-prepass";
+    }
+
+    /* Texture arrays have all layers resident, so they can't be combined
+       with streaming */
+    bool textureArrays = args.isSet("texture-arrays");
+    if(textureArrays && args.value<UnsignedLong>("texture-budget")) {
+        Warning{} << "Texture arrays can't be streamed, ignoring --texture-arrays";
+        textureArrays = false;
+    }
+
+    if(args.isSet("multidraw")) {
+        if(MultiDrawRenderer::isSupported()) {
+            _multiDrawRenderer.reset(new MultiDrawRenderer{textureArrays});
+            _multiDrawRenderer->coloredShader()
+                .setColor(flatColor);
+            _multiDrawRenderer->texturedShader()
+                .setAmbientColor(blue)
+                .setSpecularColor(blue)
+                .setShininess(20.0f);
+        } else Warning{} << "Multi-draw-indirect is not supported, ignoring --multidraw";
+    }
+
+    if(!args.isSet("no-instancing") && !_multiDrawRenderer && InstanceRenderer::isSupported()) {
+        _instanceRenderer.reset(new InstanceRenderer{textureArrays});
+        _instanceRenderer->coloredShader()
+            .setColor(flatColor);
+        _instanceRenderer->texturedShader()
+            .setAmbientColor(blue)
+            .setSpecularColor(blue)
+            .setShininess(20.0f);
+    }
+
+    /* Only batched drawing can pick texture array layers */
+    if(textureArrays) {
+        if(_multiDrawRenderer || _instanceRenderer) {
+            (_multiDrawRenderer ? _multiDrawRenderer->textureArrayShader() : _instanceRenderer->textureArrayShader())
+                .setAmbientColor(blue)
+                .setSpecularColor(blue)
+                .setShininess(20.0f);
+        } else {
+            Warning{} << "Texture arrays need instancing or multi-draw, ignoring --texture-arrays";
+            textureArrays = false;
+        }
+    }
+
+    /* If requested, try to load the scene from a cache first. That skips the
+       importer altogether and uploads everything directly from a memory-mapped
+       file. If the cache doesn't exist yet or is out of date, the scene is
+       imported and the cache written after. */
+    const auto loadStart = std::chrono::steady_clock::now();
+    const std::string cacheFilename = args.value("file") + ".cache";
+    const UnsignedLong textureBudget = args.value<UnsignedLong>("texture-budget")*1024*1024;
+    /* The source is stamped before importing so the cache written below
+       gets invalidated if the file changes meanwhile */
+    SourceStamp source{};
+    if(args.isSet("cache")) {
+        source = sourceStamp(args.value("file"));
+        if((_sceneCache = SceneCache::open(cacheFilename, source))) {
+            loadCache(*_sceneCache, args.isSet("quantize"), textureBudget, textureArrays);
+
+            /* The texture streamer keeps uploading from the mapping later,
+               otherwise it's not needed anymore */
+            if(!_textureStreamer) _sceneCache = Containers::NullOpt;
+            Debug{} << "Loaded" << cacheFilename << "in"
+                << milliseconds(std::chrono::steady_clock::now() - loadStart) << "ms";
+            return;
+        }
+    }
 
     /* Load a scene importer plugin */
     PluginManager::Manager<Trade::AbstractImporter> manager;
@@ -184,41 +614,33 @@ ViewerExample::ViewerExample(const Arguments& arguments):
     if(!importer->openFile(args.value("file")))
         std::exit(4);
 
-    /* Load all textures. Textures that fail to load will be NullOpt. */
+    Containers::Optional<SceneCacheWriter> cacheWriter;
+    if(args.isSet("cache"))
+        cacheWriter.emplace(importer->mesh3DCount(), importer->textureCount());
+
+    /* Fetch texture properties and kick off decoding of their images on a
+       pool of worker threads. Meanwhile materials and meshes are loaded here
+       and the decoded images are uploaded once those are done. Textures that
+       fail to load will be NullOpt. */
     _textures = Containers::Array<Containers::Optional<GL::Texture2D>>{importer->textureCount()};
+    if(textureBudget)
+        _textureStreamer.reset(new TextureStreamer{importer->textureCount(), textureBudget});
+    if(textureArrays)
+        _textureArrays.reset(new TextureArrays{importer->textureCount()});
+    Containers::Array<Containers::Optional<Trade::TextureData>> textureData{importer->textureCount()};
+    std::vector<TextureDecoder::Job> textureJobs;
     for(UnsignedInt i = 0; i != importer->textureCount(); ++i) {
-
-        Containers::Optional<Trade::TextureData> textureData = importer->texture(i);
-        if(!textureData || textureData->type() != Trade::TextureData::Type::Texture2D) {
+        textureData[i] = importer->texture(i);
+        if(!textureData[i] || textureData[i]->type() != Trade::TextureData::Type::Texture2D) {
             Warning{} << "Cannot load texture properties, skipping";
             continue;
         }
 
-
-        Containers::Optional<Trade::ImageData2D> imageData = importer->image2D(textureData->image());
-        GL::TextureFormat format;
-        if(imageData && imageData->format() == PixelFormat::RGB8Unorm)
-            format = GL::TextureFormat::RGB8;
-        else if(imageData && imageData->format() == PixelFormat::RGBA8Unorm)
-            format = GL::TextureFormat::RGBA8;
-        else {
-            Warning{} << "Cannot load texture image, skipping";
-            continue;
-        }
-
-        /* Configure the texture */
-        GL::Texture2D texture;
-        texture
-            .setMagnificationFilter(textureData->magnificationFilter())
-            .setMinificationFilter(textureData->minificationFilter(), textureData->mipmapFilter())
-            .setWrapping(textureData->wrapping().xy())
-            .setStorage(Math::log2(imageData->size().max()) + 1, format, imageData->size())
-            .setSubImage(0, {}, *imageData)
-            .generateMipmap();
-
-        _textures[i] = std::move(texture);
+        textureJobs.push_back({i, textureData[i]->image()});
     }
 
+    TextureDecoder textureDecoder{args.value("importer"), args.value("file"), *importer, std::move(textureJobs), args.value<std::size_t>("decode-threads")};
+
     /* Load all materials. Materials that fail to load will be NullOpt. The
        data will be stored directly in objects later, so save them only
        temporarily. */
@@ -236,6 +658,24 @@ ViewerExample::ViewerExample(const Arguments& arguments):
 
     /* Load all meshes. Meshes that fail to load will be NullOpt. */
     _meshes = Containers::Array<Containers::Optional<GL::Mesh>>{importer->mesh3DCount()};
+    _meshBounds = Containers::Array<Range3D>{importer->mesh3DCount()};
+    _meshTransformations = Containers::Array<Matrix4>{Containers::ValueInit, importer->mesh3DCount()};
+    _meshLevels = Containers::Array<std::vector<MeshLevel>>{importer->mesh3DCount()};
+    if(_depthShader.id()) {
+        _depthMeshes = Containers::Array<Containers::Optional<GL::Mesh>>{importer->mesh3DCount()};
+        _renderQueue.setDepthMeshes(_depthMeshes);
+    }
+    const bool optimizeMeshes = args.isSet("optimize-meshes");
+    VertexCacheStatistics cacheBefore{}, cacheAfter{};
+    std::chrono::nanoseconds optimizeTime{};
+    const bool generateLevels = args.isSet("lods");
+    std::vector<UnsignedLong> levelTriangleCounts(MeshRecord::MaxLevelCount);
+    std::chrono::nanoseconds lodTime{};
+    const bool quantize = args.isSet("quantize");
+    UnsignedLong vertexCount = 0, texturedVertexCount = 0;
+    Deduplicator meshDeduplicator{importer->mesh3DCount()};
+    std::vector<UnsignedLong> meshSizes(importer->mesh3DCount());
+    UnsignedLong savedSize = 0;
     for(UnsignedInt i = 0; i != importer->mesh3DCount(); ++i) {
 
         Containers::Optional<Trade::MeshData3D> meshData = importer->mesh3D(i);
@@ -244,11 +684,168 @@ ViewerExample::ViewerExample(const Arguments& arguments):
             continue;
         }
 
-        /* Compile the mesh */
-        _meshes[i] = MeshTools::compile(*meshData);
+        /* If the same mesh was already uploaded, objects referencing this one
+           will use that instead */
+        const UnsignedInt original = meshDeduplicator.add(i, meshDigest(*meshData));
+        if(original != i) {
+            savedSize += meshSizes[original];
+            continue;
+        }
+
+        /* Optionally reorder the triangles and vertices for better vertex
+           cache, overdraw and vertex fetch efficiency */
+        if(optimizeMeshes && meshData->isIndexed()) {
+            const UnsignedInt vertexCount = meshData->positions(0).size();
+            cacheBefore += analyzeVertexCache(meshData->indices(), vertexCount);
+            const auto optimizeStart = std::chrono::steady_clock::now();
+            optimizeMesh(*meshData);
+            optimizeTime += std::chrono::steady_clock::now() - optimizeStart;
+            cacheAfter += analyzeVertexCache(meshData->indices(), vertexCount);
+        }
+
+        _meshBounds[i] = meshBounds(*meshData);
+        if(_multiDrawRenderer) _multiDrawRenderer->setMesh(i, *meshData);
+
+        /* Optionally append simplified levels of detail to the indices */
+        if(generateLevels && meshData->isIndexed()) {
+            const auto lodStart = std::chrono::steady_clock::now();
+            _meshLevels[i] = generateLods(*meshData, MeshRecord::MaxLevelCount);
+            lodTime += std::chrono::steady_clock::now() - lodStart;
+            for(std::size_t level = 0; level != _meshLevels[i].size(); ++level)
+                levelTriangleCounts[level] += _meshLevels[i][level].indexCount/3;
+        }
+
+        /* Compile the mesh, optionally with quantized vertices. With levels
+           of detail the index buffer contains all of them, draw just the
+           first by default. */
+        if(quantize) {
+            _meshes[i] = compileQuantized(*meshData, _meshBounds[i]);
+            _meshTransformations[i] = dequantizationMatrix(_meshBounds[i]);
+        } else _meshes[i] = MeshTools::compile(*meshData);
+        vertexCount += meshData->positions(0).size();
+        if(meshData->hasTextureCoords2D())
+            texturedVertexCount += meshData->positions(0).size();
+        if(!_meshLevels[i].empty()) _meshes[i]->setCount(_meshLevels[i][0].indexCount);
+
+        /* Positions for the depth pre-pass, in the same format and with the
+           same indices so the depth matches exactly */
+        if(_depthShader.id()) {
+            Containers::Array<char> indexData;
+            MeshIndexType indexType{};
+            UnsignedInt indexStart{}, indexEnd{};
+            if(meshData->isIndexed())
+                std::tie(indexData, indexType, indexStart, indexEnd) = MeshTools::compressIndices(meshData->indices());
+            _depthMeshes[i] = compilePositions(meshData->primitive(),
+                Containers::arrayView(meshData->positions(0).data(), meshData->positions(0).size()),
+                _meshBounds[i], quantize,
+                indexData, indexType, indexStart, indexEnd, _meshes[i]->count());
+        }
+
+        /* Keep the full-detail geometry of simple meshes on the CPU to
+           rasterize them as occluders */
+        if(_occlusionCuller && meshData->isIndexed()) {
+            const std::size_t indexCount = _meshLevels[i].empty() ? meshData->indices().size() : _meshLevels[i][0].indexCount;
+            if(indexCount/3 <= MaxOccluderTriangleCount)
+                _occlusionCuller->setOccluder(i, meshData->positions(0),
+                    {meshData->indices().begin(), meshData->indices().begin() + indexCount},
+                    *_meshes[i], _meshTransformations[i]);
+        }
+        meshSizes[i] = meshSize(*meshData, quantize);
+        if(cacheWriter) cacheWriter->setMesh(i, *meshData, _meshLevels[i]);
+    }
+    if(_multiDrawRenderer) _multiDrawRenderer->upload();
+    printVertexMemory(vertexCount, texturedVertexCount, quantize);
+    if(optimizeMeshes)
+        Debug{} << "Optimized meshes in" << milliseconds(optimizeTime)
+            << "ms, ACMR" << cacheBefore.acmr() << "->" << cacheAfter.acmr()
+            << Debug::nospace << ", ATVR" << cacheBefore.atvr() << "->"
+            << cacheAfter.atvr();
+    if(generateLevels) {
+        Debug d;
+        d << "Generated levels of detail in" << milliseconds(lodTime)
+            << "ms, triangle count per level:";
+        for(const UnsignedLong count: levelTriangleCounts) d << count;
+    }
+
+    /* Upload the textures as they get decoded, again skipping duplicates */
+    std::chrono::nanoseconds textureUploadTime{};
+    Deduplicator textureDeduplicator{importer->textureCount()};
+    UnsignedInt textureId;
+    Containers::Optional<Trade::ImageData2D> imageData;
+    while(textureDecoder.next(textureId, imageData)) {
+        const Trade::TextureData& texture = *textureData[textureId];
+        if(!imageData) {
+            Warning{} << "Cannot load texture image, skipping";
+            continue;
+        }
+
+        /* The images finish decoding in random order, so the copy that gets
+           uploaded is whichever comes first. Approximate the size including
+           the mip chain. */
+        if(textureDeduplicator.add(textureId, textureDigest(texture, *imageData)) != textureId) {
+            savedSize += imageData->data().size()*4/3;
+            continue;
+        }
+
+        const Containers::Optional<GL::TextureFormat> format = textureFormat(imageData->format());
+        if(!format) {
+            Warning{} << "Cannot load texture image, skipping";
+            continue;
+        }
+
+        /* Both the cache and the streamer need all mip levels on the CPU */
+        const auto uploadStart = std::chrono::steady_clock::now();
+        MipChain mipChain;
+        if(cacheWriter || _textureStreamer) {
+            mipChain = generateMipChain(*imageData);
+            if(cacheWriter) cacheWriter->setTexture(textureId, texture, mipChain.levels);
+        }
+
+        /* With streaming, only the coarse levels get uploaded now */
+        if(_textureStreamer) {
+            _textures[textureId].emplace(NoCreate);
+            _textureStreamer->setTexture(textureId, *_textures[textureId], texture.magnificationFilter(), texture.minificationFilter(), texture.mipmapFilter(), texture.wrapping().xy(), *format, std::move(mipChain.levels), std::move(mipChain.data));
+
+        /* With texture arrays, the image is only copied now and uploaded once
+           all are known */
+        } else if(_textureArrays) {
+            _textureArrays->add(textureId, texture.magnificationFilter(), texture.minificationFilter(), texture.mipmapFilter(), texture.wrapping().xy(), *format, *imageData);
+        } else _textures[textureId] = createTexture(texture.magnificationFilter(), texture.minificationFilter(), texture.mipmapFilter(), texture.wrapping().xy(), *imageData);
+        textureUploadTime += std::chrono::steady_clock::now() - uploadStart;
+    }
+    if(_textureArrays) {
+        const auto uploadStart = std::chrono::steady_clock::now();
+        _textureArrays->upload();
+        textureUploadTime += std::chrono::steady_clock::now() - uploadStart;
+    }
+
+    Debug{} << "Loaded the file in"
+        << milliseconds(std::chrono::steady_clock::now() - loadStart) << "ms,"
+        << importer->textureCount() << "textures took"
+        << milliseconds(textureDecoder.decodeTime()) << "ms to decode on"
+        << textureDecoder.threadCount() << "threads and"
+        << milliseconds(textureUploadTime) << "ms to upload";
+    if(meshDeduplicator.duplicateCount() || textureDeduplicator.duplicateCount())
+        Debug{} << "Found" << meshDeduplicator.duplicateCount() << "duplicate meshes and"
+            << textureDeduplicator.duplicateCount() << "duplicate textures, saving"
+            << savedSize/1024 << "kB of GPU memory";
+
+    /* Extract the subset of material properties the drawables need. Objects
+       referencing materials that failed to load get a default material. */
+    std::vector<MaterialRecord> materialRecords(materials.size(), MaterialRecord{{}, -1});
+    for(std::size_t i = 0; i != materials.size(); ++i) {
+        if(!materials[i]) continue;
+
+        if(materials[i]->flags() & Trade::PhongMaterialData::Flag::DiffuseTexture)
+            materialRecords[i].diffuseTexture = textureDeduplicator[materials[i]->diffuseTexture()];
+        else {
+            materialRecords[i].diffuseColor = materials[i]->diffuseColor();
+            materialRecords[i].diffuseTexture = -1;
+        }
     }
 
     /* Load the scene */
+    std::vector<ObjectRecord> objects;
     if(importer->defaultScene() != -1) {
 
         Containers::Optional<Trade::SceneData> sceneData = importer->scene(importer->defaultScene());
@@ -257,85 +854,536 @@ ViewerExample::ViewerExample(const Arguments& arguments):
             return;
         }
 
-        /* Recursively add all children */
-        for(UnsignedInt objectId: sceneData->children3D())
-            addObject(*importer, materials, _manipulator, objectId);
+        /* Add all objects in the hierarchy */
+        importObjects(*importer, materials, objects, sceneData->children3D());
 
     /* The format has no scene support, display just the first loaded mesh with
        a default material and be done with it */
     } else if(!_meshes.empty() && _meshes[0])
-        new ColoredDrawable{_manipulator, _flatShader, *_meshes[0], opaque, _drawables};
+        objects.push_back(ObjectRecord{Matrix4{}, -1, 0, -1});
+
+    /* Point objects referencing duplicate meshes to the uploaded copy. Objects
+       whose mesh failed to load are kept only for the hierarchy. */
+    for(ObjectRecord& object: objects) {
+        if(object.mesh == -1) continue;
+        object.mesh = meshDeduplicator[object.mesh];
+        if(!_meshes[object.mesh]) object.mesh = object.material = -1;
+    }
+
+    addObjects(Containers::arrayView(objects.data(), objects.size()),
+        Containers::arrayView(materialRecords.data(), materialRecords.size()));
+
+    /* Save everything for the next time */
+    if(cacheWriter) {
+        cacheWriter->setMaterials(std::move(materialRecords));
+        cacheWriter->setObjects(std::move(objects));
+        if(cacheWriter->write(cacheFilename, source))
+            Debug{} << "Scene cache saved to" << cacheFilename;
+    }
 }
 
-void ViewerExample::addObject(Trade::AbstractImporter& importer, Containers::ArrayView<const Containers::Optional<Trade::PhongMaterialData>> materials, Object3D& parent, UnsignedInt i) {
-    Containers::Pointer<Trade::ObjectData3D> objectData = importer.object3D(i);
-    if(!objectData) {
-        Error{} << "Cannot import object, skipping";
-        return;
+void ViewerExample::loadCache(const SceneCache& cache, const bool quantized, const UnsignedLong textureBudget, const bool textureArrays) {
+    _meshes = Containers::Array<Containers::Optional<GL::Mesh>>{cache.meshes().size()};
+    _meshBounds = Containers::Array<Range3D>{cache.meshes().size()};
+    _meshTransformations = Containers::Array<Matrix4>{Containers::ValueInit, cache.meshes().size()};
+    _meshLevels = Containers::Array<std::vector<MeshLevel>>{cache.meshes().size()};
+    if(_depthShader.id()) {
+        _depthMeshes = Containers::Array<Containers::Optional<GL::Mesh>>{cache.meshes().size()};
+        _renderQueue.setDepthMeshes(_depthMeshes);
+    }
+    UnsignedLong vertexCount = 0, texturedVertexCount = 0;
+    for(UnsignedInt i = 0; i != cache.meshes().size(); ++i) {
+        const MeshRecord& record = cache.meshes()[i];
+        _meshes[i] = cache.mesh(i, quantized);
+        if(_depthShader.id()) _depthMeshes[i] = cache.positionMesh(i, quantized);
+        _meshBounds[i] = record.bounds;
+        if(quantized) _meshTransformations[i] = dequantizationMatrix(record.bounds);
+        _meshLevels[i] = cache.levels(i);
+        vertexCount += record.vertexCount;
+        if(record.flags & MeshRecord::TextureCoordinates)
+            texturedVertexCount += record.vertexCount;
+        if(_occlusionCuller && _meshes[i] && record.indexCount) {
+            std::vector<UnsignedInt> indices = decompressIndices(cache.indexData(i), MeshIndexType(record.indexType));
+            if(indices.size()/3 <= MaxOccluderTriangleCount) {
+                const std::size_t stride = record.flags & MeshRecord::TextureCoordinates ? 32 : 24;
+                std::vector<Vector3> positions(record.vertexCount);
+                for(std::size_t j = 0; j != positions.size(); ++j)
+                    std::memcpy(&positions[j], cache.vertexData(i) + j*stride, sizeof(Vector3));
+                _occlusionCuller->setOccluder(i, std::move(positions), std::move(indices), *_meshes[i], _meshTransformations[i]);
+            }
+        }
+        if(_multiDrawRenderer && _meshes[i])
+            _multiDrawRenderer->setMesh(i, cache.vertexData(i),
+                cache.meshes()[i].flags & MeshRecord::TextureCoordinates,
+                cache.indexData(i), MeshIndexType(cache.meshes()[i].indexType));
+    }
+    if(_multiDrawRenderer) _multiDrawRenderer->upload();
+    printVertexMemory(vertexCount, texturedVertexCount, quantized);
+
+    /* When streaming, the levels are uploaded straight from the mapped file
+       as needed, so the finer ones don't even get paged in until then */
+    _textures = Containers::Array<Containers::Optional<GL::Texture2D>>{cache.textures().size()};
+    if(textureBudget)
+        _textureStreamer.reset(new TextureStreamer{UnsignedInt(cache.textures().size()), textureBudget});
+    if(textureArrays)
+        _textureArrays.reset(new TextureArrays{UnsignedInt(cache.textures().size())});
+    for(UnsignedInt i = 0; i != cache.textures().size(); ++i) {
+        const TextureRecord& texture = cache.textures()[i];
+        if(!texture.dataSize) continue;
+
+        const SamplerFilter magnificationFilter = SamplerFilter(texture.magnificationFilter);
+        const SamplerFilter minificationFilter = SamplerFilter(texture.minificationFilter);
+        const SamplerMipmap mipmapFilter = SamplerMipmap(texture.mipmapFilter);
+        const Array2D<SamplerWrapping> wrapping{SamplerWrapping(texture.wrapping[0]), SamplerWrapping(texture.wrapping[1])};
+        if(_textureStreamer) {
+            const Containers::Optional<GL::TextureFormat> format = textureFormat(PixelFormat(texture.format));
+            if(!format) continue;
+            _textures[i].emplace(NoCreate);
+            _textureStreamer->setTexture(i, *_textures[i], magnificationFilter, minificationFilter, mipmapFilter, wrapping, *format, cache.imageLevels(i));
+        } else if(_textureArrays) {
+            const Containers::Optional<GL::TextureFormat> format = textureFormat(PixelFormat(texture.format));
+            if(!format) continue;
+            _textureArrays->add(i, magnificationFilter, minificationFilter, mipmapFilter, wrapping, *format, cache.image(i));
+        } else _textures[i] = createTexture(magnificationFilter, minificationFilter, mipmapFilter, wrapping, cache.image(i));
     }
+    if(_textureArrays) _textureArrays->upload();
 
-    /* Add the object to the scene and set its transformation */
-    auto* object = new Object3D{&parent};
-    object->setTransformation(objectData->transformation());
+    addObjects(cache.objects(), cache.materials());
+}
+
+void ViewerExample::importObjects(Trade::AbstractImporter& importer, Containers::ArrayView<const Containers::Optional<Trade::PhongMaterialData>> materials, std::vector<ObjectRecord>& objects, const std::vector<UnsignedInt>& roots) {
+    /* Walk the hierarchy depth-first with an explicit stack of object IDs and
+       parent records, so deep hierarchies can't overflow the call stack.
+       Children are pushed in reverse to be visited in their original order,
+       which gives the same parent-first order as recursion would. */
+    std::vector<std::pair<UnsignedInt, Int>> stack;
+    for(auto it = roots.rbegin(); it != roots.rend(); ++it)
+        stack.emplace_back(*it, -1);
+    while(!stack.empty()) {
+        const UnsignedInt i = stack.back().first;
+        const Int parent = stack.back().second;
+        stack.pop_back();
+
+        Containers::Pointer<Trade::ObjectData3D> objectData = importer.object3D(i);
+        if(!objectData) {
+            Error{} << "Cannot import object, skipping";
+            continue;
+        }
+
+        ObjectRecord object{objectData->transformation(), parent, -1, -1};
+
+        /* Reference the mesh if the object has one. Whether it's loaded is
+           checked after, once duplicates are resolved. */
+        if(objectData->instanceType() == Trade::ObjectInstanceType3D::Mesh && objectData->instance() != -1) {
+            object.mesh = objectData->instance();
 
-    /* Add a drawable if the object has a mesh and the mesh is loaded */
-    if(objectData->instanceType() == Trade::ObjectInstanceType3D::Mesh && objectData->instance() != -1 && _meshes[objectData->instance()]) {
-        const Int materialId = static_cast<Trade::MeshObjectData3D*>(objectData.get())->material();
+            /* Material not available / not loaded, keep the default */
+            const Int materialId = static_cast<Trade::MeshObjectData3D*>(objectData.get())->material();
+            if(materialId != -1 && materials[materialId])
+                object.material = materialId;
+        }
+
+        const Int id = objects.size();
+        objects.push_back(object);
+
+        const std::vector<UnsignedInt>& children = objectData->children();
+        for(auto it = children.rbegin(); it != children.rend(); ++it)
+            stack.emplace_back(*it, id);
+    }
+}
+
+void ViewerExample::addObjects(Containers::ArrayView<const ObjectRecord> objects, Containers::ArrayView<const MaterialRecord> materials) {
+    /* Texture used by given object, -1 if it's flat-colored */
+    auto textureId = [&](const ObjectRecord& record) -> Int {
+        if(record.material == -1) return -1;
+        const Int id = materials[record.material].diffuseTexture;
+        return id != -1 && (_textures[id] || (_textureArrays && _textureArrays->array(id))) ? id : -1;
+    };
+
+    /* Color-only materials with alpha less than one are drawn blended. These
+       need to be sorted back-to-front, so they're never instanced. */
+    auto translucent = [&](const ObjectRecord& record) {
+        return record.material != -1 &&
+            materials[record.material].diffuseTexture == -1 &&
+            materials[record.material].diffuseColor.a() < 1.0f;
+    };
+
+    /* Instancing and multi-draw don't know about the on-screen size of each
+       object, so with texture streaming the textured objects are drawn
+       separately to request their mip levels */
+    auto batchable = [&](const ObjectRecord& record) {
+        return !translucent(record) && !(_textureStreamer && textureId(record) != -1);
+    };
+
+    /* Count how many times is each mesh used with each texture to know which
+       objects are worth drawing instanced */
+    std::map<std::pair<Int, Int>, UnsignedInt> useCount;
+    if(_instanceRenderer) for(const ObjectRecord& record: objects)
+        if(record.mesh != -1 && batchable(record))
+            ++useCount[{record.mesh, textureId(record)}];
+
+    /* The objects come from a single pool instead of being allocated one by
+       one. They only hold the drawables --- the hierarchy and transformations
+       live solely in the transformation cache, so the objects are all
+       directly under the manipulator with an identity transformation. Moving
+       an object means calling TransformCache::setTransformation() on its
+       node, there's nothing in the scene graph to keep in sync. */
+    _objects = Containers::Array<Object3D>{objects.size()};
+
+    /* Parents are always before children, so the cache nodes can be added in
+       a single ordered pass */
+    std::vector<UnsignedInt> transforms(objects.size());
+    std::size_t instancedCount = 0;
+    _drawableList.reserve(objects.size());
+    _drawableTransforms.reserve(objects.size());
+    for(std::size_t i = 0; i != objects.size(); ++i) {
+        const ObjectRecord& record = objects[i];
+
+        /* Add the object to the scene and its transformation to the cache */
+        Object3D* object = &_objects[i];
+        object->setParent(&_manipulator);
+        transforms[i] = _transforms.add(record.parent == -1 ? -1 : Int(transforms[record.parent]), record.transformation);
+
+        /* Add a drawable if the object has a mesh */
+        if(record.mesh == -1) continue;
+        GL::Mesh& mesh = *_meshes[record.mesh];
+        const Int texture = textureId(record);
+        const MeshLod lod{Containers::arrayView(_meshLevels[record.mesh].data(), _meshLevels[record.mesh].size()), _meshBounds[record.mesh]};
+        GL::Texture2D* const texture2D = texture != -1 && _textures[texture] ? &*_textures[texture] : nullptr;
+        GL::Texture2DArray* const textureArray = texture != -1 && _textureArrays ? _textureArrays->array(texture) : nullptr;
+        const UnsignedInt textureLayer = textureArray ? _textureArrays->layer(texture) : 0;
+
+        /* All opaque objects are drawn with multi-draw if enabled */
+        SceneGraph::Drawable3D* drawable;
+        if(_multiDrawRenderer && batchable(record)) {
+            drawable = new MultiDrawDrawable{*object, *_multiDrawRenderer, UnsignedInt(record.mesh), texture2D, textureArray, textureLayer, _instancedDrawables};
+            ++instancedCount;
+
+        /* Mesh used more than once with the same texture, add it to an
+           instanced batch. Textures packed into arrays are batched always,
+           both as they're likely to share the batch with other layers of the
+           array and because there's no standalone texture to draw with. */
+        } else if(_instanceRenderer && batchable(record) && (textureArray || useCount[{record.mesh, texture}] > 1)) {
+            drawable = new InstancedDrawable{*object, textureArray ? _instanceRenderer->batch(mesh, *textureArray) : _instanceRenderer->batch(mesh, texture2D), _meshTransformations[record.mesh], textureLayer, _instancedDrawables};
+            ++instancedCount;
 
         /* Material not available / not loaded, use a default material */
-        if(materialId == -1 || !materials[materialId]) {
-            new ColoredDrawable{*object, _flatShader, *_meshes[objectData->instance()], opaque, _drawables};
+        } else if(record.material == -1) {
+            drawable = new ColoredDrawable{*object, _renderQueue, UnsignedInt(record.mesh), mesh, _meshTransformations[record.mesh], lod, flatColor, _drawables};
 
         /* Textured material. If the texture failed to load, again just use a
            default colored material. */
-        } else if(materials[materialId]->flags() & Trade::PhongMaterialData::Flag::DiffuseTexture) {
-            Containers::Optional<GL::Texture2D>& texture = _textures[materials[materialId]->diffuseTexture()];
-            if(texture)
-                new TexturedDrawable{*object, _texturedShader, *_meshes[objectData->instance()], *texture, _drawables};
+        } else if(materials[record.material].diffuseTexture != -1) {
+            if(texture2D)
+                drawable = new TexturedDrawable{*object, _renderQueue, UnsignedInt(record.mesh), mesh, _meshTransformations[record.mesh], lod, UnsignedInt(texture), *_textures[texture], _textureStreamer.get(), _drawables};
             else
-                new ColoredDrawable{*object, _flatShader, *_meshes[objectData->instance()], opaque, _drawables};
+                drawable = new ColoredDrawable{*object, _renderQueue, UnsignedInt(record.mesh), mesh, _meshTransformations[record.mesh], lod, flatColor, _drawables};
 
-        /* Color-only material */
+        /* Color-only material. Opaque ones keep the flat color, translucent
+           ones use the material color so the alpha gets blended. */
         } else {
-            new ColoredDrawable{*object, _flatShader, *_meshes[objectData->instance()], materials[materialId]->diffuseColor(), _drawables};
+            drawable = new ColoredDrawable{*object, _renderQueue, UnsignedInt(record.mesh), mesh, _meshTransformations[record.mesh], lod, translucent(record) ? materials[record.material].diffuseColor : flatColor, _drawables};
         }
+
+        _drawableList.push_back(drawable);
+        _drawableTransforms.push_back(transforms[i]);
+        if(_culler) _culler->add(*drawable, transforms[i], _meshBounds[record.mesh],
+            _occlusionCuller && _occlusionCuller->isOccluder(record.mesh) ? record.mesh : -1);
     }
 
-    /* Recursively add children */
-    for(std::size_t id: objectData->children())
-        addObject(importer, materials, *object, id);
+    _transforms.update();
+    if(_culler) _culler->build();
+
+    if(_multiDrawRenderer)
+        Debug{} << "Drawing" << instancedCount << "objects with multi-draw-indirect and"
+            << _drawables.size() << "objects separately";
+    else if(_instanceRenderer)
+        Debug{} << "Drawing" << instancedCount << "objects in"
+            << _instanceRenderer->batchCount() << "instanced batches and"
+            << _drawables.size() << "objects separately";
 }
 
 void ColoredDrawable::draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D& camera) {
-    _shader
-        .setTransformationProjectionMatrix(camera.projectionMatrix()*transformationMatrix);
-
-    _mesh.draw(_shader);
+    _queue.addColored(transformationMatrix*_meshTransformation, transformationMatrix.rotationScaling(), _meshId, _mesh, _lod.select(transformationMatrix, camera), _color);
 }
 
 void TexturedDrawable::draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D& camera) {
-    _shader
-        .setLightPosition(camera.cameraMatrix().transformPoint({-100.0f, 100.0f, 100.0f}))
-        .setTransformationMatrix(transformationMatrix)
-        .setNormalMatrix(transformationMatrix.rotationScaling())
-        .setProjectionMatrix(camera.projectionMatrix())
-        .bindDiffuseTexture(_texture);
-
-    _mesh.draw(_shader);
+    if(_streamer) _streamer->request(_textureId, _lod.projectedSize(transformationMatrix, camera));
+    _queue.addTextured(transformationMatrix*_meshTransformation, transformationMatrix.rotationScaling(), _meshId, _mesh, _lod.select(transformationMatrix, camera), _textureId, _texture);
+}
+
+void ViewerExample::markDirty() {
+    if(_accumulator) _accumulator->reset();
+    redraw();
+}
+
+void ViewerExample::render(GL::AbstractFramebuffer& framebuffer) {
+    framebuffer.clear(GL::FramebufferClear::Color|GL::FramebufferClear::Depth);
+
+    /* When accumulating, shift the projection by the sub-pixel offset. The
+       camera scales the projection to fix the aspect ratio after, so
+       compensate for that. */
+    if(_accumulator) {
+        const Vector2 aspectRatioScale{
+            _camera->projectionMatrix()[0][0]/_projectionMatrix[0][0],
+            _camera->projectionMatrix()[1][1]/_projectionMatrix[1][1]};
+        const Vector2 offset = _accumulator->jitter()*2.0f/Vector2{framebuffer.viewport().size()}/aspectRatioScale;
+        _camera->setProjectionMatrix(Matrix4::translation({offset, 0.0f})*_projectionMatrix);
+    }
+
+    /* Drawing the drawables only collects the transformations, the instance
+       renderer then submits them in one draw call per batch and the render
+       queue sorts the rest by GL state. The culler handles both kinds, so
+       only the visible ones end up being drawn. The transformations come from
+       the cache, which recalculates only subtrees of nodes changed through
+       TransformCache::setTransformation() since the last frame. Rotating the
+       manipulator doesn't make anything dirty. */
+    _transforms.update();
+    if(_culler) _culler->draw(*_camera);
+    else {
+        _drawableTransformations.resize(_drawableList.size());
+        _transforms.transformations(_camera->cameraMatrix()*_manipulator.absoluteTransformationMatrix(),
+            Containers::arrayView(_drawableTransforms.data(), _drawableTransforms.size()),
+            Containers::arrayView(_drawableTransformations.data(), _drawableTransformations.size()));
+        for(std::size_t i = 0; i != _drawableList.size(); ++i)
+            _drawableList[i]->draw(_drawableTransformations[i], *_camera);
+    }
+
+    /* Instanced batches and multi-draws are all opaque, so they go first. The
+       queue then draws blended objects last. The occlusion culler may have
+       bound its own framebuffer, so bind the target again. */
+    framebuffer.bind();
+    const Vector3 lightPosition = _camera->cameraMatrix().transformPoint(LightPosition);
+    if(_frameUniforms) _frameUniforms->update(_camera->projectionMatrix(), lightPosition);
+    if(_instanceRenderer) _instanceRenderer->draw();
+    if(_multiDrawRenderer) _multiDrawRenderer->draw();
+    _renderQueue.draw(*_camera, lightPosition);
 }
 
 void ViewerExample::drawEvent() {
-    GL::defaultFramebuffer.clear(GL::FramebufferClear::Color|GL::FramebufferClear::Depth);
+    /* In the benchmark mode, render all frames offscreen at once and quit */
+    if(_benchmarkFrameCount) {
+        benchmark();
+        exit();
+        return;
+    }
+    if(!_tiledRenderOutput.empty()) {
+        renderTiled();
+        exit();
+        return;
+    }
 
-    _camera->draw(_drawables);
+    render(GL::defaultFramebuffer);
+    if(_accumulator) _accumulator->accumulate();
+
+    /* Stream in the texture levels requested by the drawables, which will be
+       visible in the next frame */
+    const bool texturesChanged = _textureStreamer && _textureStreamer->update();
+
+    /* Update the statistics only when they change to avoid setting the window
+       title every frame */
+    std::string title = Utility::formatString("Magnum Viewer Example — {} program, {} texture, {} mesh switches",
+        _renderQueue.programSwitches(),
+        _renderQueue.textureSwitches(),
+        _renderQueue.meshSwitches());
+    if(_multiDrawRenderer) Utility::formatInto(title, title.size(), ", {} multi-draws of {} meshes",
+        _multiDrawRenderer->drawCallCount(), _multiDrawRenderer->commandCount());
+    if(_culler) Utility::formatInto(title, title.size(), ", {} visible, {} culled",
+        _culler->visibleCount(), _culler->culledCount());
+    if(_occlusionCuller) Utility::formatInto(title, title.size(), ", {} occluded by {} occluders",
+        _culler->occludedCount(), _occlusionCuller->occluderCount());
+    Utility::formatInto(title, title.size(), ", {} kB of uniforms",
+        uniformUploadSize()/1024);
+    if(_depthShader.id()) {
+        Utility::formatInto(title, title.size(), ", depth pre-pass {}",
+            _renderQueue.depthPrepass() ? "on" : "off");
+        #ifndef MAGNUM_TARGET_GLES
+        Utility::formatInto(title, title.size(), ", {}k samples shaded",
+            _renderQueue.shadedSampleCount()/1000);
+        #endif
+    }
+    if(_textureStreamer) Utility::formatInto(title, title.size(), ", {} of {} MB textures resident",
+        _textureStreamer->residentSize()/(1024*1024), _textureStreamer->budget()/(1024*1024));
+    if(title != _title) {
+        _title = std::move(title);
+        setWindowTitle(_title);
+    }
 
     swapBuffers();
-    redraw();
+
+    /* Nothing changed since, draw again only to refine the image */
+    if(texturesChanged) markDirty();
+    else if(_continuous || (_accumulator && _accumulator->frameCount() < _progressiveFrameCount))
+        redraw();
+}
+
+UnsignedLong ViewerExample::uniformUploadSize() const {
+    return _renderQueue.uniformUploadSize() +
+        (_frameUniforms ? _frameUniforms->uploadSize() : 0);
+}
+
+void ViewerExample::benchmark() {
+    /* Render offscreen at the window size, the default framebuffer may not
+       even exist */
+    const Vector2i size = framebufferSize();
+    OffscreenFramebuffer target{size};
+    _camera->setViewport(size);
+
+    /* GPU time and primitive count queries are desktop-only */
+    #ifndef MAGNUM_TARGET_GLES
+    GL::TimeQuery timeQuery{GL::TimeQuery::Target::TimeElapsed};
+    GL::PrimitiveQuery primitiveQuery{GL::PrimitiveQuery::Target::PrimitivesGenerated};
+    _renderQueue.setSampleCounting(true);
+    #endif
+
+    /* Orbit once around the scene center at the initial camera distance */
+    const Matrix4 cameraTransformation = _cameraObject.transformationMatrix();
+    std::string frames;
+    Double cpuTimeSum = 0.0, gpuTimeSum = 0.0;
+    for(UnsignedInt i = 0; i != _benchmarkFrameCount; ++i) {
+        _cameraObject.setTransformation(Matrix4::rotationY(Deg(360.0f*i/_benchmarkFrameCount))*cameraTransformation);
+
+        #ifndef MAGNUM_TARGET_GLES
+        timeQuery.begin();
+        primitiveQuery.begin();
+        #endif
+        const auto start = std::chrono::steady_clock::now();
+        render(target.framebuffer);
+        if(_textureStreamer) _textureStreamer->update();
+        const Double cpuTime = milliseconds(std::chrono::steady_clock::now() - start);
+        #ifndef MAGNUM_TARGET_GLES
+        timeQuery.end();
+        primitiveQuery.end();
+        const Double gpuTime = milliseconds(std::chrono::nanoseconds{timeQuery.result<UnsignedLong>()});
+        const std::string triangles = std::to_string(primitiveQuery.result<UnsignedInt>());
+        const std::string shadedSamples = std::to_string(_renderQueue.shadedSampleCount());
+        #else
+        const Double gpuTime = 0.0;
+        const std::string triangles = "null";
+        const std::string shadedSamples = "null";
+        #endif
+
+        const UnsignedInt drawCalls = _renderQueue.drawCallCount() +
+            (_instanceRenderer ? _instanceRenderer->drawCallCount() : 0) +
+            (_multiDrawRenderer ? _multiDrawRenderer->drawCallCount() : 0);
+        Utility::formatInto(frames, frames.size(), "{}\n    {{\"cpuTime\": {}, \"gpuTime\": {}, \"drawCalls\": {}, \"triangles\": {}, \"uniformBytes\": {}, \"shadedSamples\": {}}}",
+            i ? "," : "", cpuTime, gpuTime, drawCalls, triangles, uniformUploadSize(), shadedSamples);
+        cpuTimeSum += cpuTime;
+        gpuTimeSum += gpuTime;
+    }
+
+    /* Times are in milliseconds, GPU time is zero if not available */
+    std::ofstream out{_benchmarkOutput};
+    out << Utility::formatString("{{\n  \"frameCount\": {},\n  \"size\": [{}, {}],\n  \"averageCpuTime\": {},\n  \"averageGpuTime\": {},\n  \"frames\": [{}\n  ]\n}}\n",
+        _benchmarkFrameCount, size.x(), size.y(),
+        cpuTimeSum/_benchmarkFrameCount, gpuTimeSum/_benchmarkFrameCount,
+        frames);
+    if(!out) Error{} << "Cannot write benchmark results to" << _benchmarkOutput;
+    else Debug{} << "Rendered" << _benchmarkFrameCount << "frames in"
+        << cpuTimeSum << "ms of CPU time, results written to" << _benchmarkOutput;
+}
+
+void ViewerExample::renderTiled() {
+    const Vector2i size = _tiledRenderSize;
+    const Vector2i tileSize = Math::min(Math::min(Vector2i{_tileSize}, Vector2i{GL::Renderbuffer::maxSize()}), GL::AbstractFramebuffer::maxViewportSize());
+    OffscreenFramebuffer target{tileSize};
+
+    PngWriter png{_tiledRenderOutput, size, 3};
+    if(!png.isGood()) {
+        Error{} << "Cannot open" << _tiledRenderOutput << "for writing";
+        return;
+    }
+
+    /* Projection of the whole image, with the aspect ratio corrected by the
+       camera. Each tile then takes a sub-rectangle of it. */
+    _camera->setViewport(size);
+    const Matrix4 projection = _camera->projectionMatrix();
+    _camera->setAspectRatioPolicy(SceneGraph::AspectRatioPolicy::NotPreserved);
+    _camera->setViewport(tileSize);
+
+    /* Rows of one strip of tiles are collected while the previous strip is
+       being written on another thread, so only two strips are in memory at
+       a time */
+    const std::size_t rowSize = size.x()*3;
+    Containers::Array<char> strips[]{
+        Containers::Array<char>{Containers::NoInit, rowSize*tileSize.y()},
+        Containers::Array<char>{Containers::NoInit, rowSize*tileSize.y()}};
+    std::future<void> writing;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::size_t tileCount = 0;
+    for(Int top = 0, strip = 0; top < size.y(); top += tileSize.y(), ++strip) {
+        const Int height = Math::min(tileSize.y(), size.y() - top);
+        Containers::Array<char>& rows = strips[strip % 2];
+
+        for(Int left = 0; left < size.x(); left += tileSize.x()) {
+            const Int width = Math::min(tileSize.x(), size.x() - left);
+
+            /* Range of the tile in NDC, the image top is at Y = 1. Tiles at
+               the right and bottom edge are rendered whole and cropped. */
+            const Vector2 min{2.0f*left/size.x() - 1.0f,
+                              1.0f - 2.0f*(top + tileSize.y())/size.y()};
+            const Vector2 max = min + 2.0f*Vector2{tileSize}/Vector2{size};
+            _camera->setProjectionMatrix(
+                Matrix4::scaling({2.0f/(max - min), 1.0f})*
+                Matrix4::translation({-(min + max)*0.5f, 0.0f})*projection);
+
+            /* Let the texture streamer bring in the levels this tile needs */
+            render(target.framebuffer);
+            for(UnsignedInt i = 0; i != MaxTileRefinements && _textureStreamer && _textureStreamer->update(); ++i)
+                render(target.framebuffer);
+
+            /* Flip the rows, as GL has the origin at the bottom, and drop
+               the alpha */
+            Image2D image = target.framebuffer.read({{0, tileSize.y() - height}, {width, tileSize.y()}}, {PixelFormat::RGBA8Unorm});
+            const auto pixels = Containers::arrayCast<const Color4ub>(image.data());
+            for(Int y = 0; y != height; ++y) {
+                char* out = rows + (height - y - 1)*rowSize + left*3;
+                for(Int x = 0; x != width; ++x) {
+                    const Color4ub& pixel = pixels[y*width + x];
+                    out[x*3 + 0] = pixel.r();
+                    out[x*3 + 1] = pixel.g();
+                    out[x*3 + 2] = pixel.b();
+                }
+            }
+
+            ++tileCount;
+        }
+
+        /* Wait until the previous strip is written and hand over this one */
+        if(writing.valid()) writing.get();
+        writing = std::async(std::launch::async, [&png, &rows, rowSize, height] {
+            png.writeRows(rows.prefix(rowSize*height));
+        });
+    }
+    if(writing.valid()) writing.get();
+
+    _camera->setAspectRatioPolicy(SceneGraph::AspectRatioPolicy::Extend);
+    _camera->setProjectionMatrix(_projectionMatrix);
+    _camera->setViewport(framebufferSize());
+
+    if(!png.finish()) Error{} << "Cannot write" << _tiledRenderOutput;
+    else Debug{} << "Rendered a" << Utility::formatString("{}x{}", size.x(), size.y()) << "image in"
+        << tileCount << "tiles in"
+        << milliseconds(std::chrono::steady_clock::now() - start)
+        << "ms, written to" << _tiledRenderOutput;
 }
 
 void ViewerExample::viewportEvent(ViewportEvent& event) {
     GL::defaultFramebuffer.setViewport({{}, event.framebufferSize()});
     _camera->setViewport(event.windowSize());
+    if(_accumulator) _accumulator->setSize(event.framebufferSize());
+    markDirty();
+}
+
+void ViewerExample::keyPressEvent(KeyEvent& event) {
+    /* Toggle the depth pre-pass to compare the shaded sample counts */
+    if(event.key() == KeyEvent::Key::P && _depthShader.id()) {
+        _renderQueue.setDepthPrepass(_renderQueue.depthPrepass() ? nullptr : &_depthShader);
+        markDirty();
+    } else return;
+
+    event.setAccepted();
 }
 
 void ViewerExample::mousePressEvent(MouseEvent& event) {
@@ -358,7 +1406,7 @@ void ViewerExample::mouseScrollEvent(MouseScrollEvent& event) {
     _cameraObject.translate(Vector3::zAxis(
         distance*(1.0f - (event.offset().y() > 0 ? 1/0.85f : 0.85f))));
 
-    redraw();
+    markDirty();
 }
 
 Vector3 ViewerExample::positionOnSphere(const Vector2i& position) const {
@@ -379,7 +1427,7 @@ void ViewerExample::mouseMoveEvent(MouseMoveEvent& event) {
     _manipulator.rotate(Math::angle(_previousPosition, currentPosition), axis.normalized());
     _previousPosition = currentPosition;
 
-    redraw();
+    markDirty();
 }
 
 }}